@@ -309,6 +309,129 @@ void Pt_MCalendar::benchmarkFormatDateTime()
     }
 }
 
+void Pt_MCalendar::benchmarkFormatDateTimeAllStyles()
+{
+    // switching between the date and time styles looks up a
+    // different cached formatter on every call
+    MLocale locale("fi_FI");
+    MCalendar::setSystemTimeZone("Europe/Helsinki");
+    MCalendar calendar;
+    calendar.setDateTime(QDateTime(QDate(2010, 7, 13),
+                                   QTime(14, 51, 07, 0),
+                                   Qt::LocalTime));
+
+    QBENCHMARK {
+        for (int dateType = MLocale::DateNone; dateType <= MLocale::DateFull; ++dateType) {
+            for (int timeType = MLocale::TimeNone; timeType <= MLocale::TimeFull; ++timeType) {
+                locale.formatDateTime(calendar,
+                                      static_cast<MLocale::DateType>(dateType),
+                                      static_cast<MLocale::TimeType>(timeType));
+            }
+        }
+    }
+}
+
+void Pt_MCalendar::benchmarkFormatDateTimeQDateTime()
+{
+    MLocale locale("fi_FI");
+    MCalendar::setSystemTimeZone("Europe/Helsinki");
+    QDateTime dateTime(QDate(2010, 7, 13), QTime(14, 51, 07, 0), Qt::LocalTime);
+
+    QBENCHMARK {
+        locale.formatDateTime(dateTime, MLocale::DateShort, MLocale::TimeShort);
+    }
+}
+
+void Pt_MCalendar::benchmarkFormatDateTimeMSecsSinceEpoch()
+{
+    MLocale locale("fi_FI");
+    MCalendar::setSystemTimeZone("Europe/Helsinki");
+    const qint64 msecsSinceEpoch
+        = QDateTime(QDate(2010, 7, 13), QTime(11, 51, 07, 0), Qt::UTC).toMSecsSinceEpoch();
+
+    QCOMPARE(locale.formatDateTime(msecsSinceEpoch, MLocale::DateShort, MLocale::TimeShort),
+             locale.formatDateTime(QDateTime(QDate(2010, 7, 13), QTime(14, 51, 07, 0), Qt::LocalTime),
+                                   MLocale::DateShort, MLocale::TimeShort));
+
+    QBENCHMARK {
+        locale.formatDateTime(msecsSinceEpoch, MLocale::DateShort, MLocale::TimeShort);
+    }
+}
+
+void Pt_MCalendar::benchmarkFormatDateTimes()
+{
+    MLocale locale("fi_FI");
+    MCalendar::setSystemTimeZone("Europe/Helsinki");
+    // one time stamp per minute
+    QVector<qint64> msecsSinceEpoch;
+    const qint64 start
+        = QDateTime(QDate(2010, 7, 13), QTime(11, 51, 07, 0), Qt::UTC).toMSecsSinceEpoch();
+    for (int i = 0; i < 1000; ++i)
+        msecsSinceEpoch << start + i * 60000;
+    QVector<int> offsets;
+
+    QBENCHMARK {
+        locale.formatDateTimes(msecsSinceEpoch, &offsets,
+                               MLocale::DateShort, MLocale::TimeShort);
+    }
+}
+
+void Pt_MCalendar::benchmarkParseDateTime()
+{
+    MLocale locale("fi_FI");
+    MCalendar::setSystemTimeZone("Europe/Helsinki");
+    QDateTime dateTime(QDate(2010, 7, 13), QTime(14, 51, 0, 0), Qt::LocalTime);
+    QString text = locale.formatDateTime(dateTime, MLocale::DateShort, MLocale::TimeNone);
+
+    QBENCHMARK {
+        // try the styles one after another like an importer would
+        if (!locale.parseDateTime(text, MLocale::DateShort, MLocale::TimeShort).isValid())
+            locale.parseDateTime(text, MLocale::DateShort, MLocale::TimeNone);
+    }
+}
+
+void Pt_MCalendar::benchmarkDateTimeParser()
+{
+    MLocale locale("fi_FI");
+    MCalendar::setSystemTimeZone("Europe/Helsinki");
+    QDateTime dateTime(QDate(2010, 7, 13), QTime(14, 51, 0, 0), Qt::LocalTime);
+    QString text = locale.formatDateTime(dateTime, MLocale::DateShort, MLocale::TimeNone);
+    MDateTimeParser parser = locale.dateTimeParser();
+    parser.addStyle(MLocale::DateShort, MLocale::TimeShort);
+    parser.addStyle(MLocale::DateShort, MLocale::TimeNone);
+
+    QCOMPARE(parser.parse(text).date(), dateTime.date());
+
+    QBENCHMARK {
+        parser.parse(text);
+    }
+}
+
+void Pt_MCalendar::benchmarkMonthName()
+{
+    MLocale locale("fi_FI");
+    MCalendar calendar(locale);
+
+    QCOMPARE(locale.monthName(calendar, 7), QString("Heinäkuu"));
+
+    QBENCHMARK {
+        for (int month = 1; month <= 12; ++month)
+            locale.monthName(calendar, month);
+    }
+}
+
+void Pt_MCalendar::benchmarkMonthNames()
+{
+    MLocale locale("fi_FI");
+    MCalendar calendar(locale);
+
+    QCOMPARE(locale.monthNames(calendar).value(6), QString("Heinäkuu"));
+
+    QBENCHMARK {
+        locale.monthNames(calendar);
+    }
+}
+
 void Pt_MCalendar::benchmarkFormatDateTimeICU()
 {
     QString language("en_US");   // will be overridden
@@ -334,5 +457,32 @@ void Pt_MCalendar::benchmarkFormatDateTimeICU()
     }
 }
 
+void Pt_MCalendar::benchmarkFormatDateTimeICUShortDate()
+{
+    // short patterns are cheap to format, what dominates here is
+    // the handling of the locale options before the cache lookup
+    QString language("en_US");   // will be overridden
+    QString lcMessages("en_US"); // should not matter
+    QString lcTime("fi_FI@mix-time-and-language=no"); // this overrides language
+    QString lcNumeric("en_US");  // should not matter
+    QString formatString("d.M.y");
+    QString formattedResult("13.7.2010");
+    MLocale locale(language);
+    locale.setCategoryLocale(MLocale::MLcMessages, lcMessages);
+    locale.setCategoryLocale(MLocale::MLcTime, lcTime);
+    locale.setCategoryLocale(MLocale::MLcNumeric, lcNumeric);
+    MCalendar::setSystemTimeZone("Europe/Helsinki");
+    MCalendar calendar;
+    calendar.setDateTime(QDateTime(QDate(2010, 7, 13),
+                                   QTime(14, 51, 07, 0),
+                                   Qt::LocalTime));
+
+    QCOMPARE(locale.formatDateTimeICU(calendar, formatString), formattedResult);
+
+    QBENCHMARK {
+        locale.formatDateTimeICU(calendar, formatString);
+    }
+}
+
 QTEST_GUILESS_MAIN(Pt_MCalendar);
 
@@ -25,6 +25,7 @@
 #include <QObject>
 #include <MLocale>
 #include <MCalendar>
+#include <MDateTimeParser>
 
 class Pt_MCalendar : public QObject
 {
@@ -47,7 +48,16 @@ private slots:
     void benchmarkFormatDateTimePosixFormatString_t_MCalendar();
     void benchmarkIcuFormatString();
     void benchmarkFormatDateTime();
+    void benchmarkFormatDateTimeAllStyles();
+    void benchmarkFormatDateTimeQDateTime();
+    void benchmarkFormatDateTimeMSecsSinceEpoch();
+    void benchmarkFormatDateTimes();
+    void benchmarkParseDateTime();
+    void benchmarkDateTimeParser();
+    void benchmarkMonthName();
+    void benchmarkMonthNames();
     void benchmarkFormatDateTimeICU();
+    void benchmarkFormatDateTimeICUShortDate();
 };
 
 #endif
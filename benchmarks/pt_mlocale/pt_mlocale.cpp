@@ -241,6 +241,78 @@ void Pt_MLocale::benchmarkFormatNumberDoubleWestern()
 }
 #endif
 
+#ifdef HAVE_ICU
+void Pt_MLocale::benchmarkFormatNumberDoublePrecisionWestern()
+{
+    QString localeName("de_CH");
+    QString localeNameLcNumeric("de_CH");
+    double number = double(-1234567.1234567);
+    QString formatted("-1'234'567.12");
+    MLocale locale(localeName);
+    locale.setCategoryLocale(MLocale::MLcNumeric, localeNameLcNumeric);
+    QCOMPARE(locale.formatNumber(number, 2, 2), formatted);
+    QBENCHMARK {
+        locale.formatNumber(number, 2, 2);
+    }
+}
+#endif
+
+#ifdef HAVE_ICU
+void Pt_MLocale::benchmarkFormatNumbersQLongLongWestern()
+{
+    MLocale locale("de_CH");
+    QVector<qlonglong> numbers;
+    for (int i = 0; i < 10000; ++i)
+        numbers << qlonglong(i) * 1542678073;
+    QVector<int> offsets;
+    QString formatted = locale.formatNumbers(numbers, &offsets);
+    QCOMPARE(formatted.mid(offsets[1], offsets[2] - offsets[1]),
+             QString("1'542'678'073"));
+    QBENCHMARK {
+        locale.formatNumbers(numbers, &offsets);
+    }
+}
+#endif
+
+#ifdef HAVE_ICU
+void Pt_MLocale::benchmarkFormatPercent()
+{
+    MLocale locale("en_GB");
+    QCOMPARE(locale.formatPercent(0.123456, 2), QString("12.35%"));
+    QBENCHMARK {
+        locale.formatPercent(0.123456, 2);
+    }
+}
+#endif
+
+#ifdef HAVE_ICU
+void Pt_MLocale::benchmarkFormatCurrency()
+{
+    MLocale locale("en_GB");
+    QCOMPARE(locale.formatCurrency(1234.56, "EUR"), QString("€1,234.56"));
+    QCOMPARE(locale.formatCurrency(1234.56, "USD"), QString("$1,234.56"));
+    QBENCHMARK {
+        // alternate between two currencies, as in a price list
+        locale.formatCurrency(1234.56, "EUR");
+        locale.formatCurrency(1234.56, "USD");
+    }
+}
+#endif
+
+#ifdef HAVE_ICU
+void Pt_MLocale::benchmarkToLocalizedNumbersArabic()
+{
+    MLocale locale("ar_EG@numbers=arab");
+    QCOMPARE(locale.toLocalizedNumbers(QString("12:34 - message 5")),
+             QString::fromUtf8("١٢:٣٤ - message ٥"));
+    // a line as displayed in a chat or log viewer
+    QString line("12:34:56 user: see 192.168.0.1 and ticket 12345 for details");
+    QBENCHMARK {
+        locale.toLocalizedNumbers(line);
+    }
+}
+#endif
+
 #ifdef HAVE_ICU
 void Pt_MLocale::benchmarkChineseSorting()
 {
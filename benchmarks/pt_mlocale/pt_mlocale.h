@@ -56,6 +56,11 @@ private slots:
     void benchmarkFormatNumberQLongLongWestern();
     void benchmarkFormatNumberDoubleArabic();
     void benchmarkFormatNumberDoubleWestern();
+    void benchmarkFormatNumberDoublePrecisionWestern();
+    void benchmarkFormatNumbersQLongLongWestern();
+    void benchmarkFormatPercent();
+    void benchmarkFormatCurrency();
+    void benchmarkToLocalizedNumbersArabic();
     void benchmarkChineseSorting();
     void benchmarkCollatorStrengthSwitching();
 #endif
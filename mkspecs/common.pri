@@ -64,6 +64,12 @@ contains( CONFIG, coverage ) {
     *.gcov
 }
 
+# qmake CONFIG+=tsan builds everything with ThreadSanitizer
+contains( CONFIG, tsan ) {
+    QMAKE_CXXFLAGS *= -fsanitize=thread
+    QMAKE_LFLAGS *= -fsanitize=thread
+}
+
 QMAKE_LIBDIR += $${M_BUILD_TREE}/lib
 
 include(shared.pri)
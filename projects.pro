@@ -18,6 +18,7 @@ isEqual( IN_PWD, $${OUT_PWD} ) {
 
 SUBDIRS += \
     src \
+    tools \
     benchmarks \
     tests \
 
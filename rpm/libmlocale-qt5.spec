@@ -53,15 +53,28 @@ export QT_SELECT=5
 %install
 export QT_SELECT=5
 %make_install
+mkdir -p %{buildroot}%{_datadir}/mlocale5/icu
 
-%post -p /sbin/ldconfig
+# The locale metadata table describes the installed ICU data, so it is
+# generated on the target with the installed tool, again whenever ICU
+# is updated. Without a table MLocale falls back to asking ICU.
+%post
+/sbin/ldconfig
+%{_bindir}/mlocale-metadata %{_datadir}/mlocale5/icu/mlocalemetadata.bin > /dev/null || :
+
+%triggerin -- libicu
+%{_bindir}/mlocale-metadata %{_datadir}/mlocale5/icu/mlocalemetadata.bin > /dev/null || :
 
 %postun -p /sbin/ldconfig
 
 %files
 %defattr(-,root,root,-)
 %license LICENSE.LGPL
+%{_bindir}/mlocale-metadata
 %{_libdir}/*.so.*
+%dir %{_datadir}/mlocale5
+%dir %{_datadir}/mlocale5/icu
+%ghost %{_datadir}/mlocale5/icu/mlocalemetadata.bin
 
 %files devel
 %defattr(-,root,root,-)
@@ -20,6 +20,8 @@
 #include "mcalendar.h"
 #include "mcalendar_p.h"
 
+#include <unicode/gregocal.h>
+
 #include <QString>
 #include <QDateTime>
 #include <QDebug>
@@ -45,6 +47,19 @@ MCalendarPrivate::MCalendarPrivate(MLocale::CalendarType calendarType)
     }
 }
 
+MCalendarPrivate::MCalendarPrivate(icu::Calendar *calendar)
+    : _calendar(calendar), _calendarType(MLocale::DefaultCalendar), _valid(calendar != 0)
+{
+    if ( ! _watcher )
+    {
+        _watcher = new MTimeZoneWatcher();
+    }
+
+    // types MLocale has no enum value for stay DefaultCalendar, the
+    // default calendar of the locale is the same ICU calendar then
+    if (_calendar)
+        _calendarType = MIcuConversions::stringToCalendar(QString::fromLatin1(_calendar->getType()));
+}
 
 // copy constructor
 MCalendarPrivate::MCalendarPrivate(const MCalendarPrivate &other)
@@ -62,6 +77,7 @@ MCalendarPrivate::~MCalendarPrivate()
 }
 
 MTimeZoneWatcher *MCalendarPrivate::_watcher = NULL;
+QAtomicInt MCalendarPrivate::_systemTimeZoneSerial;
 
 MTimeZoneWatcher::MTimeZoneWatcher()
 {
@@ -211,6 +227,27 @@ MCalendar::MCalendar(const MLocale &mLocale, const QString &timezone)
 }
 
 
+namespace
+{
+    icu::Calendar *createCalendar(const QString &timeCategory, MLocale::CalendarType calendarType)
+    {
+        const QString localeName = MIcuConversions::setCalendarOption(timeCategory, calendarType);
+        UErrorCode status = U_ZERO_ERROR;
+        icu::Calendar *calendar
+            = icu::Calendar::createInstance(icu::Locale(qPrintable(localeName)), status);
+        if (!U_SUCCESS(status)) {
+            delete calendar;
+            return 0;
+        }
+        return calendar;
+    }
+}
+
+MCalendar::MCalendar(const QString &timeCategory, MLocale::CalendarType calendarType)
+    : d_ptr(new MCalendarPrivate(createCalendar(timeCategory, calendarType)))
+{
+}
+
 //! Copy constructor
 MCalendar::MCalendar(const MCalendar &other)
     : d_ptr(new MCalendarPrivate(*other.d_ptr))
@@ -697,6 +734,86 @@ int MCalendar::weekNumber() const
     return d->_calendar->get(UCAL_WEEK_OF_YEAR, status);
 }
 
+/*!
+  \brief Returns the week number in the year with weeks starting on \a weekday
+
+  Week 1 is the first week which contains \a weekday, the days
+  before it are in week 0, i.e. the result is between 0 and 53. This
+  is the week number of the POSIX “%U” (\a weekday is
+  MLocale::Sunday) and “%W” (\a weekday is MLocale::Monday)
+  conversions. Unlike weekNumber(), this does not depend on the first
+  day of the week and the minimal days in the first week set for the
+  calendar.
+
+  The week number is computed from dayOfYear() and dayOfWeek(), the
+  calendar is not copied or modified.
+
+  \sa isoWeekNumber()
+ */
+int MCalendar::weekNumberStartingFromDay(MLocale::Weekday weekday) const
+{
+    // days since the most recent “weekday”, including today:
+    const int daysIntoWeek = (dayOfWeek() - weekday + 7) % 7;
+    return (dayOfYear() - 1 + 7 - daysIntoWeek) / 7;
+}
+
+/*!
+  \brief Returns the ISO 8601 week number, between 1 and 53
+
+  ISO 8601 weeks start on Monday and week 1 is the week with the first
+  Thursday of the year, i.e. the first days of January may be in the
+  last week of the previous year and the last days of December may be
+  in week 1 of the next year. This is the week number of the POSIX
+  “%V” conversion. Unlike weekNumber(), this does not depend on the
+  first day of the week and the minimal days in the first week set
+  for the calendar.
+
+  For the Gregorian calendar the week number is computed from
+  dayOfYear(), dayOfWeek() and the length of the year without copying
+  the calendar.
+
+  \sa weekNumberStartingFromDay()
+ */
+int MCalendar::isoWeekNumber() const
+{
+    Q_D(const MCalendar);
+
+    if (d->_calendar->getDynamicClassID() != icu::GregorianCalendar::getStaticClassID()) {
+        // the year lengths of other calendars are not known here,
+        // let ICU do it
+        MCalendar calendarCopy = *this;
+        calendarCopy.setFirstDayOfWeek(MLocale::Monday);
+        calendarCopy.setMinimalDaysInFirstWeek(4);
+        return calendarCopy.weekNumber();
+    }
+
+    const icu::GregorianCalendar *gregorian
+        = static_cast<const icu::GregorianCalendar *>(d->_calendar);
+    UErrorCode status = U_ZERO_ERROR;
+    const int year = d->_calendar->get(UCAL_EXTENDED_YEAR, status);
+    const int dayOfYear = this->dayOfYear();
+    const int dayOfWeek = this->dayOfWeek(); // Monday = 1 … Sunday = 7
+
+    // a year has 53 weeks if it starts on Thursday or if it is a
+    // leap year and starts on Wednesday:
+    const int firstDayOfYear = ((dayOfWeek - dayOfYear) % 7 + 7) % 7 + 1;
+    const bool isLeapYear = gregorian->isLeapYear(year);
+    const int weekNumber = (dayOfYear - dayOfWeek + 10) / 7;
+    if (weekNumber < 1) {
+        // the last week of the previous year
+        const bool previousIsLeapYear = gregorian->isLeapYear(year - 1);
+        const int previousFirstDayOfYear
+            = ((firstDayOfYear - 1 - (previousIsLeapYear ? 366 : 365) % 7) % 7 + 7) % 7 + 1;
+        return (previousFirstDayOfYear == MLocale::Thursday
+                || (previousIsLeapYear && previousFirstDayOfYear == MLocale::Wednesday))
+            ? 53 : 52;
+    }
+    const int weeksInYear = (firstDayOfYear == MLocale::Thursday
+                             || (isLeapYear && firstDayOfYear == MLocale::Wednesday))
+        ? 53 : 52;
+    return weekNumber > weeksInYear ? 1 : weekNumber;
+}
+
 /*!
   \brief Returns the maximum number of weeks in a month.
  */
@@ -834,6 +951,7 @@ void MCalendar::setSystemTimeZone(const QString &timezone)
                 << __PRETTY_FUNCTION__
                 << "icu::TimeZone::createTimeZone() created a different timezone.";
         icu::TimeZone::adoptDefault(tz);
+        MCalendarPrivate::_systemTimeZoneSerial.ref();
     }
 }
 
@@ -101,6 +101,8 @@ public:
     qint32 getWeekendTransition(MLocale::Weekday weekday) const;
 
     int weekNumber() const;
+    int weekNumberStartingFromDay(MLocale::Weekday weekday) const;
+    int isoWeekNumber() const;
     int maximumWeeksInMonth() const;
     int daysInWeek() const;
 
@@ -178,10 +180,18 @@ public:
     static QStringList supportedTimeZones(const QString &country);
 
 private:
+    // creates a calendar of calendarType for the locale timeCategory
+    // in the system time zone, see MLocalePrivate::scratchCalendar().
+    // For DefaultCalendar type() is the calendar ICU chose for
+    // timeCategory, no default MLocale is involved.
+    MCalendar(const QString &timeCategory, MLocale::CalendarType calendarType);
+
     MCalendarPrivate *const d_ptr;
     Q_DECLARE_PRIVATE(MCalendar)
 
     friend class MLocale;
+    friend class MLocalePrivate;
+    friend class MDateTimeParserPrivate;
 };
 
 }
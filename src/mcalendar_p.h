@@ -22,6 +22,8 @@
 
 #include <unicode/calendar.h>
 
+#include <QAtomicInt>
+
 #include "mlocale.h"
 #include "mcalendar.h"
 
@@ -37,6 +39,8 @@ class MCalendarPrivate
 {
 public:
     MCalendarPrivate(MLocale::CalendarType calendarType);
+    // takes over calendar, the calendar type is the one ICU created
+    explicit MCalendarPrivate(icu::Calendar *calendar);
     MCalendarPrivate(const MCalendarPrivate &other);
 
     virtual ~MCalendarPrivate();
@@ -49,6 +53,9 @@ public:
     MLocale::CalendarType _calendarType;
     bool _valid;
     static MTimeZoneWatcher *_watcher;
+    // incremented by MCalendar::setSystemTimeZone(), lets caches of
+    // calendars notice that the system time zone has changed
+    static QAtomicInt _systemTimeZoneSerial;
 
 private:
 
@@ -103,6 +103,13 @@ MCollator::MCollator(const MLocale &locale)
 {
     Q_D(MCollator);
 
+    // cloning the collator cached by the locale is much cheaper
+    // than creating a new one:
+    const icu::Collator *collator = locale.d_func()->cachedCollator();
+    if (collator) {
+        d->_coll = collator->clone();
+        return;
+    }
     icu::Locale icuLocale
     = locale.d_ptr->getCategoryLocale(MLocale::MLcCollate);
     d->initCollator(icuLocale);
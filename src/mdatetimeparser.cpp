@@ -0,0 +1,205 @@
+/***************************************************************************
+**
+** This file is part of libmlocale.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "mdatetimeparser.h"
+#include "mdatetimeparser_p.h"
+
+#include <unicode/datefmt.h>
+#include <unicode/parsepos.h>
+
+#include "mcalendar.h"
+#include "mcalendar_p.h"
+#include "mlocale_p.h"
+
+#include <QStringList>
+
+namespace ML10N {
+
+///////////////////////////
+// MDateTimeParserPrivate
+
+MDateTimeParserPrivate::MDateTimeParserPrivate(const MLocale &locale,
+                                               MLocale::CalendarType calendarType)
+    : _locale(locale),
+      _calendar(calendarType)
+{
+}
+
+MDateTimeParserPrivate::MDateTimeParserPrivate(const MDateTimeParserPrivate &other)
+    : _locale(other._locale),
+      _calendar(other._calendar)
+{
+    for (int i = 0; i < other._styles.size(); ++i) {
+        Style style = other._styles.at(i);
+        style.dateFormat = static_cast<icu::DateFormat *>(style.dateFormat->clone());
+        _styles.append(style);
+    }
+}
+
+MDateTimeParserPrivate::~MDateTimeParserPrivate()
+{
+    clearStyles();
+}
+
+void MDateTimeParserPrivate::clearStyles()
+{
+    for (int i = 0; i < _styles.size(); ++i)
+        delete _styles.at(i).dateFormat;
+    _styles.clear();
+}
+
+bool MDateTimeParserPrivate::parse(const QString &dateTime, QDateTime *result,
+                                   int *matchedStyle)
+{
+    // the text is converted only once for all styles
+    _text.setTo(reinterpret_cast<const UChar *>(dateTime.constData()), dateTime.length());
+    icu::Calendar *cal = _calendar.d_ptr->_calendar;
+    for (int i = 0; i < _styles.size(); ++i) {
+        icu::ParsePosition pos(0);
+        cal->clear();
+        _styles.at(i).dateFormat->parse(_text, *cal, pos);
+        if (pos.getErrorIndex() >= 0 || pos.getIndex() != _text.length())
+            continue;
+        *result = _calendar.qDateTime();
+        if (matchedStyle)
+            *matchedStyle = i;
+        return true;
+    }
+    *result = QDateTime();
+    if (matchedStyle)
+        *matchedStyle = -1;
+    return false;
+}
+
+///////////////////
+// MDateTimeParser
+
+/*!
+  \class MDateTimeParser
+
+  \brief MDateTimeParser parses many date and time strings trying several styles
+
+  MDateTimeParser is created for an MLocale, see also
+  MLocale::dateTimeParser(). The styles to try are added with
+  addStyle(), parse() tries them in this order and reports which one
+  matched. The date formats are created only once when the styles are
+  added and a single calendar is reused for all strings, i.e. this is
+  much cheaper than calling MLocale::parseDateTime() for every string
+  and every style when importing big amounts of data.
+
+  parse() reuses the text buffer and the calendar of the parser and is
+  therefore not const. An MDateTimeParser must not be used by several
+  threads at the same time, use a copy per thread instead.
+
+  Example:
+  \verbatim
+  MLocale locale("fi_FI");
+  MDateTimeParser parser = locale.dateTimeParser();
+  parser.addStyle(MLocale::DateShort, MLocale::TimeShort);
+  parser.addStyle(MLocale::DateShort, MLocale::TimeNone);
+
+  int style;
+  QDateTime dateTime = parser.parse("13.7.2010", &style);
+  // style is 1 now
+  \endverbatim
+ */
+
+//! Constructor, creates a parser for \a locale and \a calendarType without any styles
+MDateTimeParser::MDateTimeParser(const MLocale &locale, MLocale::CalendarType calendarType)
+    : d_ptr(new MDateTimeParserPrivate(locale, calendarType))
+{
+}
+
+//! Copy constructor
+MDateTimeParser::MDateTimeParser(const MDateTimeParser &other)
+    : d_ptr(new MDateTimeParserPrivate(*other.d_ptr))
+{
+}
+
+MDateTimeParser::~MDateTimeParser()
+{
+    delete d_ptr;
+}
+
+//! Assignment operator
+MDateTimeParser &MDateTimeParser::operator=(const MDateTimeParser &other)
+{
+    if (this == &other)
+        return *this;
+
+    Q_D(MDateTimeParser);
+    d->_locale = other.d_ptr->_locale;
+    d->_calendar = other.d_ptr->_calendar;
+    d->clearStyles();
+    for (int i = 0; i < other.d_ptr->_styles.size(); ++i) {
+        MDateTimeParserPrivate::Style style = other.d_ptr->_styles.at(i);
+        style.dateFormat = static_cast<icu::DateFormat *>(style.dateFormat->clone());
+        d->_styles.append(style);
+    }
+    return *this;
+}
+
+void MDateTimeParser::addStyle(MLocale::DateType dateType, MLocale::TimeType timeType)
+{
+    Q_D(MDateTimeParser);
+
+    if (dateType == MLocale::DateNone && timeType == MLocale::TimeNone)
+        return;
+
+    // the parser keeps its own copy, it must not depend on what the
+    // date format cache of the MLocale evicts
+    const MLocale &locale = d->_locale;
+    const MLocalePrivate *localePrivate = locale.d_func();
+    const icu::DateFormat *df
+        = localePrivate->createDateFormat(dateType, timeType, d->_calendar.type(),
+                                          localePrivate->_timeFormat24h);
+    if (!df)
+        return;
+    MDateTimeParserPrivate::Style style;
+    style.dateType = dateType;
+    style.timeType = timeType;
+    style.dateFormat = static_cast<icu::DateFormat *>(df->clone());
+    d->_styles.append(style);
+}
+
+int MDateTimeParser::styleCount() const
+{
+    Q_D(const MDateTimeParser);
+    return d->_styles.size();
+}
+
+QDateTime MDateTimeParser::parse(const QString &dateTime, int *matchedStyle)
+{
+    Q_D(MDateTimeParser);
+    QDateTime result;
+    d->parse(dateTime, &result, matchedStyle);
+    return result;
+}
+
+int MDateTimeParser::parse(const QStringList &strings, QVector<QDateTime> *dateTimes,
+                           QVector<int> *matchedStyles)
+{
+    Q_D(MDateTimeParser);
+    const int count = strings.size();
+    dateTimes->resize(count);
+    if (matchedStyles)
+        matchedStyles->resize(count);
+    int parsed = 0;
+    for (int i = 0; i < count; ++i) {
+        if (d->parse(strings.at(i), dateTimes->data() + i,
+                     matchedStyles ? matchedStyles->data() + i : 0))
+            ++parsed;
+    }
+    return parsed;
+}
+
+}
@@ -0,0 +1,78 @@
+/***************************************************************************
+**
+** This file is part of libmlocale.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef ML10N_MDATETIMEPARSER_H
+#define ML10N_MDATETIMEPARSER_H
+
+#include "mlocaleexport.h"
+#include "mlocale.h"
+
+#include <QDateTime>
+#include <QVector>
+
+class QString;
+class QStringList;
+
+namespace ML10N {
+
+class MDateTimeParserPrivate;
+
+class MLOCALE_EXPORT MDateTimeParser
+{
+public:
+    explicit MDateTimeParser(const MLocale &locale,
+                             MLocale::CalendarType calendarType = MLocale::DefaultCalendar);
+    MDateTimeParser(const MDateTimeParser &other);
+    virtual ~MDateTimeParser();
+
+    MDateTimeParser &operator=(const MDateTimeParser &other);
+
+    /*!
+     * \brief appends a style to the list of styles tried by parse()
+     *
+     * The date format of the style is created once here, parsing
+     * does not look it up again. A style with MLocale::DateNone
+     * <b>and</b> MLocale::TimeNone is ignored.
+     */
+    void addStyle(MLocale::DateType dateType, MLocale::TimeType timeType);
+
+    //! returns the number of styles added with addStyle()
+    int styleCount() const;
+
+    /*!
+     * \brief parses \a dateTime with the styles in the order they were added
+     * \param dateTime string to parse
+     * \param matchedStyle if not NULL, receives the index of the style which matched or -1
+     *
+     * A style matches if it parses the whole string. Returns an
+     * invalid QDateTime if no style matches.
+     */
+    QDateTime parse(const QString &dateTime, int *matchedStyle = 0);
+
+    /*!
+     * \brief parses many strings at once
+     * \param strings strings to parse
+     * \param dateTimes receives strings.size() results, invalid ones where no style matched
+     * \param matchedStyles if not NULL, receives strings.size() style indices or -1
+     * \return the number of strings which could be parsed
+     */
+    int parse(const QStringList &strings, QVector<QDateTime> *dateTimes,
+              QVector<int> *matchedStyles = 0);
+
+private:
+    Q_DECLARE_PRIVATE(MDateTimeParser)
+    MDateTimeParserPrivate *const d_ptr;
+};
+
+}
+
+#endif
@@ -0,0 +1,59 @@
+/***************************************************************************
+**
+** This file is part of libmlocale.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef ML10N_MDATETIMEPARSER_P_H
+#define ML10N_MDATETIMEPARSER_P_H
+
+#include <unicode/datefmt.h>
+#include <unicode/unistr.h>
+
+#include <QDateTime>
+#include <QList>
+
+#include "mlocale.h"
+#include "mcalendar.h"
+
+namespace ML10N {
+
+class MDateTimeParserPrivate
+{
+public:
+    MDateTimeParserPrivate(const MLocale &locale, MLocale::CalendarType calendarType);
+    MDateTimeParserPrivate(const MDateTimeParserPrivate &other);
+    virtual ~MDateTimeParserPrivate();
+
+    void clearStyles();
+    // tries the styles in order, returns false if none parses the
+    // whole string
+    bool parse(const QString &dateTime, QDateTime *result, int *matchedStyle);
+
+    struct Style {
+        MLocale::DateType dateType;
+        MLocale::TimeType timeType;
+        // owned by the parser
+        icu::DateFormat *dateFormat;
+    };
+
+    MLocale _locale;
+    // the calendar the strings are parsed into
+    MCalendar _calendar;
+    QList<Style> _styles;
+    // reused for the text of every string
+    icu::UnicodeString _text;
+
+private:
+    MDateTimeParserPrivate &operator=(const MDateTimeParserPrivate &other);
+};
+
+}
+
+#endif
@@ -21,12 +21,12 @@
 
 #include <QDebug>
 #include <QString>
-#include <QRegularExpression>
 
 #include <unicode/unistr.h>
 #include <unicode/datefmt.h>
 
 #include "mlocale_p.h"
+#include "mlocaleidentifier.h"
 
 namespace ML10N {
 
@@ -326,49 +326,19 @@ QString MIcuConversions::icuDatePatternEscaped(const QString &str)
 
 QString MIcuConversions::parseOption(const QString &localeName, const QString &option)
 {
-    QString value;
-    QRegularExpression regexp("^[^@]+@.*"+QRegularExpression::escape(option)+"=([^@=;]+)($|;.*$)");
-    QRegularExpressionMatch match = regexp.match(localeName);
-
-    if (match.hasMatch() && match.capturedTexts().size() == 3) {
-        value = match.captured(1);
-    }
-    return value;
+    return MLocaleIdentifier::keywordValue(localeName, option);
 }
 
 QString MIcuConversions::setOption(const QString &localeName, const QString &option, const QString &value)
 {
-    QString newLocaleName = localeName;
-    if(!newLocaleName.isEmpty() && !option.isEmpty()) {
-        if(value.isEmpty()) { // remove option completely
-            if(newLocaleName.contains('@') && newLocaleName.contains(option)) {
-                QRegularExpression regexp("^([^@]+@.*)"+QRegularExpression::escape(option)+"=[^@=;]+($|;.*$)");
-                newLocaleName.replace(regexp, "\\1\\2");
-                newLocaleName.replace(QLatin1String(";;"), QLatin1String(";"));
-                newLocaleName.replace(QLatin1String("@;"), QLatin1String("@"));
-                while(newLocaleName.endsWith(';'))
-                    newLocaleName.chop(1);
-                if(newLocaleName.endsWith('@'))
-                    newLocaleName.chop(1);
-            }
-        }
-        else { // replace option value
-            if(!newLocaleName.contains('@')) {
-                newLocaleName += '@' + option + '=' + value;
-            }
-            else if(!newLocaleName.contains(option)) {
-                if(newLocaleName.endsWith(';'))
-                    newLocaleName += option + '=' + value;
-                else
-                    newLocaleName += ';' + option + '=' + value;
-            }
-            else {
-                QRegularExpression regexp("^([^@]+@.*"+QRegularExpression::escape(option)+"=)[^@=;]+($|;.*$)");
-                newLocaleName.replace(regexp, "\\1"+value+"\\2");
-            }
-        }
-    }
-    return newLocaleName;
+    if(localeName.isEmpty() || option.isEmpty())
+        return localeName;
+
+    MLocaleIdentifier identifier(localeName);
+    if(value.isEmpty() && !identifier.hasKeyword(option))
+        return localeName; // nothing to remove
+    identifier.setKeywordValue(option, value);
+    return identifier.toString();
 }
 
 Qt::LayoutDirection MIcuConversions::parseLayoutDirectionOption(const QString &localeName)
@@ -171,7 +171,23 @@ namespace MIcuConversions
      */
     QString icuDatePatternEscaped(const QString &str);
 
+    /*!
+     * \brief returns the value of the option \a option in \a localeName
+     *
+     * For example parseOption("fi_FI@calendar=islamic", "calendar")
+     * returns “islamic”.
+     *
+     * \sa MLocaleIdentifier
+     */
     QString parseOption(const QString &localeName, const QString &option);
+
+    /*!
+     * \brief sets the option \a option in \a localeName to \a value
+     *
+     * An empty \a value removes the option.
+     *
+     * \sa MLocaleIdentifier
+     */
     QString setOption(const QString &localeName, const QString &option, const QString &value);
 
     Qt::LayoutDirection parseLayoutDirectionOption(const QString &localeName);
@@ -45,15 +45,28 @@ using namespace icu;
 #include <QMetaProperty>
 #include <QCoreApplication>
 #include <QMutex>
+#include <QReadWriteLock>
 #include <QDateTime>
 #include <QPointer>
+#include <QScopedPointer>
+#include <QVarLengthArray>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadStorage>
+#include <QSet>
 #include <QRegularExpression>
 
+#include <cstring>
+
 #ifdef HAVE_ICU
 #include "mcollator.h"
+#include "mdatetimeparser.h"
 #include "mcalendar.h"
 #include "mcalendar_p.h"
 #include "micuconversions.h"
+#include "mlocalemetadata.h"
 #endif
 
 #include "mlocaleabstractconfigitem.h"
@@ -297,6 +310,9 @@ bool MTranslationCatalog::loadWith(MLocale *mlocale, MLocale::Category category)
 
 QStringList MLocalePrivate::translationPaths;
 QStringList MLocalePrivate::dataPaths;
+#ifdef HAVE_ICU
+QAtomicInt MLocalePrivate::_dataPathsSerial;
+#endif
 
 #ifdef HAVE_ICU
 bool MLocalePrivate::truncateLocaleName(QString *localeName)
@@ -336,6 +352,85 @@ bool MLocalePrivate::truncateLocaleName(QString *localeName)
     // no truncation possible
     return false;
 }
+
+QString MLocalePrivate::lookupResourceString(const char *bundleName,
+                                             const QString &localeName,
+                                             const QString &keyPath)
+{
+    const QList<QByteArray> keys = keyPath.toLatin1().split('/');
+    QString resourceBundleLocaleName = localeName;
+    do {
+        // Trying several resource bundles is a workaround for
+        // http://site.icu-project.org/design/resbund/issues
+        UErrorCode status = U_ZERO_ERROR;
+        UResourceBundle *res = ures_open(bundleName,
+                                         qPrintable(resourceBundleLocaleName),
+                                         &status);
+        if (U_FAILURE(status)) {
+            mDebug("MLocale") << __PRETTY_FUNCTION__ << "Error ures_open"
+                              << resourceBundleLocaleName
+                              << u_errorName(status);
+            ures_close(res);
+            return QString();
+        }
+        for (int i = 0; i < keys.size() - 1 && U_SUCCESS(status); ++i)
+            res = ures_getByKey(res, keys.at(i).constData(), res, &status);
+        int len = 0;
+        const UChar *val = 0;
+        if (U_SUCCESS(status))
+            val = ures_getStringByKey(res, keys.last().constData(), &len, &status);
+        ures_close(res);
+        if (U_SUCCESS(status))
+            return QString::fromUtf16(val, len);
+    } while (truncateLocaleName(&resourceBundleLocaleName));
+    return QString();
+}
+
+namespace
+{
+    // process wide memo of resource bundle lookups,
+    // see MLocalePrivate::cachedResourceString()
+    struct MLocaleResourceCache
+    {
+        QReadWriteLock lock;
+        QHash<QString, QString> strings;
+    };
+}
+
+Q_GLOBAL_STATIC(MLocaleResourceCache, localeResourceCache)
+
+QString MLocalePrivate::cachedResourceString(const char *bundleName,
+                                             const QString &localeName,
+                                             const QString &keyPath,
+                                             ResourceLookup lookup)
+{
+    QString key = QLatin1String(bundleName ? bundleName : "");
+    key += QLatin1Char('\t');
+    key += localeName;
+    key += QLatin1Char('\t');
+    key += keyPath;
+
+    MLocaleResourceCache *cache = localeResourceCache();
+    {
+        QReadLocker locker(&cache->lock);
+        QHash<QString, QString>::const_iterator it = cache->strings.constFind(key);
+        if (it != cache->strings.constEnd())
+            return it.value();
+    }
+    // don’t hold the lock while walking the resource bundles, in
+    // the worst case two threads do the same lookup:
+    const QString value = lookup(bundleName, localeName, keyPath);
+    QWriteLocker locker(&cache->lock);
+    cache->strings.insert(key, value);
+    return value;
+}
+
+void MLocalePrivate::clearResourceCache()
+{
+    MLocaleResourceCache *cache = localeResourceCache();
+    QWriteLocker locker(&cache->lock);
+    cache->strings.clear();
+}
 #endif
 
 #ifdef HAVE_ICU
@@ -354,6 +449,91 @@ icu::DateFormatSymbols *MLocalePrivate::createDateFormatSymbols(const icu::Local
     const DateFormatSymbols *dfs = dummyFormatter.getDateFormatSymbols();
     return new DateFormatSymbols(*dfs);
 }
+
+namespace
+{
+    // see MLocalePrivate::cachedDateFormatSymbols()
+    struct MDateFormatSymbolsTable
+    {
+        ~MDateFormatSymbolsTable()
+        {
+            qDeleteAll(symbols);
+        }
+
+        QMutex mutex;
+        QHash<QString, icu::DateFormatSymbols *> symbols;
+    };
+}
+
+Q_GLOBAL_STATIC(MDateFormatSymbolsTable, dateFormatSymbolsTable)
+
+const icu::DateFormatSymbols *MLocalePrivate::cachedDateFormatSymbols(const QString &localeName)
+{
+    MDateFormatSymbolsTable *table = dateFormatSymbolsTable();
+    if (!table)
+        return 0;
+    QMutexLocker locker(&table->mutex);
+    QHash<QString, icu::DateFormatSymbols *>::const_iterator it
+        = table->symbols.constFind(localeName);
+    if (it != table->symbols.constEnd())
+        return it.value();
+    // failures are cached as well, as 0:
+    icu::DateFormatSymbols *dfs
+        = createDateFormatSymbols(icu::Locale(qPrintable(localeName)));
+    table->symbols.insert(localeName, dfs);
+    return dfs;
+}
+
+QStringList MLocalePrivate::dateSymbolNames(DateSymbolKind kind,
+                                            MLocale::CalendarType calendarType,
+                                            MLocale::DateSymbolContext context,
+                                            MLocale::DateSymbolLength symbolLength) const
+{
+    const int key = (kind << 16) | (calendarType << 8) | (context << 4) | symbolLength;
+    QHash<int, QStringList>::const_iterator it = formatters()->dateSymbolNamesCache.constFind(key);
+    if (it != formatters()->dateSymbolNamesCache.constEnd())
+        return it.value();
+
+    Q_Q(const MLocale);
+    QString symbolLocaleName = _profile.mixingSymbolsWanted
+        ? categoryName(MLocale::MLcMessages) : categoryName(MLocale::MLcTime);
+    symbolLocaleName = MIcuConversions::setCalendarOption(symbolLocaleName, calendarType);
+
+    QStringList names;
+    const icu::DateFormatSymbols *dfs = cachedDateFormatSymbols(symbolLocaleName);
+    if (dfs) {
+        icu::DateFormatSymbols::DtContextType icuContext =
+            MIcuConversions::mDateContextToIcu(context);
+        icu::DateFormatSymbols::DtWidthType icuWidth =
+            MIcuConversions::mDateWidthToIcu(symbolLength);
+        int len = -1;
+        if (kind == MonthSymbols) {
+            const UnicodeString *months = dfs->getMonths(len, icuContext, icuWidth);
+            for (int i = 0; i < len; ++i)
+                names << MIcuConversions::unicodeStringToQString(months[i]);
+        } else {
+            // the ICU array is indexed by UCalendarDaysOfWeek, i.e.
+            // starts with an unused entry and has Sunday at 1
+            const UnicodeString *weekdays = dfs->getWeekdays(len, icuContext, icuWidth);
+            for (int weekday = MLocale::Monday; weekday <= MLocale::Sunday; ++weekday) {
+                const int weekdayNum = MIcuConversions::icuWeekday(weekday);
+                if (weekdayNum >= len)
+                    break;
+                names << MIcuConversions::unicodeStringToQString(weekdays[weekdayNum]);
+            }
+        }
+    }
+
+    if (context == MLocale::DateSymbolStandalone) {
+        for (int i = 0; i < names.size(); ++i) {
+            QString &name = names[i];
+            if (!name.isEmpty())
+                name[0] = q->toUpper(name.at(0))[0];
+        }
+    }
+    formatters()->dateSymbolNamesCache.insert(key, names);
+    return names;
+}
 #endif
 
 #ifdef HAVE_ICU
@@ -522,19 +702,18 @@ void MLocalePrivate::dateFormatToYearAndMonth(icu::DateFormat *df) const
         static_cast<SimpleDateFormat *>(df)->toPattern(icuFormatString);
         icuFormatQString = MIcuConversions::unicodeStringToQString(icuFormatString);
         QString categoryNameTime = categoryName(MLocale::MLcTime);
-        QString categoryNameMessages = categoryName(MLocale::MLcMessages);
         if(categoryNameTime.startsWith("zh"))
-            if(!mixingSymbolsWanted(categoryNameMessages, categoryNameTime))
+            if(!_profile.mixingSymbolsWanted)
                 icuFormatQString = QString::fromUtf8("yyyy年 LLLL"); // 2011年 十二月
             else
                 icuFormatQString = QString::fromUtf8("yyyy LLLL");
         else if(categoryNameTime.startsWith("ja"))
-            if(!mixingSymbolsWanted(categoryNameMessages, categoryNameTime))
+            if(!_profile.mixingSymbolsWanted)
                 icuFormatQString = QString::fromUtf8("yyyy年M月"); // 2011年12月
             else
                 icuFormatQString = QString::fromUtf8("yyyy LLLL");
         else if(categoryNameTime.startsWith("ko"))
-            if(!mixingSymbolsWanted(categoryNameMessages, categoryNameTime))
+            if(!_profile.mixingSymbolsWanted)
                 icuFormatQString = QString::fromUtf8("yyyy년 M월");
             else
                 icuFormatQString = QString::fromUtf8("yyyy LLLL");
@@ -561,19 +740,18 @@ void MLocalePrivate::dateFormatToWeekdayAbbreviatedAndDayOfMonth(icu::DateFormat
         static_cast<SimpleDateFormat *>(df)->toPattern(icuFormatString);
         icuFormatQString = MIcuConversions::unicodeStringToQString(icuFormatString);
         QString categoryNameTime = categoryName(MLocale::MLcTime);
-        QString categoryNameMessages = categoryName(MLocale::MLcMessages);
         if(categoryNameTime.startsWith("zh"))
-            if(!mixingSymbolsWanted(categoryNameMessages, categoryNameTime))
+            if(!_profile.mixingSymbolsWanted)
                 icuFormatQString = QString::fromUtf8("d日ccc"); // 5日周一
             else
                 icuFormatQString = QString::fromUtf8("d ccc");
         else if(categoryNameTime.startsWith("ja"))
-            if(!mixingSymbolsWanted(categoryNameMessages, categoryNameTime))
+            if(!_profile.mixingSymbolsWanted)
                 icuFormatQString = QString::fromUtf8("d日(ccc)"); // 5日(月)
             else
                 icuFormatQString = QString::fromUtf8("d ccc");
         else if(categoryNameTime.startsWith("ko"))
-            if(!mixingSymbolsWanted(categoryNameMessages, categoryNameTime))
+            if(!_profile.mixingSymbolsWanted)
                 icuFormatQString = QString::fromUtf8("d일 ccc");
             else
                 icuFormatQString = QString::fromUtf8("d ccc");
@@ -594,19 +772,18 @@ void MLocalePrivate::dateFormatToWeekdayWideAndDayOfMonth(icu::DateFormat *df) c
         static_cast<SimpleDateFormat *>(df)->toPattern(icuFormatString);
         icuFormatQString = MIcuConversions::unicodeStringToQString(icuFormatString);
         QString categoryNameTime = categoryName(MLocale::MLcTime);
-        QString categoryNameMessages = categoryName(MLocale::MLcMessages);
         if(categoryNameTime.startsWith("zh"))
-            if(!mixingSymbolsWanted(categoryNameMessages, categoryNameTime))
+            if(!_profile.mixingSymbolsWanted)
                 icuFormatQString = QString::fromUtf8("d日cccc"); // 5日星期一
             else
                 icuFormatQString = QString::fromUtf8("d cccc");
         else if(categoryNameTime.startsWith("ja"))
-            if(!mixingSymbolsWanted(categoryNameMessages, categoryNameTime))
+            if(!_profile.mixingSymbolsWanted)
                 icuFormatQString = QString::fromUtf8("d日(cccc)"); // 5日(月曜日)
             else
                 icuFormatQString = QString::fromUtf8("d cccc");
         else if(categoryNameTime.startsWith("ko"))
-            if(!mixingSymbolsWanted(categoryNameMessages, categoryNameTime))
+            if(!_profile.mixingSymbolsWanted)
                 icuFormatQString = QString::fromUtf8("d일 cccc");
             else
                 icuFormatQString = QString::fromUtf8("d cccc");
@@ -628,8 +805,8 @@ void MLocalePrivate::simplifyDateFormatForMixing(icu::DateFormat *df) const
         icuFormatQString = MIcuConversions::unicodeStringToQString(icuFormatString);
         QString categoryNameTime = categoryName(MLocale::MLcTime);
         QString categoryNameMessages = categoryName(MLocale::MLcMessages);
-        QString categoryScriptTime = MLocale::localeScript(categoryNameTime);
-        QString categoryScriptMessages = MLocale::localeScript(categoryNameMessages);
+        const QString &categoryScriptTime = _profile.timeScript;
+        const QString &categoryScriptMessages = _profile.messagesScript;
         // replace some known language specific stuff with something
         // generic which is understandable in a all languages or remove it
         // if there is no good generic replacement:
@@ -765,20 +942,16 @@ void MLocalePrivate::simplifyDateFormatForMixing(icu::DateFormat *df) const
 
 
 #ifdef HAVE_ICU
-void MLocalePrivate::maybeEmbedDateFormat(icu::DateFormat *df, const QString &categoryNameMessages, const QString &categoryNameTime) const
+void MLocalePrivate::maybeEmbedDateFormat(icu::DateFormat *df) const
 {
     // If the message locale and the time locale have different script directions,
     // it may happen that the date format gets reordered in an unexpected way if
     // it is not used on its own but together with text from the message
     // locale. Protect the date format against such unexpected reordering by
     // wrapping it in RLE...PDF or LRE...PDF.
+    const bool timeIsRtl = _profile.timeIsRtl;
+    const bool messagesIsRtl = _profile.messagesIsRtl;
     if (df) {
-        QString categoryScriptTime = MLocale::localeScript(categoryNameTime);
-        QString categoryScriptMessages = MLocale::localeScript(categoryNameMessages);
-        bool timeIsRtl = (categoryScriptTime == QLatin1String("Arab")
-                          || categoryScriptTime == QLatin1String("Hebr"));
-        bool messagesIsRtl = (categoryScriptMessages == QLatin1String("Arab")
-                              || categoryScriptMessages == QLatin1String("Hebr"));
         if (timeIsRtl != messagesIsRtl) {
             icu::UnicodeString icuFormatString;
             QString icuFormatQString;
@@ -806,7 +979,6 @@ void MLocalePrivate::maybeEmbedDateFormat(icu::DateFormat *df, const QString &ca
 QString MLocalePrivate::fixCategoryNameForNumbers(const QString &categoryName) const
 {
 #ifdef HAVE_ICU
-    Q_Q(const MLocale);
     QString categoryLanguage = parseLanguage(categoryName);
     // do nothing for languages other than ar, fa, hi, kn, mr, ne, pa, bn:
     if(categoryLanguage != "ar"
@@ -818,7 +990,8 @@ QString MLocalePrivate::fixCategoryNameForNumbers(const QString &categoryName) c
        && categoryLanguage != "pa"
        && categoryLanguage != "bn")
         return categoryName;
-    QString numericCategoryLanguage = q->categoryLanguage(MLocale::MLcNumeric);
+    const QString &numericCategoryLanguage =
+        categoryIdentifier(MLocale::MLcNumeric)->language();
     // if @numbers=<something> is already there, don’t touch it
     // and return immediately:
     if(!MIcuConversions::parseOption(categoryName, "numbers").isEmpty())
@@ -849,39 +1022,18 @@ QString MLocalePrivate::fixCategoryNameForNumbers(const QString &categoryName) c
 }
 
 #ifdef HAVE_ICU
-QString MLocalePrivate::icuFormatString(MLocale::DateType dateType,
-                                        MLocale::TimeType timeType,
-                                        MLocale::CalendarType calendarType,
-                                        MLocale::TimeFormat24h timeFormat24h) const
-{
-    icu::DateFormat *df = createDateFormat(dateType, timeType, calendarType, timeFormat24h);
-
-    QString icuFormatQString;
-
-    if (df)
-    {
-        icu::UnicodeString icuFormatString;
-        static_cast<SimpleDateFormat *>(df)->toPattern(icuFormatString);
-        icuFormatQString = MIcuConversions::unicodeStringToQString(icuFormatString);
-    }
-    return icuFormatQString;
-}
-#endif
-
-#ifdef HAVE_ICU
-bool MLocalePrivate::mixingSymbolsWanted(const QString &categoryNameMessages, const QString &categoryNameTime) const
+bool MLocalePrivate::mixingSymbolsWanted(const QString &categoryNameMessages,
+                                         const QString &categoryNameTime,
+                                         bool messagesIsRtl, bool timeIsRtl)
 {
     QString languageMessages = parseLanguage(categoryNameMessages);
     QString languageTime =  parseLanguage(categoryNameTime);
-    QString categoryScriptTime = MLocale::localeScript(categoryNameTime);
-    QString categoryScriptMessages = MLocale::localeScript(categoryNameMessages);
-    bool timeIsRtl = (categoryScriptTime == QLatin1String("Arab")
-                      || categoryScriptTime == QLatin1String("Hebr"));
-    bool messagesIsRtl = (categoryScriptMessages == QLatin1String("Arab")
-                          || categoryScriptMessages == QLatin1String("Hebr"));
-    if (categoryNameTime.contains(QRegularExpression("@.*mix-time-and-language=yes"))) {
+    const QString mixOption =
+        MLocaleIdentifier::keywordValue(categoryNameTime,
+                                        QLatin1String("mix-time-and-language"));
+    if (mixOption == QLatin1String("yes")) {
         return true;
-    } else if(!categoryNameTime.contains(QRegularExpression("@.*mix-time-and-language=no"))
+    } else if(mixOption != QLatin1String("no")
        && languageMessages != languageTime
        && languageMessages != "zh"
        && languageMessages != "ja"
@@ -918,28 +1070,387 @@ bool MLocalePrivate::mixingSymbolsWanted(const QString &categoryNameMessages, co
 #endif
 
 #ifdef HAVE_ICU
+MCalendar *MLocalePrivate::scratchCalendar(MLocale::CalendarType calendarType) const
+{
+    // start over if the system time zone has changed since the
+    // scratch calendars were created:
+    const int timeZoneSerial = MCalendarPrivate::_systemTimeZoneSerial.loadAcquire();
+    FormatterStore *store = formatters();
+    if (timeZoneSerial != store->scratchCalendarsTimeZoneSerial) {
+        store->dropScratchCalendars();
+        store->scratchCalendarsTimeZoneSerial = timeZoneSerial;
+    }
+    MCalendar *&calendar = store->scratchCalendars[calendarType];
+    if (!calendar)
+        calendar = new MCalendar(store->key.identifiers[MLocale::MLcTime]->toString(),
+                                 calendarType);
+    return calendar;
+}
+
+UDate MLocalePrivate::scratchDate(const MCalendar *calendar, const QDateTime &dateTime)
+{
+    QDateTime utcDateTime(dateTime);
+    utcDateTime.setTimeSpec(Qt::UTC);
+    UDate icuDate = utcDateTime.toMSecsSinceEpoch();
+    if (dateTime.timeSpec() == Qt::LocalTime) {
+        // convert from local time to UTC
+        UErrorCode status = U_ZERO_ERROR;
+        qint32 rawOffset;
+        qint32 dstOffset;
+        calendar->d_ptr->_calendar->getTimeZone().getOffset(icuDate, true /*local */,
+                                                            rawOffset, dstOffset, status);
+        icuDate = icuDate - rawOffset - dstOffset;
+    }
+    return icuDate;
+}
+
+void MLocalePrivate::FormatterStore::dropScratchCalendars()
+{
+    for (int i = 0; i <= MLocale::EthiopicCalendar; ++i) {
+        delete scratchCalendars[i];
+        scratchCalendars[i] = 0;
+    }
+    incrementalDateFormatCache.clear();
+}
+
+MIncrementalDateFormat *MLocalePrivate::incrementalDateFormat(MLocale::DateType dateType,
+                                                              MLocale::TimeType timeType,
+                                                              MLocale::CalendarType calendarType) const
+{
+    const DateFormatKey key(this, dateType, timeType, calendarType, _timeFormat24h);
+    MIncrementalDateFormat *cached = formatters()->incrementalDateFormatCache.object(key);
+    if (cached)
+        return cached;
+    const icu::DateFormat *df = createDateFormat(dateType, timeType, calendarType,
+                                                 _timeFormat24h);
+    if (!df)
+        return 0;
+    MIncrementalDateFormat *format = new MIncrementalDateFormat(*df);
+    formatters()->incrementalDateFormatCache.insert(key, format, format->approximateSize());
+    return format;
+}
+
+namespace
+{
+    const qint64 MSecsPerSecond = 1000;
+    const qint64 MSecsPerMinute = 60 * MSecsPerSecond;
+    const qint64 MSecsPerDay = 24 * 60 * MSecsPerMinute;
+
+    enum PatternLetterKind {
+        LiteralLetter,
+        DateLetter,
+        TimeLetter,
+        ZoneLetter,
+        UnsupportedLetter
+    };
+
+    PatternLetterKind patternLetterKind(UChar c)
+    {
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')))
+            return LiteralLetter;
+        // see http://userguide.icu-project.org/formatparse/datetime
+        if (strchr("GyYuUrQqMLlwWdDFgEec", char(c)))
+            return DateLetter;
+        // fractions of a second and milliseconds in day ('S', 'A')
+        // change too often to be worth caching
+        if (strchr("abBhHkKms", char(c)))
+            return TimeLetter;
+        if (strchr("zZOvVXx", char(c)))
+            return ZoneLetter;
+        return UnsupportedLetter;
+    }
+
+    inline qint64 floorDivide(qint64 numerator, qint64 denominator)
+    {
+        return numerator >= 0 ? numerator / denominator
+            : -((-numerator - 1) / denominator) - 1;
+    }
+}
+
+MIncrementalDateFormat::MIncrementalDateFormat(const icu::DateFormat &df)
+    : _df(static_cast<icu::DateFormat *>(df.clone())),
+      _dateFormat(0),
+      _timeFormat(0),
+      _incremental(false),
+      _timeFirst(false),
+      _timePartsPerInstant(false),
+      _timeResolution(MSecsPerMinute),
+      _dateParts(MaxDateParts),
+      _timeParts(MaxTimeParts)
+{
+    if (_df->getDynamicClassID() != icu::SimpleDateFormat::getStaticClassID())
+        return;
+
+    icu::UnicodeString pattern;
+    static_cast<icu::SimpleDateFormat *>(_df)->toPattern(pattern);
+
+    // find the first and the last date and time field, quoted text
+    // is a literal, “''” is a quote:
+    int32_t firstDate = -1;
+    int32_t lastDate = -1;
+    int32_t firstTime = -1;
+    int32_t lastTime = -1;
+    const int32_t length = pattern.length();
+    int32_t i = 0;
+    while (i < length) {
+        const UChar c = pattern.charAt(i);
+        if (c == '\'') {
+            ++i;
+            while (i < length && pattern.charAt(i) != '\'')
+                ++i;
+            ++i;
+            continue;
+        }
+        switch (patternLetterKind(c)) {
+        case LiteralLetter:
+            ++i;
+            continue;
+        case DateLetter:
+            if (firstDate < 0)
+                firstDate = i;
+            lastDate = i;
+            break;
+        case ZoneLetter:
+            _timePartsPerInstant = true;
+            // fall through
+        case TimeLetter:
+            if (c == 's')
+                _timeResolution = MSecsPerSecond;
+            if (firstTime < 0)
+                firstTime = i;
+            lastTime = i;
+            break;
+        case UnsupportedLetter:
+            return;
+        }
+        while (i < length && pattern.charAt(i) == c)
+            ++i;
+    }
+
+    // the pattern is split where the fields of the second kind
+    // start, a pattern with fields of one kind only is not split:
+    int32_t split;
+    if (firstDate < 0 && firstTime < 0)
+        return;
+    else if (firstDate < 0 || firstTime < 0)
+        split = length;
+    else if (lastDate < firstTime)
+        split = firstTime;
+    else if (lastTime < firstDate)
+        split = firstDate;
+    else
+        return; // interleaved
+
+    _timeFirst = firstTime >= 0 && (firstDate < 0 || firstTime < firstDate);
+    icu::DateFormat *first = static_cast<icu::DateFormat *>(_df->clone());
+    icu::DateFormat *second = 0;
+    if (split < length) {
+        static_cast<icu::SimpleDateFormat *>(first)->applyPattern(
+            pattern.tempSubString(0, split));
+        second = static_cast<icu::DateFormat *>(_df->clone());
+        static_cast<icu::SimpleDateFormat *>(second)->applyPattern(
+            pattern.tempSubString(split));
+    }
+    _dateFormat = _timeFirst ? second : first;
+    _timeFormat = _timeFirst ? first : second;
+    _incremental = true;
+}
+
+MIncrementalDateFormat::~MIncrementalDateFormat()
+{
+    delete _df;
+    delete _dateFormat;
+    delete _timeFormat;
+}
+
+bool MIncrementalDateFormat::isIncremental() const
+{
+    return _incremental;
+}
+
+int MIncrementalDateFormat::approximateSize() const
+{
+    // a formatted part is a short QString, count its header and
+    // about 24 characters:
+    const int partSize = 64;
+    int size = int(sizeof(*this)) + MLocalePrivate::approximateSize(_df);
+    if (_dateFormat)
+        size += MLocalePrivate::approximateSize(_dateFormat);
+    if (_timeFormat)
+        size += MLocalePrivate::approximateSize(_timeFormat);
+    if (_incremental)
+        size += (MaxDateParts + MaxTimeParts) * partSize;
+    return size;
+}
+
+QString *MIncrementalDateFormat::formatPart(const icu::DateFormat *df, icu::Calendar *cal,
+                                            UDate date, bool *calendarSet)
+{
+    if (!*calendarSet) {
+        UErrorCode status = U_ZERO_ERROR;
+        cal->setTime(date, status);
+        *calendarSet = true;
+    }
+    icu::FieldPosition pos;
+    _buffer.remove();
+    df->format(*cal, _buffer, pos);
+    return new QString(reinterpret_cast<const QChar *>(_buffer.getBuffer()), _buffer.length());
+}
+
+void MIncrementalDateFormat::append(icu::Calendar *cal, UDate date, QString *result)
+{
+    UErrorCode status = U_ZERO_ERROR;
+    qint32 rawOffset = 0;
+    qint32 dstOffset = 0;
+    if (_incremental)
+        cal->getTimeZone().getOffset(date, false /* UTC */, rawOffset, dstOffset, status);
+    if (!_incremental || U_FAILURE(status)) {
+        status = U_ZERO_ERROR;
+        cal->setTime(date, status);
+        icu::FieldPosition pos;
+        _buffer.remove();
+        _df->format(*cal, _buffer, pos);
+        result->append(reinterpret_cast<const QChar *>(_buffer.getBuffer()), _buffer.length());
+        return;
+    }
+
+    const qint64 utc = qint64(date);
+    const qint64 local = utc + rawOffset + dstOffset;
+    const qint64 day = floorDivide(local, MSecsPerDay);
+    bool calendarSet = false;
+
+    const QString *datePart = 0;
+    if (_dateFormat) {
+        datePart = _dateParts.object(day);
+        if (!datePart) {
+            QString *part = formatPart(_dateFormat, cal, date, &calendarSet);
+            _dateParts.insert(day, part);
+            datePart = part;
+        }
+    }
+    const QString *timePart = 0;
+    if (_timeFormat) {
+        const qint64 timeKey = _timePartsPerInstant
+            ? floorDivide(utc, _timeResolution)
+            : (local - day * MSecsPerDay) / _timeResolution;
+        timePart = _timeParts.object(timeKey);
+        if (!timePart) {
+            QString *part = formatPart(_timeFormat, cal, date, &calendarSet);
+            _timeParts.insert(timeKey, part);
+            timePart = part;
+        }
+    }
+
+    if (_timeFirst)
+        qSwap(datePart, timePart);
+    if (datePart)
+        result->append(*datePart);
+    if (timePart)
+        result->append(*timePart);
+}
+
+MLocalePrivate::DateFormatKey::DateFormatKey(const MLocalePrivate *d,
+                                             MLocale::DateType dateType,
+                                             MLocale::TimeType timeType,
+                                             MLocale::CalendarType calendarType,
+                                             MLocale::TimeFormat24h timeFormat24h)
+    : dateType(dateType),
+      timeType(timeType),
+      calendarType(calendarType),
+      timeFormat24h(timeFormat24h)
+{
+    identifiers[0] = d->categoryIdentifier(MLocale::MLcTime);
+    identifiers[1] = d->categoryIdentifier(MLocale::MLcNumeric);
+    identifiers[2] = d->categoryIdentifier(MLocale::MLcMessages);
+    hash = (uint(dateType) << 24) ^ (uint(timeType) << 16)
+        ^ (uint(calendarType) << 8) ^ uint(timeFormat24h);
+    for (int i = 0; i < 3; ++i)
+        hash = hash * 31 + uint(quintptr(identifiers[i]) >> 4);
+}
+
+bool MLocalePrivate::DateFormatKey::operator==(const DateFormatKey &other) const
+{
+    return hash == other.hash
+        && dateType == other.dateType
+        && timeType == other.timeType
+        && calendarType == other.calendarType
+        && timeFormat24h == other.timeFormat24h
+        && identifiers[0] == other.identifiers[0]
+        && identifiers[1] == other.identifiers[1]
+        && identifiers[2] == other.identifiers[2];
+}
+
+MLocalePrivate::SimpleDateFormatKey::SimpleDateFormatKey(const MLocalePrivate *d,
+                                                         const QString &pattern,
+                                                         MLocale::CalendarType calendarType)
+    : pattern(pattern),
+      calendarType(calendarType)
+{
+    identifiers[0] = d->categoryIdentifier(MLocale::MLcTime);
+    identifiers[1] = d->categoryIdentifier(MLocale::MLcNumeric);
+    identifiers[2] = d->categoryIdentifier(MLocale::MLcMessages);
+    hash = uint(qHash(pattern)) ^ uint(calendarType);
+    for (int i = 0; i < 3; ++i)
+        hash = hash * 31 + uint(quintptr(identifiers[i]) >> 4);
+}
+
+bool MLocalePrivate::SimpleDateFormatKey::operator==(const SimpleDateFormatKey &other) const
+{
+    return hash == other.hash
+        && calendarType == other.calendarType
+        && identifiers[0] == other.identifiers[0]
+        && identifiers[1] == other.identifiers[1]
+        && identifiers[2] == other.identifiers[2]
+        && pattern == other.pattern;
+}
+
+MLocalePrivate::PatternKey::PatternKey(MLocale::DateType dateType,
+                                       MLocale::TimeType timeType,
+                                       MLocale::CalendarType calendarType,
+                                       MLocale::TimeFormat24h timeFormat24h)
+    : types((quint32(quint8(dateType)) << 24) | (quint32(quint8(timeType)) << 16)
+            | (quint32(quint8(calendarType)) << 8) | quint32(quint8(timeFormat24h))),
+      hash(types)
+{
+}
+
+MLocalePrivate::PatternKey::PatternKey(const QString &skeleton,
+                                       MLocale::CalendarType calendarType)
+    : skeleton(skeleton),
+      types(0xff000000 | (quint32(quint8(calendarType)) << 8)),
+      hash(uint(qHash(skeleton)) ^ types)
+{
+}
+
+bool MLocalePrivate::PatternKey::operator==(const PatternKey &other) const
+{
+    return hash == other.hash
+        && types == other.types
+        && skeleton == other.skeleton;
+}
+
 icu::DateFormat *MLocalePrivate::createDateFormat(MLocale::DateType dateType,
                                                   MLocale::TimeType timeType,
                                                   MLocale::CalendarType calendarType,
                                                   MLocale::TimeFormat24h timeFormat24h) const
 {
-    QString categoryNameTime = categoryName(MLocale::MLcTime);
-    QString categoryNameNumeric = categoryName(MLocale::MLcNumeric);
-    QString categoryNameMessages = categoryName(MLocale::MLcMessages);
-    QString key = QString("%1_%2_%3_%4_%5_%6_%7")
-        .arg(dateType)
-        .arg(timeType)
-        .arg(calendarType)
-        .arg(timeFormat24h)
-        .arg(categoryNameTime)
-        .arg(categoryNameNumeric)
-        .arg(categoryNameMessages);
-    if (_dateFormatCache.contains(key))
-        return _dateFormatCache.object(key);
-    categoryNameTime = fixCategoryNameForNumbers(
-        MIcuConversions::setCalendarOption(categoryNameTime, calendarType));
-    categoryNameMessages = fixCategoryNameForNumbers(
-        MIcuConversions::setCalendarOption(categoryNameMessages, calendarType));
+    const DateFormatKey key(this, dateType, timeType, calendarType, timeFormat24h);
+    FormatterStore *store = formatters();
+    icu::DateFormat *cached = store->dateFormatCache.object(key);
+    if (cached)
+        return cached;
+    icu::DateFormat *df = newDateFormat(dateType, timeType, calendarType, timeFormat24h);
+    store->dateFormatCache.insert(key, df, approximateSize(df));
+    return df;
+}
+
+icu::DateFormat *MLocalePrivate::newDateFormat(MLocale::DateType dateType,
+                                               MLocale::TimeType timeType,
+                                               MLocale::CalendarType calendarType,
+                                               MLocale::TimeFormat24h timeFormat24h) const
+{
+    QString categoryNameTime = categoryNameForCalendar(MLocale::MLcTime, calendarType);
+    QString categoryNameMessages = categoryNameForCalendar(MLocale::MLcMessages, calendarType);
     icu::Locale calLocale = icu::Locale(qPrintable(categoryNameTime));
     icu::DateFormat::EStyle dateStyle;
     icu::DateFormat::EStyle timeStyle;
@@ -979,92 +1490,698 @@ icu::DateFormat *MLocalePrivate::createDateFormat(MLocale::DateType dateType,
             break;
         }
     }
-    if(mixingSymbolsWanted(categoryNameMessages, categoryNameTime)) {
+    if(_profile.mixingSymbolsWanted) {
         // If we are mixing really different languages, simplify the
         // date format first to make the results less bad:
         MLocalePrivate::simplifyDateFormatForMixing(df);
-        DateFormatSymbols *dfs =
-            MLocalePrivate::createDateFormatSymbols(
-                icu::Locale(qPrintable(categoryNameMessages)));
+        const DateFormatSymbols *dfs =
+            MLocalePrivate::cachedDateFormatSymbols(categoryNameMessages);
         // This is not nice but seems to be the only way to set the
         // symbols with the public API
-        static_cast<SimpleDateFormat *>(df)->adoptDateFormatSymbols(dfs);
+        if (dfs)
+            static_cast<SimpleDateFormat *>(df)->setDateFormatSymbols(*dfs);
     }
-    MLocalePrivate::maybeEmbedDateFormat(df, categoryNameMessages, categoryNameTime);
-    _dateFormatCache.insert(key, df);
+    MLocalePrivate::maybeEmbedDateFormat(df);
     return df;
 }
 #endif
 
-// Constructors
-
-MLocalePrivate::MLocalePrivate()
-    : _valid(true),
-      _timeFormat24h(MLocale::LocaleDefaultTimeFormat24h),
-      _phoneNumberGrouping( MLocale::DefaultPhoneNumberGrouping ),
-#ifdef HAVE_ICU
-      _numberFormat(0),
-      _numberFormatLcTime(0),
-#endif
-      pCurrentLanguage(0),
-      pCurrentLcTime(0),
-      pCurrentLcTimeFormat24h(0),
-      pCurrentLcCollate(0),
-      pCurrentLcNumeric(0),
-      pCurrentLcMonetary(0),
-      pCurrentLcTelephone(0),
-#ifdef HAVE_ICU
-      _pDateTimeCalendar(0),
-#endif
-      q_ptr(0)
+namespace
 {
-    lmlDebug( "MLocalePrivate ctor called" );
+    // Approximate heap sizes of the cached ICU objects in bytes,
+    // measured with u_setMemoryFunctions() for ICU 72. A
+    // SimpleDateFormat owns its DateFormatSymbols, Calendar and
+    // NumberFormat, the calendars with era or cyclic year tables and
+    // the Hebrew one with its own numbering system are bigger.
+    const int DateFormatSize = 54 * 1024;
+    const int JapaneseDateFormatSize = 98 * 1024;
+    const int ChineseDateFormatSize = 120 * 1024;
+    const int HebrewDateFormatSize = 395 * 1024;
+    const int NumberFormatSize = 8 * 1024;
+    const int PatternGeneratorSize = 37 * 1024;
+
+    // The default capacities keep as many entries of the usual size
+    // as the caches held before they were measured in bytes.
+    const int DefaultCacheCapacities[MLocale::PatternGeneratorCache + 1] = {
+        100 * DateFormatSize, // DateFormatCache
+        100 * DateFormatSize, // SimpleDateFormatCache
+        100 * 256,            // PosixFormatCache
+        100 * NumberFormatSize, // PrecisionNumberFormatCache
+        8 * NumberFormatSize, // PercentNumberFormatCache
+        16 * NumberFormatSize, // CurrencyNumberFormatCache
+        4 * 256 * 1024,       // IncrementalDateFormatCache
+        256 * 256,            // PatternCache
+        4 * PatternGeneratorSize // PatternGeneratorCache
+    };
+
+    const char *const CacheNames[MLocale::PatternGeneratorCache + 1] = {
+        "DateFormatCache",
+        "SimpleDateFormatCache",
+        "PosixFormatCache",
+        "PrecisionNumberFormatCache",
+        "PercentNumberFormatCache",
+        "CurrencyNumberFormatCache",
+        "IncrementalDateFormatCache",
+        "PatternCache",
+        "PatternGeneratorCache"
+    };
+
+    // approximate heap size of a cached pattern in bytes
+    int patternSize(const QString &pattern)
+    {
+        return int(sizeof(QString) + 32 + pattern.size() * sizeof(QChar));
+    }
 
-    if (translationPaths.isEmpty())
+    void addStatistics(MLocale::CacheStatistics *statistics,
+                       const MLocale::CacheStatistics &other)
     {
-#ifdef Q_OS_WIN
-        // walk to translation dir relative to bin dir
-        QDir appDir(QCoreApplication::applicationDirPath());
+        statistics->hits += other.hits;
+        statistics->misses += other.misses;
+        statistics->evictions += other.evictions;
+        statistics->entries += other.entries;
+        statistics->bytes += other.bytes;
+    }
 
-	appDir.cdUp();
-	appDir.cd("share");
-	appDir.cd("l10n");
-	appDir.cd("meegotouch");
+    // all live formatter caches of the process, the counters of the
+    // destroyed ones and the capacities set with
+    // MLocale::setCacheCapacity()
+    struct MFormatterCacheRegistry
+    {
+        MFormatterCacheRegistry()
+        {
+            memset(retired, 0, sizeof(retired));
+            for (int i = 0; i <= MLocale::PatternGeneratorCache; ++i)
+                capacities[i].storeRelease(DefaultCacheCapacities[i]);
+        }
 
-        translationPaths = (QStringList() << appDir.absolutePath());
-#else
-        translationPaths = (QStringList() << QString(TRANSLATION_DIR));
-#endif
-    }
+        ~MFormatterCacheRegistry()
+        {
+            // the last chance to see the totals, the caches of
+            // locales destroyed later on are still live here:
+            const QByteArray dump = qgetenv("MLOCALE_CACHE_STATISTICS");
+            if (dump.isEmpty() || dump == "0")
+                return;
+            for (int i = 0; i <= MLocale::PatternGeneratorCache; ++i) {
+                const MLocale::CacheStatistics statistics = total(i);
+                mDebug("MLocale") << CacheNames[i]
+                                  << "hits" << statistics.hits
+                                  << "misses" << statistics.misses
+                                  << "evictions" << statistics.evictions
+                                  << "entries" << statistics.entries
+                                  << "bytes" << statistics.bytes
+                                  << "capacity" << capacities[i].loadAcquire();
+            }
+        }
 
-    if (dataPaths.isEmpty())
-        MLocale::setDataPath(ML_ICUEXTRADATA_DIR);
+        MLocale::CacheStatistics total(int type)
+        {
+            QMutexLocker locker(&mutex);
+            MLocale::CacheStatistics statistics = retired[type];
+            foreach (const MFormatterCacheCounters *cache, caches) { // krazy:exclude=foreach
+                if (cache->type() == type)
+                    cache->addTo(&statistics);
+            }
+            return statistics;
+        }
+
+        QMutex mutex;
+        QSet<const MFormatterCacheCounters *> caches;
+        MLocale::CacheStatistics retired[MLocale::PatternGeneratorCache + 1];
+        QAtomicInt capacities[MLocale::PatternGeneratorCache + 1];
+    };
 }
 
-// copy constructor
-MLocalePrivate::MLocalePrivate(const MLocalePrivate &other)
-    : _valid(other._valid),
-      _defaultLocale(other._defaultLocale),
-      _messageLocale(other._messageLocale),
-      _numericLocale(other._numericLocale),
-      _collationLocale(other._collationLocale),
-      _calendarLocale(other._calendarLocale),
-      _monetaryLocale(other._monetaryLocale),
-      _nameLocale(other._nameLocale),
-      _telephoneLocale(other._telephoneLocale),
-      _validCountryCodes( other._validCountryCodes ),
-      _timeFormat24h(other._timeFormat24h),
-      _phoneNumberGrouping( other._phoneNumberGrouping ),
-#ifdef HAVE_ICU
-      _numberFormat(0),
-      _numberFormatLcTime(0),
-#endif
-      _messageTranslations(other._messageTranslations),
-      _timeTranslations(other._timeTranslations),
-      _trTranslations(other._trTranslations),
+Q_GLOBAL_STATIC(MFormatterCacheRegistry, formatterCacheRegistry)
 
-      pCurrentLanguage(0),
-      pCurrentLcTime(0),
+MFormatterCacheCounters::MFormatterCacheCounters(MLocale::FormatterCache type)
+    : _type(type)
+{
+    MFormatterCacheRegistry *registry = formatterCacheRegistry();
+    if (registry) {
+        QMutexLocker locker(&registry->mutex);
+        registry->caches.insert(this);
+    }
+}
+
+MFormatterCacheCounters::~MFormatterCacheCounters()
+{
+    MFormatterCacheRegistry *registry = formatterCacheRegistry();
+    if (registry) {
+        QMutexLocker locker(&registry->mutex);
+        registry->caches.remove(this);
+        // the derived cache has been cleared already, i.e. only the
+        // lookups are left:
+        MLocale::CacheStatistics &retired = registry->retired[_type];
+        retired.hits += _hits.loadAcquire();
+        retired.misses += _misses.loadAcquire();
+        retired.evictions += _evictions.loadAcquire();
+    }
+}
+
+MLocale::FormatterCache MFormatterCacheCounters::type() const
+{
+    return _type;
+}
+
+void MFormatterCacheCounters::addTo(MLocale::CacheStatistics *statistics) const
+{
+    MLocale::CacheStatistics counters;
+    counters.hits = _hits.loadAcquire();
+    counters.misses = _misses.loadAcquire();
+    counters.evictions = _evictions.loadAcquire();
+    counters.entries = _entries.loadAcquire();
+    counters.bytes = _bytes.loadAcquire();
+    addStatistics(statistics, counters);
+}
+
+int MFormatterCacheCounters::capacity(MLocale::FormatterCache type)
+{
+    MFormatterCacheRegistry *registry = formatterCacheRegistry();
+    return registry ? registry->capacities[type].loadAcquire()
+        : DefaultCacheCapacities[type];
+}
+
+void MFormatterCacheCounters::countLookup(bool hit)
+{
+    // only the owning thread writes, no read-modify-write needed:
+    QAtomicInteger<qint64> &counter = hit ? _hits : _misses;
+    counter.storeRelease(counter.loadAcquire() + 1);
+}
+
+void MFormatterCacheCounters::countChange(int entries, int bytes, int evictions)
+{
+    _entries.storeRelease(entries);
+    _bytes.storeRelease(bytes);
+    if (evictions > 0)
+        _evictions.storeRelease(_evictions.loadAcquire() + evictions);
+}
+
+#ifdef HAVE_ICU
+int MLocalePrivate::approximateSize(const icu::DateFormat *df)
+{
+    const icu::Calendar *calendar = df ? df->getCalendar() : 0;
+    const char *calendarType = calendar ? calendar->getType() : "";
+    if (qstrcmp(calendarType, "hebrew") == 0)
+        return HebrewDateFormatSize;
+    if (qstrcmp(calendarType, "chinese") == 0 || qstrcmp(calendarType, "dangi") == 0)
+        return ChineseDateFormatSize;
+    if (qstrcmp(calendarType, "japanese") == 0)
+        return JapaneseDateFormatSize;
+    return DateFormatSize;
+}
+
+int MLocalePrivate::approximateSize(const PosixFormatPlan &plan)
+{
+    int size = int(sizeof(plan) + plan.size() * sizeof(PosixFormatSegment));
+    for (int i = 0; i < plan.size(); ++i)
+        size += int(plan.at(i).pattern.size() * sizeof(QChar));
+    return size;
+}
+
+QString MLocalePrivate::icuFormatString(MLocale::DateType dateType,
+                                        MLocale::TimeType timeType,
+                                        MLocale::CalendarType calendarType,
+                                        MLocale::TimeFormat24h timeFormat24h) const
+{
+    const PatternKey key(dateType, timeType, calendarType, timeFormat24h);
+    FormatterStore *store = formatters();
+    const QString *cached = store->patternCache.object(key);
+    if (cached)
+        return *cached;
+
+    // ICU has no way to get the pattern of a style without a
+    // formatter. Use the cached one if there is one, otherwise
+    // create one only for reading its pattern:
+    const DateFormatKey formatKey(this, dateType, timeType, calendarType, timeFormat24h);
+    icu::DateFormat *df = 0;
+    QScopedPointer<icu::DateFormat> created;
+    if (store->dateFormatCache.contains(formatKey)) {
+        df = store->dateFormatCache.object(formatKey);
+    } else {
+        created.reset(newDateFormat(dateType, timeType, calendarType, timeFormat24h));
+        df = created.data();
+    }
+
+    QString icuFormatQString;
+
+    if (df)
+    {
+        icu::UnicodeString icuFormatString;
+        static_cast<SimpleDateFormat *>(df)->toPattern(icuFormatString);
+        icuFormatQString = MIcuConversions::unicodeStringToQString(icuFormatString);
+    }
+    store->patternCache.insert(key, new QString(icuFormatQString),
+                               patternSize(icuFormatQString));
+    return icuFormatQString;
+}
+
+QString MLocalePrivate::skeletonFormatString(const QString &skeleton,
+                                             MLocale::CalendarType calendarType) const
+{
+    const PatternKey key(skeleton, calendarType);
+    FormatterStore *store = formatters();
+    const QString *cached = store->patternCache.object(key);
+    if (cached)
+        return *cached;
+
+    // “j” is the preferred hour of the locale, make it and the
+    // explicit hour fields follow the time format of this locale:
+    QString adjusted = skeleton;
+    if (_timeFormat24h != MLocale::LocaleDefaultTimeFormat24h) {
+        const bool twentyFour = _timeFormat24h == MLocale::TwentyFourHourTimeFormat24h;
+        for (int i = 0; i < adjusted.size(); ++i) {
+            const QChar c = adjusted.at(i);
+            if (twentyFour && (c == 'j' || c == 'h' || c == 'K'))
+                adjusted[i] = 'H';
+            else if (!twentyFour && (c == 'j' || c == 'H' || c == 'k'))
+                adjusted[i] = 'h';
+        }
+    }
+
+    QString pattern;
+    icu::DateTimePatternGenerator *generator = patternGenerator(calendarType);
+    if (generator) {
+        UErrorCode status = U_ZERO_ERROR;
+        const icu::UnicodeString bestPattern = generator->getBestPattern(
+            MIcuConversions::qStringToUnicodeString(adjusted), status);
+        if (U_SUCCESS(status))
+            pattern = MIcuConversions::unicodeStringToQString(bestPattern);
+        else
+            qWarning() << "icu::DateTimePatternGenerator::getBestPattern() failed with error"
+                       << u_errorName(status);
+    }
+    store->patternCache.insert(key, new QString(pattern), patternSize(pattern));
+    return pattern;
+}
+
+icu::DateTimePatternGenerator *MLocalePrivate::patternGenerator(MLocale::CalendarType calendarType) const
+{
+    FormatterStore *store = formatters();
+    icu::DateTimePatternGenerator *generator =
+        store->patternGeneratorCache.object(calendarType);
+    if (generator)
+        return generator;
+
+    UErrorCode status = U_ZERO_ERROR;
+    generator = icu::DateTimePatternGenerator::createInstance(
+        icu::Locale(qPrintable(categoryNameForCalendar(MLocale::MLcTime, calendarType))),
+        status);
+    if (U_FAILURE(status)) {
+        qWarning() << "icu::DateTimePatternGenerator::createInstance() failed with error"
+                   << u_errorName(status);
+        delete generator;
+        return 0;
+    }
+    store->patternGeneratorCache.insert(calendarType, generator, PatternGeneratorSize);
+    return generator;
+}
+
+MLocalePrivate::FormatterStoreKey::FormatterStoreKey(const MLocalePrivate *d)
+    : timeFormat24h(d->_timeFormat24h),
+      thread(d->_ownerThread),
+      dataPathsSerial(_dataPathsSerial.loadAcquire())
+{
+    hash = uint(timeFormat24h) ^ uint(quintptr(thread) >> 4) ^ uint(dataPathsSerial);
+    for (int i = MLocale::MLcMessages; i <= MLocale::MLcTelephone; ++i) {
+        identifiers[i] = d->_categoryIdentifiers[i];
+        hash = hash * 31 + uint(quintptr(identifiers[i]) >> 4);
+    }
+}
+
+bool MLocalePrivate::FormatterStoreKey::operator==(const FormatterStoreKey &other) const
+{
+    if (hash != other.hash || timeFormat24h != other.timeFormat24h
+        || thread != other.thread || dataPathsSerial != other.dataPathsSerial)
+        return false;
+    for (int i = MLocale::MLcMessages; i <= MLocale::MLcTelephone; ++i) {
+        if (identifiers[i] != other.identifiers[i])
+            return false;
+    }
+    return true;
+}
+
+MLocalePrivate::FormatterStore::FormatterStore(const FormatterStoreKey &key)
+    : key(key),
+      refCount(0),
+      dateFormatCache(MLocale::DateFormatCache),
+      simpleDateFormatCache(MLocale::SimpleDateFormatCache),
+      posixFormatPlanCache(MLocale::PosixFormatCache),
+      precisionNumberFormatCache(MLocale::PrecisionNumberFormatCache),
+      percentNumberFormatCache(MLocale::PercentNumberFormatCache),
+      currencyNumberFormatCache(MLocale::CurrencyNumberFormatCache),
+      scratchCalendarsTimeZoneSerial(0),
+      incrementalDateFormatCache(MLocale::IncrementalDateFormatCache),
+      patternCache(MLocale::PatternCache),
+      patternGeneratorCache(MLocale::PatternGeneratorCache),
+      collator(0),
+      hasExemplarCharactersIndex(false),
+      prepared(0)
+{
+    memset(posixRepresentationFormats, 0, sizeof(posixRepresentationFormats));
+    memset(scratchCalendars, 0, sizeof(scratchCalendars));
+}
+
+MLocalePrivate::FormatterStore::~FormatterStore()
+{
+    dropScratchCalendars();
+    dropPosixRepresentationFormats();
+    delete collator;
+    delete prepared.fetchAndStoreAcquire(0);
+}
+
+void MLocalePrivate::FormatterStore::adoptPrepared()
+{
+    PreparedFormatters *batch = prepared.fetchAndStoreAcquire(0);
+    // the newest batch comes first, adopt the oldest first. Prepared
+    // formatters never evict what is cached already, those which do
+    // not fit into the free capacity of a cache are dropped:
+    QList<PreparedFormatters *> batches;
+    for (PreparedFormatters *b = batch; b; b = b->next)
+        batches.prepend(b);
+    foreach (PreparedFormatters *b, batches) { // krazy:exclude=foreach
+        for (int i = 0; i < b->dateFormats.size(); ++i) {
+            const QPair<DateFormatKey, icu::DateFormat *> &entry = b->dateFormats.at(i);
+            const int bytes = approximateSize(entry.second);
+            if (dateFormatCache.contains(entry.first) || bytes > dateFormatCache.freeCapacity())
+                delete entry.second;
+            else
+                dateFormatCache.insert(entry.first, entry.second, bytes);
+        }
+        b->dateFormats.clear();
+        for (int i = 0; i < b->precisionNumberFormats.size(); ++i) {
+            const QPair<qint64, icu::NumberFormat *> &entry = b->precisionNumberFormats.at(i);
+            if (precisionNumberFormatCache.contains(entry.first)
+                || NumberFormatSize > precisionNumberFormatCache.freeCapacity())
+                delete entry.second;
+            else
+                precisionNumberFormatCache.insert(entry.first, entry.second, NumberFormatSize);
+        }
+        b->precisionNumberFormats.clear();
+        for (int i = 0; i < b->percentNumberFormats.size(); ++i) {
+            const QPair<int, icu::NumberFormat *> &entry = b->percentNumberFormats.at(i);
+            if (percentNumberFormatCache.contains(entry.first)
+                || NumberFormatSize > percentNumberFormatCache.freeCapacity())
+                delete entry.second;
+            else
+                percentNumberFormatCache.insert(entry.first, entry.second, NumberFormatSize);
+        }
+        b->percentNumberFormats.clear();
+        if (b->collator && !collator) {
+            collator = b->collator;
+            b->collator = 0;
+        }
+        if (b->hasExemplarCharactersIndex && !hasExemplarCharactersIndex) {
+            exemplarCharactersIndex = b->exemplarCharactersIndex;
+            hasExemplarCharactersIndex = true;
+        }
+    }
+    delete batch;
+}
+
+MLocalePrivate::PreparedFormatters::PreparedFormatters()
+    : collator(0),
+      hasExemplarCharactersIndex(false),
+      next(0)
+{
+}
+
+MLocalePrivate::PreparedFormatters::~PreparedFormatters()
+{
+    for (int i = 0; i < dateFormats.size(); ++i)
+        delete dateFormats.at(i).second;
+    for (int i = 0; i < precisionNumberFormats.size(); ++i)
+        delete precisionNumberFormats.at(i).second;
+    for (int i = 0; i < percentNumberFormats.size(); ++i)
+        delete percentNumberFormats.at(i).second;
+    delete collator;
+    delete next;
+}
+
+void MLocalePrivate::prepareFormatters(MLocale::PrepareFlags flags) const
+{
+    PreparedFormatters *batch = new PreparedFormatters;
+    if (flags & MLocale::PrepareDateFormats) {
+        // formatDateTime() is mostly called with the default
+        // calendar type, calendars of the locale have its type:
+        QList<MLocale::CalendarType> calendarTypes;
+        calendarTypes << MLocale::DefaultCalendar;
+        const MLocale::CalendarType localeCalendarType =
+            MIcuConversions::parseCalendarOption(categoryName(MLocale::MLcTime));
+        if (localeCalendarType != MLocale::DefaultCalendar)
+            calendarTypes << localeCalendarType;
+        // don't create more than the whole cache can take, e.g.
+        // formatters for the Hebrew calendar are several 100 KB each:
+        int bytesLeft = MFormatterCacheCounters::capacity(MLocale::DateFormatCache);
+        foreach (MLocale::CalendarType calendarType, calendarTypes) { // krazy:exclude=foreach
+            for (int dateType = MLocale::DateNone; dateType <= MLocale::DateFull; ++dateType) {
+                for (int timeType = MLocale::TimeNone; timeType <= MLocale::TimeFull; ++timeType) {
+                    if (dateType == MLocale::DateNone && timeType == MLocale::TimeNone)
+                        continue;
+                    if (bytesLeft <= 0)
+                        break;
+                    const MLocale::DateType date = static_cast<MLocale::DateType>(dateType);
+                    const MLocale::TimeType time = static_cast<MLocale::TimeType>(timeType);
+                    icu::DateFormat *df = newDateFormat(date, time, calendarType, _timeFormat24h);
+                    if (!df)
+                        continue;
+                    const int bytes = approximateSize(df);
+                    if (bytes > bytesLeft) {
+                        delete df;
+                        bytesLeft = 0;
+                        break;
+                    }
+                    bytesLeft -= bytes;
+                    batch->dateFormats.append(qMakePair(
+                        DateFormatKey(this, date, time, calendarType, _timeFormat24h), df));
+                }
+            }
+        }
+    }
+    if (flags & MLocale::PrepareNumberFormats) {
+        for (int precision = 0; precision <= 2; ++precision) {
+            // formatNumber(double, int) formats with a minimum of 0
+            icu::NumberFormat *nf = newPrecisionNumberFormat(precision, 0);
+            if (nf)
+                batch->precisionNumberFormats.append(qMakePair(qint64(precision) << 32, nf));
+            nf = newPercentNumberFormat(precision);
+            if (nf)
+                batch->percentNumberFormats.append(qMakePair(precision, nf));
+        }
+    }
+    if (flags & MLocale::PrepareCollator)
+        batch->collator = newCollator();
+    if (flags & MLocale::PrepareIndexBuckets) {
+        batch->exemplarCharactersIndex =
+            lookupExemplarCharactersIndex(categoryName(MLocale::MLcCollate));
+        batch->hasExemplarCharactersIndex = true;
+    }
+
+    // publish, keeping what has been published before and is not
+    // adopted yet:
+    PreparedFormatters *previous = _formatters->prepared.loadAcquire();
+    do {
+        batch->next = previous;
+    } while (!_formatters->prepared.testAndSetOrdered(previous, batch, previous));
+}
+
+MLocalePrivate::FormatterStore *MLocalePrivate::formatters() const
+{
+    // the formatters of the store were made from the old ICU data:
+    if (_formatters->key.dataPathsSerial != _dataPathsSerial.loadAcquire())
+        const_cast<MLocalePrivate *>(this)->updateFormatterStore();
+    if (_formatters->prepared.loadAcquire())
+        _formatters->adoptPrepared();
+    return _formatters;
+}
+
+const icu::Collator *MLocalePrivate::cachedCollator() const
+{
+    FormatterStore *store = formatters();
+    if (!store->collator)
+        store->collator = newCollator();
+    return store->collator;
+}
+
+icu::Collator *MLocalePrivate::newCollator() const
+{
+    UErrorCode status = U_ZERO_ERROR;
+    icu::Collator *collator =
+        icu::Collator::createInstance(getCategoryLocale(MLocale::MLcCollate), status);
+    if (U_FAILURE(status)) {
+        qWarning() << "icu::Collator::createInstance() failed with error"
+                   << u_errorName(status);
+        delete collator;
+        return 0;
+    }
+    collator->setStrength(icu::Collator::QUATERNARY);
+    return collator;
+}
+
+const QStringList &MLocalePrivate::cachedExemplarCharactersIndex() const
+{
+    FormatterStore *store = formatters();
+    if (!store->hasExemplarCharactersIndex) {
+        store->exemplarCharactersIndex =
+            lookupExemplarCharactersIndex(categoryName(MLocale::MLcCollate));
+        store->hasExemplarCharactersIndex = true;
+    }
+    return store->exemplarCharactersIndex;
+}
+
+namespace
+{
+    // the formatter stores of the process which are in use, see
+    // MLocalePrivate::acquireFormatterStore()
+    struct MFormatterStoreRegistry
+    {
+        QMutex mutex;
+        QHash<MLocalePrivate::FormatterStoreKey, MLocalePrivate::FormatterStore *> stores;
+    };
+}
+
+Q_GLOBAL_STATIC(MFormatterStoreRegistry, formatterStoreRegistry)
+
+MLocalePrivate::FormatterStore *MLocalePrivate::acquireFormatterStore(const FormatterStoreKey &key)
+{
+    MFormatterStoreRegistry *registry = formatterStoreRegistry();
+    if (!registry) {
+        // only during the destruction of the process, don’t share
+        FormatterStore *store = new FormatterStore(key);
+        store->refCount = 1;
+        return store;
+    }
+    QMutexLocker locker(&registry->mutex);
+    FormatterStore *&store = registry->stores[key];
+    if (!store)
+        store = new FormatterStore(key);
+    ++store->refCount;
+    return store;
+}
+
+void MLocalePrivate::releaseFormatterStore(FormatterStore *store)
+{
+    if (!store)
+        return;
+    MFormatterStoreRegistry *registry = formatterStoreRegistry();
+    if (!registry) {
+        if (--store->refCount == 0)
+            delete store;
+        return;
+    }
+    QMutexLocker locker(&registry->mutex);
+    if (--store->refCount > 0)
+        return;
+    // a store created while the registry was gone is not listed:
+    QHash<FormatterStoreKey, FormatterStore *>::iterator it = registry->stores.find(store->key);
+    if (it != registry->stores.end() && it.value() == store)
+        registry->stores.erase(it);
+    locker.unlock();
+    delete store;
+}
+
+void MLocalePrivate::updateFormatterStore()
+{
+    const FormatterStoreKey key(this);
+    if (_formatters && _formatters->key == key)
+        return;
+    FormatterStore *store = acquireFormatterStore(key);
+    FormatterStore *previous = _formatters;
+    {
+        // MLocale::cacheStatistics() reads _formatters of the
+        // privates of other threads under the registry mutex:
+        MFormatterStoreRegistry *registry = formatterStoreRegistry();
+        QMutexLocker locker(registry ? &registry->mutex : 0);
+        _formatters = store;
+    }
+    releaseFormatterStore(previous);
+}
+#endif
+
+// Constructors
+
+MLocalePrivate::Profile::Profile()
+    : timeIsRtl(false),
+      messagesIsRtl(false),
+      mixingSymbolsWanted(false),
+      numericNeedsRtlFixup(false)
+{
+}
+
+MLocalePrivate::MLocalePrivate()
+    : _ownerThread(QThread::currentThreadId()),
+      _valid(true),
+      _timeFormat24h(MLocale::LocaleDefaultTimeFormat24h),
+      _phoneNumberGrouping( MLocale::DefaultPhoneNumberGrouping ),
+#ifdef HAVE_ICU
+      _numberFormat(0),
+      _numberFormatLcTime(0),
+      _formatters(0),
+#endif
+      pCurrentLanguage(0),
+      pCurrentLcTime(0),
+      pCurrentLcTimeFormat24h(0),
+      pCurrentLcCollate(0),
+      pCurrentLcNumeric(0),
+      pCurrentLcMonetary(0),
+      pCurrentLcTelephone(0),
+#ifdef HAVE_ICU
+      _pDateTimeCalendar(0),
+#endif
+      q_ptr(0)
+{
+    lmlDebug( "MLocalePrivate ctor called" );
+
+    updateLocaleIdentifiers();
+
+    if (translationPaths.isEmpty())
+    {
+#ifdef Q_OS_WIN
+        // walk to translation dir relative to bin dir
+        QDir appDir(QCoreApplication::applicationDirPath());
+
+	appDir.cdUp();
+	appDir.cd("share");
+	appDir.cd("l10n");
+	appDir.cd("meegotouch");
+
+        translationPaths = (QStringList() << appDir.absolutePath());
+#else
+        translationPaths = (QStringList() << QString(TRANSLATION_DIR));
+#endif
+    }
+
+    if (dataPaths.isEmpty())
+        MLocale::setDataPath(ML_ICUEXTRADATA_DIR);
+}
+
+// copy constructor
+MLocalePrivate::MLocalePrivate(const MLocalePrivate &other)
+    : _ownerThread(QThread::currentThreadId()),
+      _valid(other._valid),
+      _defaultLocale(other._defaultLocale),
+      _messageLocale(other._messageLocale),
+      _numericLocale(other._numericLocale),
+      _collationLocale(other._collationLocale),
+      _calendarLocale(other._calendarLocale),
+      _monetaryLocale(other._monetaryLocale),
+      _nameLocale(other._nameLocale),
+      _telephoneLocale(other._telephoneLocale),
+      _defaultIdentifier(other._defaultIdentifier),
+      _profile(other._profile),
+      _validCountryCodes( other._validCountryCodes ),
+      _timeFormat24h(other._timeFormat24h),
+      _phoneNumberGrouping( other._phoneNumberGrouping ),
+#ifdef HAVE_ICU
+      _numberFormat(0),
+      _numberFormatLcTime(0),
+      _formatters(0),
+#endif
+      _messageTranslations(other._messageTranslations),
+      _timeTranslations(other._timeTranslations),
+      _trTranslations(other._trTranslations),
+
+      pCurrentLanguage(0),
+      pCurrentLcTime(0),
       pCurrentLcTimeFormat24h(0),
       pCurrentLcCollate(0),
       pCurrentLcNumeric(0),
@@ -1076,10 +2193,15 @@ MLocalePrivate::MLocalePrivate(const MLocalePrivate &other)
 #endif
       q_ptr(0)
 {
+    for (int i = MLocale::MLcMessages; i <= MLocale::MLcTelephone; ++i) {
+        _categoryIdentifiers[i] = other._categoryIdentifiers[i];
+    }
 #ifdef HAVE_ICU
+    updateFormatterStore();
     if (other._numberFormat != 0) {
         _numberFormat = static_cast<icu::NumberFormat *>((other._numberFormat)->clone());
     }
+    _integerFormatSymbols = other.integerFormatSymbols();
     if (other._numberFormatLcTime != 0) {
         _numberFormatLcTime = static_cast<icu::NumberFormat *>((other._numberFormatLcTime)->clone());
     }
@@ -1088,14 +2210,18 @@ MLocalePrivate::MLocalePrivate(const MLocalePrivate &other)
 
 MLocalePrivate::~MLocalePrivate()
 {
+    dropThreadPrivates();
 #ifdef HAVE_ICU
     delete _numberFormat;
     delete _numberFormatLcTime;
+    dropParsers();
     // note: if tr translations are inserted into QCoreApplication
     // deleting the QTranslator removes them from the QCoreApplication
 
     delete _pDateTimeCalendar;
     _pDateTimeCalendar = 0;
+    releaseFormatterStore(_formatters);
+    _formatters = 0;
 #endif
 
     delete pCurrentLanguage;
@@ -1109,6 +2235,7 @@ MLocalePrivate::~MLocalePrivate()
 
 MLocalePrivate &MLocalePrivate::operator=(const MLocalePrivate &other)
 {
+    dropThreadPrivates();
     _valid = other._valid;
     _defaultLocale = other._defaultLocale;
     _messageLocale = other._messageLocale;
@@ -1123,6 +2250,11 @@ MLocalePrivate &MLocalePrivate::operator=(const MLocalePrivate &other)
     _trTranslations = other._trTranslations;
     _validCountryCodes = other._validCountryCodes;
     _telephoneLocale = other._telephoneLocale;
+    _defaultIdentifier = other._defaultIdentifier;
+    for (int i = MLocale::MLcMessages; i <= MLocale::MLcTelephone; ++i) {
+        _categoryIdentifiers[i] = other._categoryIdentifiers[i];
+    }
+    _profile = other._profile;
 
 #ifdef HAVE_ICU
     delete _numberFormat;
@@ -1134,12 +2266,15 @@ MLocalePrivate &MLocalePrivate::operator=(const MLocalePrivate &other)
     } else {
         _numberFormat = 0;
     }
+    _integerFormatSymbols = other.integerFormatSymbols();
     if (other._numberFormatLcTime) {
         _numberFormatLcTime = static_cast<icu::NumberFormat *>((other._numberFormatLcTime)->clone());
 
     } else {
         _numberFormatLcTime = 0;
     }
+    updateFormatterStore();
+    dropParsers();
 #endif
 
     return *this;
@@ -1147,6 +2282,7 @@ MLocalePrivate &MLocalePrivate::operator=(const MLocalePrivate &other)
 
 void MLocalePrivate::dropCaches()
 {
+    dropThreadPrivates();
 #ifdef HAVE_ICU
     // call this function when the MLocale has changed so that
     // cached data cannot be used any more
@@ -1158,11 +2294,248 @@ void MLocalePrivate::dropCaches()
         _pDateTimeCalendar = 0;
     }
 
-    // drop cached formatString conversions
-    _icuFormatStringCache.clear();
+    // the formatters stay valid as long as the configuration does,
+    // move to the store of the new one if it has changed:
+    updateFormatterStore();
+    dropParsers();
 #endif
 }
 
+namespace
+{
+    // the privates which have a copy for a thread, keyed by thread,
+    // see MLocalePrivate::forCurrentThread()
+    struct MThreadPrivatesRegistry
+    {
+        QMutex mutex;
+        QHash<Qt::HANDLE, QSet<const MLocalePrivate *> > owners;
+    };
+
+    // deletes the copies of a thread when the thread finishes
+    struct MThreadPrivatesReaper
+    {
+        explicit MThreadPrivatesReaper(Qt::HANDLE thread) : thread(thread) {}
+        ~MThreadPrivatesReaper();
+
+        Qt::HANDLE thread;
+    };
+}
+
+Q_GLOBAL_STATIC(MThreadPrivatesRegistry, threadPrivatesRegistry)
+Q_GLOBAL_STATIC(QThreadStorage<MThreadPrivatesReaper *>, threadPrivatesReapers)
+
+MThreadPrivatesReaper::~MThreadPrivatesReaper()
+{
+    MThreadPrivatesRegistry *registry = threadPrivatesRegistry();
+    if (!registry)
+        return;
+    QList<MLocalePrivate *> threadPrivates;
+    {
+        QMutexLocker registryLocker(&registry->mutex);
+        const QSet<const MLocalePrivate *> owners = registry->owners.take(thread);
+        foreach (const MLocalePrivate *owner, owners) { // krazy:exclude=foreach
+            QWriteLocker locker(&owner->_threadPrivatesLock);
+            threadPrivates.append(owner->_threadPrivates.take(thread));
+        }
+    }
+    qDeleteAll(threadPrivates);
+}
+
+const MLocalePrivate *MLocalePrivate::forCurrentThread() const
+{
+    const Qt::HANDLE thread = QThread::currentThreadId();
+    if (thread == _ownerThread)
+        return this;
+
+    {
+        QReadLocker locker(&_threadPrivatesLock);
+        const MLocalePrivate *threadPrivate = _threadPrivates.value(thread);
+        if (threadPrivate)
+            return threadPrivate;
+    }
+
+    // only the calling thread adds a private for itself, i.e. no
+    // other thread can have added one meanwhile:
+    MLocalePrivate *threadPrivate = new MLocalePrivate(*this);
+    threadPrivate->q_ptr = q_ptr;
+    // the copy is deleted when the thread finishes, short lived
+    // threads of a pool do not pile up copies:
+    QThreadStorage<MThreadPrivatesReaper *> *reapers = threadPrivatesReapers();
+    MThreadPrivatesRegistry *registry = reapers ? threadPrivatesRegistry() : 0;
+    if (registry && !reapers->hasLocalData())
+        reapers->setLocalData(new MThreadPrivatesReaper(thread));
+    // same locking order as dropThreadPrivates():
+    QMutexLocker registryLocker(registry ? &registry->mutex : 0);
+    if (registry)
+        registry->owners[thread].insert(this);
+    QWriteLocker locker(&_threadPrivatesLock);
+    _threadPrivates.insert(thread, threadPrivate);
+    return threadPrivate;
+}
+
+void MLocalePrivate::dropThreadPrivates()
+{
+    {
+        QReadLocker locker(&_threadPrivatesLock);
+        if (_threadPrivates.isEmpty())
+            return;
+    }
+    QList<MLocalePrivate *> threadPrivates;
+    {
+        // same locking order as ~MThreadPrivatesReaper():
+        MThreadPrivatesRegistry *registry = threadPrivatesRegistry();
+        QMutexLocker registryLocker(registry ? &registry->mutex : 0);
+        QWriteLocker locker(&_threadPrivatesLock);
+        if (registry) {
+            QHash<Qt::HANDLE, MLocalePrivate *>::const_iterator it = _threadPrivates.constBegin();
+            for (; it != _threadPrivates.constEnd(); ++it) {
+                QHash<Qt::HANDLE, QSet<const MLocalePrivate *> >::iterator owners
+                    = registry->owners.find(it.key());
+                if (owners != registry->owners.end()) {
+                    owners->remove(this);
+                    if (owners->isEmpty())
+                        registry->owners.erase(owners);
+                }
+            }
+        }
+        threadPrivates = _threadPrivates.values();
+        _threadPrivates.clear();
+    }
+    qDeleteAll(threadPrivates);
+}
+
+const MFormatterCacheCounters *MLocalePrivate::formatterCache(MLocale::FormatterCache type) const
+{
+#ifdef HAVE_ICU
+    switch (type) {
+    case MLocale::DateFormatCache:
+        return &_formatters->dateFormatCache;
+    case MLocale::SimpleDateFormatCache:
+        return &_formatters->simpleDateFormatCache;
+    case MLocale::PosixFormatCache:
+        return &_formatters->posixFormatPlanCache;
+    case MLocale::PrecisionNumberFormatCache:
+        return &_formatters->precisionNumberFormatCache;
+    case MLocale::PercentNumberFormatCache:
+        return &_formatters->percentNumberFormatCache;
+    case MLocale::CurrencyNumberFormatCache:
+        return &_formatters->currencyNumberFormatCache;
+    case MLocale::IncrementalDateFormatCache:
+        return &_formatters->incrementalDateFormatCache;
+    case MLocale::PatternCache:
+        return &_formatters->patternCache;
+    case MLocale::PatternGeneratorCache:
+        return &_formatters->patternGeneratorCache;
+    }
+#else
+    Q_UNUSED(type);
+#endif
+    return 0;
+}
+
+#ifdef HAVE_ICU
+icu::NumberFormat *MLocalePrivate::precisionNumberFormat(int maxPrecision, int minPrecision) const
+{
+    minPrecision = qBound(0, minPrecision, maxPrecision);
+    // the store is specific to the numeric category, i.e. the
+    // precision alone is sufficient as the key:
+    const qint64 key = (qint64(maxPrecision) << 32) | quint32(minPrecision);
+    FormatterStore *store = formatters();
+    icu::NumberFormat *nf = store->precisionNumberFormatCache.object(key);
+    if (nf)
+        return nf;
+    nf = newPrecisionNumberFormat(maxPrecision, minPrecision);
+    if (nf)
+        store->precisionNumberFormatCache.insert(key, nf, NumberFormatSize);
+    return nf;
+}
+
+icu::NumberFormat *MLocalePrivate::newPrecisionNumberFormat(int maxPrecision, int minPrecision) const
+{
+    icu::NumberFormat *nf;
+    if (_numberFormat) {
+        nf = static_cast<icu::NumberFormat *>(_numberFormat->clone());
+    } else {
+        UErrorCode status = U_ZERO_ERROR;
+        nf = icu::NumberFormat::createInstance(
+            icu::Locale(qPrintable(categoryNameForNumbers(MLocale::MLcNumeric))),
+            status);
+        if (!U_SUCCESS(status)) {
+            qWarning() << "NumberFormat creating failed" << u_errorName(status);
+            delete nf;
+            return 0;
+        }
+    }
+    if (!nf)
+        return 0;
+    nf->setMaximumFractionDigits(maxPrecision);
+    nf->setMinimumFractionDigits(minPrecision);
+    return nf;
+}
+#endif
+
+#ifdef HAVE_ICU
+icu::NumberFormat *MLocalePrivate::percentNumberFormat(int decimals) const
+{
+    FormatterStore *store = formatters();
+    icu::NumberFormat *nf = store->percentNumberFormatCache.object(decimals);
+    if (nf)
+        return nf;
+    nf = newPercentNumberFormat(decimals);
+    if (nf)
+        store->percentNumberFormatCache.insert(decimals, nf, NumberFormatSize);
+    return nf;
+}
+
+icu::NumberFormat *MLocalePrivate::newPercentNumberFormat(int decimals) const
+{
+    icu::Locale numericLocale =
+        icu::Locale(qPrintable(categoryNameForNumbers(MLocale::MLcNumeric)));
+    UErrorCode status = U_ZERO_ERROR;
+    icu::NumberFormat *nf = icu::NumberFormat::createPercentInstance(numericLocale, status);
+    if (!U_SUCCESS(status)) {
+        qWarning() << "NumberFormat creating failed" << u_errorName(status);
+        delete nf;
+        return 0;
+    }
+
+    nf->setMinimumFractionDigits(decimals);
+    return nf;
+}
+#endif
+
+#ifdef HAVE_ICU
+icu::NumberFormat *MLocalePrivate::currencyNumberFormat(const QString &currency) const
+{
+    icu::NumberFormat *nf = formatters()->currencyNumberFormatCache.object(currency);
+    if (nf)
+        return nf;
+
+    icu::Locale monetaryLocale =
+        icu::Locale(qPrintable(categoryNameForNumbers(MLocale::MLcMonetary)));
+    UErrorCode status = U_ZERO_ERROR;
+    nf = icu::NumberFormat::createCurrencyInstance(monetaryLocale, status);
+    if (!U_SUCCESS(status)) {
+        qWarning() << "icu::NumberFormat::createCurrencyInstance failed with error"
+                   << u_errorName(status);
+        delete nf;
+        return 0;
+    }
+
+    icu::UnicodeString currencyString = MIcuConversions::qStringToUnicodeString(currency);
+    nf->setCurrency(currencyString.getTerminatedBuffer(), status);
+    if (!U_SUCCESS(status)) {
+        qWarning() << "icu::NumberFormat::setCurrency failed with error"
+                   << u_errorName(status);
+        delete nf;
+        return 0;
+    }
+
+    formatters()->currencyNumberFormatCache.insert(currency, nf, NumberFormatSize);
+    return nf;
+}
+#endif
+
 bool MLocalePrivate::isValidCountryCode( const QString& code ) const
 {
 
@@ -1586,11 +2959,29 @@ void MLocalePrivate::setCategoryLocale(MLocale *mlocale,
         _messageLocale = localeName;
     } else if (category == MLocale::MLcTime) {
         _calendarLocale = localeName;
+    } else if (category == MLocale::MLcNumeric) {
+        _numericLocale = localeName;
+    } else if (category == MLocale::MLcCollate) {
+        _collationLocale = localeName;
+    } else if (category == MLocale::MLcMonetary) {
+        _monetaryLocale = localeName;
+    } else if (category == MLocale::MLcName) {
+        _nameLocale = localeName;
+    } else if (category == MLocale::MLcTelephone) {
+        _telephoneLocale = localeName;
+    } else {
+        //mDebug("MLocalePrivate") << "unimplemented category change"; // DEBUG
+        return;
+    }
+
+    updateLocaleIdentifiers();
+
+    if (category == MLocale::MLcTime) {
 #ifdef HAVE_ICU
         // recreate the number formatter
         delete _numberFormatLcTime;
         QString categoryNameTime =
-            fixCategoryNameForNumbers(categoryName(MLocale::MLcTime));
+            categoryNameForNumbers(MLocale::MLcTime);
         icu::Locale timeLocale = icu::Locale(qPrintable(categoryNameTime));
         UErrorCode status = U_ZERO_ERROR;
         _numberFormatLcTime = icu::NumberFormat::createInstance(timeLocale, status);
@@ -1600,12 +2991,11 @@ void MLocalePrivate::setCategoryLocale(MLocale *mlocale,
         }
 #endif
     } else if (category == MLocale::MLcNumeric) {
-        _numericLocale = localeName;
 #ifdef HAVE_ICU
         // recreate the number formatters
         delete _numberFormat;
         QString categoryNameNumeric =
-            fixCategoryNameForNumbers(categoryName(MLocale::MLcNumeric));
+            categoryNameForNumbers(MLocale::MLcNumeric);
         icu::Locale numericLocale = icu::Locale(qPrintable(categoryNameNumeric));
         UErrorCode status = U_ZERO_ERROR;
         _numberFormat = icu::NumberFormat::createInstance(numericLocale, status);
@@ -1613,9 +3003,10 @@ void MLocalePrivate::setCategoryLocale(MLocale *mlocale,
             mDebug("MLocalePrivate") << "Unable to create number format for LcNumeric" << u_errorName(status);
             _valid = false;
         }
+        _integerFormatSymbols = IntegerFormatSymbols();
         delete _numberFormatLcTime;
         QString categoryNameTime =
-            fixCategoryNameForNumbers(categoryName(MLocale::MLcTime));
+            categoryNameForNumbers(MLocale::MLcTime);
         icu::Locale timeLocale = icu::Locale(qPrintable(categoryNameTime));
         status = U_ZERO_ERROR;
         _numberFormatLcTime = icu::NumberFormat::createInstance(timeLocale, status);
@@ -1624,14 +3015,7 @@ void MLocalePrivate::setCategoryLocale(MLocale *mlocale,
             _valid = false;
         }
 #endif
-    } else if (category == MLocale::MLcCollate) {
-        _collationLocale = localeName;
-    } else if (category == MLocale::MLcMonetary) {
-        _monetaryLocale = localeName;
-    } else if (category == MLocale::MLcName) {
-        _nameLocale = localeName;
     } else if (category == MLocale::MLcTelephone) {
-        _telephoneLocale = localeName;
         // here we set the phone number grouping depending on the
         // setting in the gconf key
         if ( _telephoneLocale.startsWith( QLatin1String( "en_US" ) ) ) {
@@ -1639,64 +3023,149 @@ void MLocalePrivate::setCategoryLocale(MLocale *mlocale,
         } else {
             _phoneNumberGrouping = MLocale::NoPhoneNumberGrouping;
         }
-    } else {
-        //mDebug("MLocalePrivate") << "unimplemented category change"; // DEBUG
     }
 }
 
-bool MLocalePrivate::parseIcuLocaleString(const QString &localeString, QString *language, QString *script, QString *country, QString *variant)
+namespace
 {
-    // A ICU locale string looks like this:
-    //     aa_Bbbb_CC_DDDDDD@foo=fooval;bar=barval;
-    // see also http://userguide.icu-project.org/locale
-    // The country part is usually a 2 letter uppercase code
-    // as in the above example, but there is the exception
-    // es_419, i.e. Spanish in Latin America where the “country code”
-    // is “419”.
-    QRegularExpression regexp("^([a-z]{2,3})(?:_([A-Z][a-z]{3,3}))?(?:_([A-Z]{2,2}|419))?(?:_{1,2}([A-Z][A-Z_]*))?(?:@.*)?$");
-    QRegularExpressionMatch match = regexp.match(localeString);
+    // process wide table of parsed locale identifiers,
+    // see MLocalePrivate::internLocaleIdentifier()
+    struct MLocaleIdentifierTable
+    {
+        ~MLocaleIdentifierTable()
+        {
+            qDeleteAll(identifiers);
+        }
 
-    if (match.hasMatch() && match.capturedTexts().size() == 5) {
-        *language = match.captured(1);
-        *script = match.captured(2);
-        *country = match.captured(3);
-        *variant = match.captured(4);
-        return true;
-    } else {
-        *language = "";
-        *script = "";
-        *country = "";
-        *variant= "";
-        return false;
+        QMutex mutex;
+        QHash<QString, const MLocaleIdentifier *> identifiers;
+    };
+}
+
+Q_GLOBAL_STATIC(MLocaleIdentifierTable, localeIdentifierTable)
+
+const MLocaleIdentifier *MLocalePrivate::internLocaleIdentifier(const QString &localeName)
+{
+    MLocaleIdentifierTable *table = localeIdentifierTable();
+    QMutexLocker locker(&table->mutex);
+    const MLocaleIdentifier *&identifier = table->identifiers[localeName];
+    if (!identifier)
+        identifier = new MLocaleIdentifier(localeName);
+    return identifier;
+}
+
+const MLocaleIdentifier *MLocalePrivate::categoryIdentifier(MLocale::Category category) const
+{
+    return _categoryIdentifiers[category];
+}
+
+const QString &MLocalePrivate::categoryNameForNumbers(MLocale::Category category) const
+{
+    return _profile.categoryNamesForNumbers[category];
+}
+
+QString MLocalePrivate::categoryNameForCalendar(MLocale::Category category,
+                                                MLocale::CalendarType calendarType) const
+{
+#ifdef HAVE_ICU
+    // the time and messages names are needed for every date format
+    // and are precomputed, the other categories are rarely asked for:
+    if (category == MLocale::MLcTime)
+        return _profile.timeNamesForCalendar[calendarType];
+    if (category == MLocale::MLcMessages)
+        return _profile.messagesNamesForCalendar[calendarType];
+    return fixCategoryNameForNumbers(
+        MIcuConversions::setCalendarOption(categoryName(category), calendarType));
+#else
+    Q_UNUSED(calendarType);
+    return categoryName(category);
+#endif
+}
+
+void MLocalePrivate::updateLocaleIdentifiers()
+{
+    _defaultIdentifier = internLocaleIdentifier(_defaultLocale);
+    for (int i = MLocale::MLcMessages; i <= MLocale::MLcTelephone; ++i) {
+        _categoryIdentifiers[i] =
+            internLocaleIdentifier(categoryName(static_cast<MLocale::Category>(i)));
+    }
+    // fixCategoryNameForNumbers() needs the identifier of the
+    // numeric category, i.e. this has to be done afterwards:
+    Profile &profile = _profile;
+    for (int i = MLocale::MLcMessages; i <= MLocale::MLcTelephone; ++i) {
+        profile.categoryNamesForNumbers[i] =
+            fixCategoryNameForNumbers(categoryName(static_cast<MLocale::Category>(i)));
+    }
+
+    const QString categoryNameTime = categoryName(MLocale::MLcTime);
+    const QString categoryNameMessages = categoryName(MLocale::MLcMessages);
+#ifdef HAVE_ICU
+    for (int i = MLocale::DefaultCalendar; i <= MLocale::EthiopicCalendar; ++i) {
+        const MLocale::CalendarType calendarType = static_cast<MLocale::CalendarType>(i);
+        profile.timeNamesForCalendar[i] = fixCategoryNameForNumbers(
+            MIcuConversions::setCalendarOption(categoryNameTime, calendarType));
+        profile.messagesNamesForCalendar[i] = fixCategoryNameForNumbers(
+            MIcuConversions::setCalendarOption(categoryNameMessages, calendarType));
     }
+#endif
+
+    // the names are still empty when called from the constructor,
+    // don’t load ICU data for them before the data paths are set:
+    profile.timeScript = categoryNameTime.isEmpty()
+        ? QString() : MLocale::localeScript(categoryNameTime);
+    profile.messagesScript = categoryNameMessages.isEmpty()
+        ? QString() : MLocale::localeScript(categoryNameMessages);
+    profile.timeIsRtl = profile.timeScript == QLatin1String("Arab")
+        || profile.timeScript == QLatin1String("Hebr");
+    profile.messagesIsRtl = profile.messagesScript == QLatin1String("Arab")
+        || profile.messagesScript == QLatin1String("Hebr");
+#ifdef HAVE_ICU
+    profile.mixingSymbolsWanted =
+        mixingSymbolsWanted(categoryNameMessages, categoryNameTime,
+                            profile.messagesIsRtl, profile.timeIsRtl);
+#endif
+
+    // only numbers formatted for Arabic and Persian may need the
+    // formatting codes removed and prefix and postfix swapped:
+    const QString categoryNameNumeric = categoryName(MLocale::MLcNumeric);
+    profile.numericNeedsRtlFixup =
+        categoryNameNumeric.startsWith(QLatin1String("ar"))
+        || categoryNameNumeric.startsWith(QLatin1String("fa"));
+
+#ifdef HAVE_ICU
+    updateFormatterStore();
+#endif
+}
+
+bool MLocalePrivate::parseIcuLocaleString(const QString &localeString, QString *language, QString *script, QString *country, QString *variant)
+{
+    // see MLocaleIdentifier for the syntax of ICU locale strings
+    MLocaleIdentifier identifier(localeString);
+    *language = identifier.language();
+    *script = identifier.script();
+    *country = identifier.country();
+    *variant = identifier.variant();
+    return identifier.isValid();
 }
 
 QString MLocalePrivate::parseLanguage(const QString &localeString)
 {
-    QString language, script, country, variant;
-    parseIcuLocaleString(localeString, &language, &script, &country, &variant);
-    return language;
+    return MLocaleIdentifier(localeString).language();
 }
 
 QString MLocalePrivate::parseCountry(const QString &localeString)
 {
-    QString language, script, country, variant;
-    parseIcuLocaleString(localeString, &language, &script, &country, &variant);
-    return country;
+    return MLocaleIdentifier(localeString).country();
 }
 
 QString MLocalePrivate::parseScript(const QString &localeString)
 {
-    QString language, script, country, variant;
-    parseIcuLocaleString(localeString, &language, &script, &country, &variant);
-    return script;
+    return MLocaleIdentifier(localeString).script();
 }
 
 QString MLocalePrivate::parseVariant(const QString &localeString)
 {
-    QString language, script, country, variant;
-    parseIcuLocaleString(localeString, &language, &script, &country, &variant);
-    return variant;
+    return MLocaleIdentifier(localeString).variant();
 }
 
 QString MLocalePrivate::removeAccents(const QString &str)
@@ -2005,6 +3474,7 @@ MLocale::MLocale(const QString &localeName, QObject *parent)
     Q_D(MLocale);
     d->q_ptr = this;
     d->_defaultLocale = qPrintable(localeName);
+    d->updateLocaleIdentifiers();
     // If a system default locale exists already copy the translation
     // catalogs and reload them for this locale:
     if (s_systemDefault)
@@ -2013,7 +3483,7 @@ MLocale::MLocale(const QString &localeName, QObject *parent)
 #ifdef HAVE_ICU
     // we cache the number formatter for better performance
     QString categoryNameNumeric =
-        d->fixCategoryNameForNumbers(categoryName(MLocale::MLcNumeric));
+        d->categoryNameForNumbers(MLocale::MLcNumeric);
     UErrorCode status = U_ZERO_ERROR;
     d->_numberFormat =
         icu::NumberFormat::createInstance(icu::Locale(qPrintable(categoryNameNumeric)),
@@ -2022,8 +3492,9 @@ MLocale::MLocale(const QString &localeName, QObject *parent)
         qWarning() << "NumberFormat creating for LcNumeric failed:" << u_errorName(status);
         d->_valid = false;
     }
+    d->_integerFormatSymbols = MLocalePrivate::IntegerFormatSymbols();
     QString categoryNameTime =
-        d->fixCategoryNameForNumbers(categoryName(MLocale::MLcTime));
+        d->categoryNameForNumbers(MLocale::MLcTime);
     status = U_ZERO_ERROR;
     d->_numberFormatLcTime =
         icu::NumberFormat::createInstance(icu::Locale(qPrintable(categoryNameTime)),
@@ -2036,6 +3507,11 @@ MLocale::MLocale(const QString &localeName, QObject *parent)
 }
 
 
+const MLocalePrivate *MLocale::d_func() const
+{
+    return d_ptr->forCurrentThread();
+}
+
 //! Copy constructor
 MLocale::MLocale(const MLocale &other, QObject *parent)
     : QObject(parent),
@@ -2206,6 +3682,7 @@ void MLocale::setCollation(Collation collation)
     else
         d->_defaultLocale =
             MIcuConversions::setCollationOption(d->_defaultLocale, collation);
+    d->updateLocaleIdentifiers();
 #else
     Q_UNUSED(collation);
 #endif
@@ -2231,6 +3708,7 @@ void MLocale::setCalendarType(CalendarType calendarType)
     else
         d->_defaultLocale =
             MIcuConversions::setCalendarOption(d->_defaultLocale, calendarType);
+    d->updateLocaleIdentifiers();
 #else
     Q_UNUSED(calendarType);
 #endif
@@ -2313,22 +3791,26 @@ QString MLocale::toUpper(const QString &string) const
 
 QString MLocale::language() const
 {
-    return MLocalePrivate::parseLanguage(name());
+    Q_D(const MLocale);
+    return d->_defaultIdentifier->language();
 }
 
 QString MLocale::country() const
 {
-    return MLocalePrivate::parseCountry(name());
+    Q_D(const MLocale);
+    return d->_defaultIdentifier->country();
 }
 
 QString MLocale::script() const
 {
-    return MLocalePrivate::parseScript(name());
+    Q_D(const MLocale);
+    return d->_defaultIdentifier->script();
 }
 
 QString MLocale::variant() const
 {
-    return MLocalePrivate::parseVariant(name());
+    Q_D(const MLocale);
+    return d->_defaultIdentifier->variant();
 }
 
 QString MLocale::name() const
@@ -2339,26 +3821,26 @@ QString MLocale::name() const
 
 QString MLocale::categoryLanguage(Category category) const
 {
-    QString wholeName = categoryName(category);
-    return MLocalePrivate::parseLanguage(wholeName);
+    Q_D(const MLocale);
+    return d->categoryIdentifier(category)->language();
 }
 
 QString MLocale::categoryCountry(Category category) const
 {
-    QString wholeName = categoryName(category);
-    return MLocalePrivate::parseCountry(wholeName);
+    Q_D(const MLocale);
+    return d->categoryIdentifier(category)->country();
 }
 
 QString MLocale::categoryScript(Category category) const
 {
-    QString wholeName = categoryName(category);
-    return MLocalePrivate::parseScript(wholeName);
+    Q_D(const MLocale);
+    return d->categoryIdentifier(category)->script();
 }
 
 QString MLocale::categoryVariant(Category category) const
 {
-    QString wholeName = categoryName(category);
-    return MLocalePrivate::parseVariant(wholeName);
+    Q_D(const MLocale);
+    return d->categoryIdentifier(category)->variant();
 }
 
 QString MLocale::categoryName(Category category) const
@@ -2371,11 +3853,14 @@ QString MLocale::formatNumber(qlonglong i) const
 {
 #ifdef HAVE_ICU
     Q_D(const MLocale);
+    QString result;
+    if (d->appendFormattedInteger(i, &result))
+        return result;
     UnicodeString str;
     // This might generate a warning by the Krazy code analyzer,
     // but it allows the code to compile with ICU 4.0
     d->_numberFormat->format(static_cast<int64_t>(i), str); //krazy:exclude=typedefs
-    QString result = MIcuConversions::unicodeStringToQString(str);
+    result = MIcuConversions::unicodeStringToQString(str);
     d->fixFormattedNumberForRTL(&result);
     return result;
 #else
@@ -2384,6 +3869,87 @@ QString MLocale::formatNumber(qlonglong i) const
 #endif
 }
 
+#ifdef HAVE_ICU
+const icu::NumberFormat *MLocalePrivate::parser(ParserType type) const
+{
+    icu::NumberFormat *parser = _parsers[type].loadAcquire();
+    if (parser || !_numberFormat)
+        return parser;
+    parser = static_cast<icu::NumberFormat *>(_numberFormat->clone());
+    parser->setParseIntegerOnly(type == IntegerParser);
+    // another thread may have created the parser in the meantime:
+    if (!_parsers[type].testAndSetOrdered(0, parser)) {
+        delete parser;
+        parser = _parsers[type].loadAcquire();
+    }
+    return parser;
+}
+
+void MLocalePrivate::dropParsers()
+{
+    for (int i = 0; i < ParserTypeCount; ++i)
+        delete _parsers[i].fetchAndStoreOrdered(0);
+}
+
+namespace
+{
+    // Parses localized numbers with one of the parsers of
+    // MLocalePrivate. Only the parser is shared, the input buffers,
+    // the ParsePosition and the Formattable belong to the
+    // MNumberParser and are reused when parsing many strings.
+    class MNumberParser
+    {
+    public:
+        MNumberParser(const MLocalePrivate *d, MLocalePrivate::ParserType type)
+            : _d(d),
+              _parser(d->parser(type))
+        {
+            if (_parser && type == MLocalePrivate::DoubleParser) {
+                const icu::DecimalFormatSymbols *decimalFormatSymbols
+                    = static_cast<const icu::DecimalFormat *>(_parser)->getDecimalFormatSymbols();
+                _exponentialSymbol
+                    = MIcuConversions::unicodeStringToQString(
+                        decimalFormatSymbols->getSymbol(DecimalFormatSymbols::kExponentialSymbol));
+            }
+        }
+
+        // returns true if all of s could be parsed, the number is
+        // in formattable then
+        bool parse(const QString &s)
+        {
+            if (!_parser || s.isEmpty())
+                return false;
+            _parseInput = s;
+            _d->fixParseInputForRTL(&_parseInput);
+            if (!_exponentialSymbol.isEmpty()) {
+                // accept “e” or “E” always as exponential symbols, even if the
+                // locale uses something completely different:
+                _parseInput.replace(QChar('e'), _exponentialSymbol, Qt::CaseInsensitive);
+                // parse the exponential symbol in the input case insensitive:
+                _parseInput.replace(_exponentialSymbol, _exponentialSymbol, Qt::CaseInsensitive);
+            }
+            _str.setTo(reinterpret_cast<const UChar *>(_parseInput.constData()),
+                       _parseInput.length());
+            formattable.setLong(0);
+            _parsePosition.setIndex(0);
+            _parsePosition.setErrorIndex(-1);
+            _parser->parse(_str, formattable, _parsePosition);
+            return _parsePosition.getIndex() >= _str.length();
+        }
+
+        icu::Formattable formattable;
+
+    private:
+        const MLocalePrivate *_d;
+        const icu::NumberFormat *_parser;
+        QString _exponentialSymbol;
+        QString _parseInput;
+        icu::UnicodeString _str;
+        icu::ParsePosition _parsePosition;
+    };
+}
+#endif
+
 qlonglong MLocale::toLongLong(const QString &s, bool *ok) const
 {
     if (s.length() == 0) {
@@ -2393,29 +3959,16 @@ qlonglong MLocale::toLongLong(const QString &s, bool *ok) const
     }
 #ifdef HAVE_ICU
     Q_D(const MLocale);
-    QString parseInput = s;
-    d->fixParseInputForRTL(&parseInput);
-    icu::UnicodeString str = MIcuConversions::qStringToUnicodeString(parseInput);
-    icu::Formattable formattable;
-    icu::ParsePosition parsePosition;
+    MNumberParser parser(d, MLocalePrivate::IntegerParser);
     qint64 result;
-    icu::DecimalFormat *decimalFormat
-        = static_cast<icu::DecimalFormat *>(d->_numberFormat);
-    if (!decimalFormat->isParseIntegerOnly()) {
-        decimalFormat->setParseIntegerOnly(true);
-        decimalFormat->parse(str, formattable, parsePosition);
-        decimalFormat->setParseIntegerOnly(false);
-    }
-    else
-        decimalFormat->parse(str, formattable, parsePosition);
-    if (parsePosition.getIndex() < str.length()) {
+    if (!parser.parse(s)) {
         if (ok != NULL)
             *ok = false;
         return (qlonglong(0));
     }
     else {
         UErrorCode status = U_ZERO_ERROR;
-        result = formattable.getInt64(status);
+        result = parser.formattable.getInt64(status);
         if (!U_SUCCESS(status)) {
             if (ok != NULL)
                 *ok = false;
@@ -2437,9 +3990,12 @@ QString MLocale::formatNumber(short i) const
 {
 #ifdef HAVE_ICU
     Q_D(const MLocale);
+    QString result;
+    if (d->appendFormattedInteger(i, &result))
+        return result;
     UnicodeString str;
     d->_numberFormat->format(i, str);
-    QString result = MIcuConversions::unicodeStringToQString(str);
+    result = MIcuConversions::unicodeStringToQString(str);
     d->fixFormattedNumberForRTL(&result);
     return result;
 #else
@@ -2457,29 +4013,16 @@ short MLocale::toShort(const QString &s, bool *ok) const
     }
 #ifdef HAVE_ICU
     Q_D(const MLocale);
-    QString parseInput = s;
-    d->fixParseInputForRTL(&parseInput);
-    icu::UnicodeString str = MIcuConversions::qStringToUnicodeString(parseInput);
-    icu::Formattable formattable;
-    icu::ParsePosition parsePosition;
+    MNumberParser parser(d, MLocalePrivate::IntegerParser);
     qint64 result;
-    icu::DecimalFormat *decimalFormat
-        = static_cast<icu::DecimalFormat *>(d->_numberFormat);
-    if (!decimalFormat->isParseIntegerOnly()) {
-        decimalFormat->setParseIntegerOnly(true);
-        decimalFormat->parse(str, formattable, parsePosition);
-        decimalFormat->setParseIntegerOnly(false);
-    }
-    else
-        decimalFormat->parse(str, formattable, parsePosition);
-    if (parsePosition.getIndex() < str.length()) {
+    if (!parser.parse(s)) {
         if (ok != NULL)
             *ok = false;
         return (short(0));
     }
     else {
         UErrorCode status = U_ZERO_ERROR;
-        result = formattable.getInt64(status);
+        result = parser.formattable.getInt64(status);
         if (!U_SUCCESS(status)) {
             if (ok != NULL)
                 *ok = false;
@@ -2508,9 +4051,12 @@ QString MLocale::formatNumber(int i) const
 {
 #ifdef HAVE_ICU
     Q_D(const MLocale);
+    QString result;
+    if (d->appendFormattedInteger(i, &result))
+        return result;
     UnicodeString str;
     d->_numberFormat->format(i, str);
-    QString result = MIcuConversions::unicodeStringToQString(str);
+    result = MIcuConversions::unicodeStringToQString(str);
     d->fixFormattedNumberForRTL(&result);
     return result;
 #else
@@ -2528,29 +4074,16 @@ int MLocale::toInt(const QString &s, bool *ok) const
     }
 #ifdef HAVE_ICU
     Q_D(const MLocale);
-    QString parseInput = s;
-    d->fixParseInputForRTL(&parseInput);
-    icu::UnicodeString str = MIcuConversions::qStringToUnicodeString(parseInput);
-    icu::Formattable formattable;
-    icu::ParsePosition parsePosition;
+    MNumberParser parser(d, MLocalePrivate::IntegerParser);
     qint64 result;
-    icu::DecimalFormat *decimalFormat
-        = static_cast<icu::DecimalFormat *>(d->_numberFormat);
-    if (!decimalFormat->isParseIntegerOnly()) {
-        decimalFormat->setParseIntegerOnly(true);
-        decimalFormat->parse(str, formattable, parsePosition);
-        decimalFormat->setParseIntegerOnly(false);
-    }
-    else
-        decimalFormat->parse(str, formattable, parsePosition);
-    if (parsePosition.getIndex() < str.length()) {
+    if (!parser.parse(s)) {
         if (ok != NULL)
             *ok = false;
         return (int(0));
     }
     else {
         UErrorCode status = U_ZERO_ERROR;
-        result = formattable.getInt64(status);
+        result = parser.formattable.getInt64(status);
         if (!U_SUCCESS(status)) {
             if (ok != NULL)
                 *ok = false;
@@ -2591,21 +4124,10 @@ QString MLocale::formatNumber(double i, int maxPrecision, int minPrecision) cons
         d->_numberFormat->format(i, str, pos);
     } else {
         // the cached number formatter isn't sufficient
-        QString categoryNameNumeric =
-            d->fixCategoryNameForNumbers(categoryName(MLocale::MLcNumeric));
-        UErrorCode status = U_ZERO_ERROR;
-        icu::NumberFormat *nf;
-        nf = icu::NumberFormat::createInstance(icu::Locale(qPrintable(categoryNameNumeric)),
-                                               status);
-        if (!U_SUCCESS(status)) {
-            qWarning() << "NumberFormat creating failed" << u_errorName(status);
+        icu::NumberFormat *nf = d->precisionNumberFormat(maxPrecision, minPrecision);
+        if (!nf)
             return QString(); // "null" string
-        }
-
-        nf->setMaximumFractionDigits(maxPrecision);
-        nf->setMinimumFractionDigits(qBound(0, minPrecision, maxPrecision));
         nf->format(i, str);
-        delete nf;
     }
 
     QString result = MIcuConversions::unicodeStringToQString(str);
@@ -2627,39 +4149,16 @@ double MLocale::toDouble(const QString &s, bool *ok) const
     }
 #ifdef HAVE_ICU
     Q_D(const MLocale);
-    icu::DecimalFormat *decimalFormat
-        = static_cast<icu::DecimalFormat *>(d->_numberFormat);
-    const icu::DecimalFormatSymbols *decimalFormatSymbols
-        = decimalFormat->getDecimalFormatSymbols();
-    QString exponentialSymbol
-        = MIcuConversions::unicodeStringToQString(
-            decimalFormatSymbols->getSymbol(DecimalFormatSymbols::kExponentialSymbol));
-    QString parseInput = s;
-    d->fixParseInputForRTL(&parseInput);
-    // accept “e” or “E” always as exponential symbols, even if the
-    // locale uses something completely different:
-    parseInput.replace(QChar('e'), exponentialSymbol, Qt::CaseInsensitive);
-    // parse the exponential symbol in the input case insensitive:
-    parseInput.replace(exponentialSymbol, exponentialSymbol, Qt::CaseInsensitive);
-    icu::UnicodeString str = MIcuConversions::qStringToUnicodeString(parseInput);
-    icu::Formattable formattable;
-    icu::ParsePosition parsePosition;
+    MNumberParser parser(d, MLocalePrivate::DoubleParser);
     double result;
-    if (decimalFormat->isParseIntegerOnly()) {
-        decimalFormat->setParseIntegerOnly(false);
-        decimalFormat->parse(str, formattable, parsePosition);
-        decimalFormat->setParseIntegerOnly(true);
-    }
-    else
-        decimalFormat->parse(str, formattable, parsePosition);
-    if (parsePosition.getIndex() < str.length()) {
+    if (!parser.parse(s)) {
         if (ok != NULL)
             *ok = false;
         return (double(0.0));
     }
     else {
         UErrorCode status = U_ZERO_ERROR;
-        result = formattable.getDouble(status);
+        result = parser.formattable.getDouble(status);
         if (!U_SUCCESS(status)) {
             if (ok != NULL)
                 *ok = false;
@@ -2702,39 +4201,16 @@ float MLocale::toFloat(const QString &s, bool *ok) const
     }
 #ifdef HAVE_ICU
     Q_D(const MLocale);
-    icu::DecimalFormat *decimalFormat
-        = static_cast<icu::DecimalFormat *>(d->_numberFormat);
-    const icu::DecimalFormatSymbols *decimalFormatSymbols
-        = decimalFormat->getDecimalFormatSymbols();
-    QString exponentialSymbol
-        = MIcuConversions::unicodeStringToQString(
-            decimalFormatSymbols->getSymbol(DecimalFormatSymbols::kExponentialSymbol));
-    QString parseInput = s;
-    d->fixParseInputForRTL(&parseInput);
-    // accept “e” or “E” always as exponential symbols, even if the
-    // locale uses something completely different:
-    parseInput.replace(QChar('e'), exponentialSymbol, Qt::CaseInsensitive);
-    // parse the exponential symbol in the input case insensitive:
-    parseInput.replace(exponentialSymbol, exponentialSymbol, Qt::CaseInsensitive);
-    icu::UnicodeString str = MIcuConversions::qStringToUnicodeString(parseInput);
-    icu::Formattable formattable;
-    icu::ParsePosition parsePosition;
+    MNumberParser parser(d, MLocalePrivate::DoubleParser);
     double result;
-    if (decimalFormat->isParseIntegerOnly()) {
-        decimalFormat->setParseIntegerOnly(false);
-        decimalFormat->parse(str, formattable, parsePosition);
-        decimalFormat->setParseIntegerOnly(true);
-    }
-    else
-        decimalFormat->parse(str, formattable, parsePosition);
-    if (parsePosition.getIndex() < str.length()) {
+    if (!parser.parse(s)) {
         if (ok != NULL)
             *ok = false;
         return (float(0.0));
     }
     else {
         UErrorCode status = U_ZERO_ERROR;
-        result = formattable.getDouble(status);
+        result = parser.formattable.getDouble(status);
         if (!U_SUCCESS(status)) {
             if (ok != NULL)
                 *ok = false;
@@ -2759,98 +4235,510 @@ float MLocale::toFloat(const QString &s, bool *ok) const
 #endif
 }
 
+int MLocale::parseNumbers(const QStringList &strings, QVector<qlonglong> *numbers,
+                          QVector<bool> *ok) const
+{
+    Q_D(const MLocale);
+    const int count = strings.size();
+    numbers->resize(count);
+    if (ok)
+        ok->resize(count);
+    int parsed = 0;
+#ifdef HAVE_ICU
+    MNumberParser parser(d, MLocalePrivate::IntegerParser);
+    for (int i = 0; i < count; ++i) {
+        UErrorCode status = U_ZERO_ERROR;
+        qint64 result = 0;
+        bool success = parser.parse(strings.at(i));
+        if (success) {
+            result = parser.formattable.getInt64(status);
+            success = U_SUCCESS(status);
+        }
+        (*numbers)[i] = success ? qlonglong(result) : qlonglong(0);
+        if (ok)
+            (*ok)[i] = success;
+        if (success)
+            ++parsed;
+    }
+#else
+    QLocale locale = d->createQLocale(MLcNumeric);
+    for (int i = 0; i < count; ++i) {
+        bool success = false;
+        (*numbers)[i] = locale.toLongLong(strings.at(i), &success);
+        if (ok)
+            (*ok)[i] = success;
+        if (success)
+            ++parsed;
+    }
+#endif
+    return parsed;
+}
+
+int MLocale::parseNumbers(const QStringList &strings, QVector<double> *numbers,
+                          QVector<bool> *ok) const
+{
+    Q_D(const MLocale);
+    const int count = strings.size();
+    numbers->resize(count);
+    if (ok)
+        ok->resize(count);
+    int parsed = 0;
+#ifdef HAVE_ICU
+    MNumberParser parser(d, MLocalePrivate::DoubleParser);
+    for (int i = 0; i < count; ++i) {
+        UErrorCode status = U_ZERO_ERROR;
+        double result = 0.0;
+        bool success = parser.parse(strings.at(i));
+        if (success) {
+            result = parser.formattable.getDouble(status);
+            success = U_SUCCESS(status);
+        }
+        (*numbers)[i] = success ? result : 0.0;
+        if (ok)
+            (*ok)[i] = success;
+        if (success)
+            ++parsed;
+    }
+#else
+    QLocale locale = d->createQLocale(MLcNumeric);
+    for (int i = 0; i < count; ++i) {
+        bool success = false;
+        (*numbers)[i] = locale.toDouble(strings.at(i), &success);
+        if (ok)
+            (*ok)[i] = success;
+        if (success)
+            ++parsed;
+    }
+#endif
+    return parsed;
+}
+
+#ifdef HAVE_ICU
+namespace
+{
+    // don’t start threads for fewer numbers than this
+    const int MinNumbersPerThread = 1024;
+
+    inline void formatNumberTo(const icu::NumberFormat *nf, qlonglong number,
+                               icu::UnicodeString &str)
+    {
+        nf->format(static_cast<int64_t>(number), str); //krazy:exclude=typedefs
+    }
+
+    inline void formatNumberTo(const icu::NumberFormat *nf, int number,
+                               icu::UnicodeString &str)
+    {
+        nf->format(static_cast<int32_t>(number), str);
+    }
+
+    inline void formatNumberTo(const icu::NumberFormat *nf, double number,
+                               icu::UnicodeString &str)
+    {
+        nf->format(number, str);
+    }
+
+    inline bool appendFormattedInteger(const MLocalePrivate *d, qlonglong number,
+                                       QString *result)
+    {
+        return d->appendFormattedInteger(number, result);
+    }
+
+    inline bool appendFormattedInteger(const MLocalePrivate *d, int number,
+                                       QString *result)
+    {
+        return d->appendFormattedInteger(number, result);
+    }
+
+    inline bool appendFormattedInteger(const MLocalePrivate *, double, QString *)
+    {
+        return false;
+    }
+
+    // Formats count numbers with nf and appends them to *result,
+    // the position where each number starts is stored in offsets.
+    // The scratch buffers are reused for all numbers, i.e. there
+    // is no allocation per number once they are big enough.
+    template <typename T>
+    void appendFormattedNumbers(const MLocalePrivate *d, const icu::NumberFormat *nf,
+                                const T *numbers, int count,
+                                QString *result, int *offsets)
+    {
+        icu::UnicodeString str;
+        QString number;
+        for (int i = 0; i < count; ++i) {
+            offsets[i] = result->size();
+            if (appendFormattedInteger(d, numbers[i], result))
+                continue;
+            str.remove();
+            formatNumberTo(nf, numbers[i], str);
+            number.setUnicode(reinterpret_cast<const QChar *>(str.getBuffer()),
+                              str.length());
+            d->fixFormattedNumberForRTL(&number);
+            result->append(number);
+        }
+    }
+
+    template <typename T>
+    class MFormatNumbersTask : public QRunnable
+    {
+    public:
+        MFormatNumbersTask(const MLocalePrivate *d, icu::NumberFormat *nf,
+                           const T *numbers, int count, int *offsets,
+                           QSemaphore *done)
+            : _d(d), _nf(nf), _numbers(numbers), _count(count),
+              _offsets(offsets), _done(done)
+        {
+            setAutoDelete(false);
+        }
+
+        virtual ~MFormatNumbersTask()
+        {
+            delete _nf;
+        }
+
+        virtual void run()
+        {
+            appendFormattedNumbers(_d, _nf, _numbers, _count, &_result, _offsets);
+            _done->release();
+        }
+
+        QString _result;
+
+    private:
+        const MLocalePrivate *_d;
+        icu::NumberFormat *_nf;
+        const T *_numbers;
+        int _count;
+        int *_offsets;
+        QSemaphore *_done;
+    };
+
+    template <typename T>
+    QString formatNumbersPacked(const MLocalePrivate *d, const icu::NumberFormat *nf,
+                                const QVector<T> &numbers, QVector<int> *offsets,
+                                int threads)
+    {
+        const int count = numbers.size();
+        QVector<int> ownOffsets;
+        QVector<int> &packedOffsets = offsets ? *offsets : ownOffsets;
+        packedOffsets.resize(count + 1);
+        threads = qBound(1, threads, count / MinNumbersPerThread);
+
+        QString result;
+        result.reserve(count * 8);
+        if (threads == 1) {
+            appendFormattedNumbers(d, nf, numbers.constData(), count,
+                                   &result, packedOffsets.data());
+            packedOffsets[count] = result.size();
+            return result;
+        }
+
+        // the first chunk is formatted in the calling thread with
+        // the cached formatter, all other chunks by the thread pool,
+        // each with its own clone of the formatter. The integer
+        // symbols are probed on first use, do that before the
+        // workers share them:
+        if (!d->_integerFormatSymbols.probed)
+            d->updateIntegerFormatSymbols();
+        const int chunk = (count + threads - 1) / threads;
+        QSemaphore done;
+        QList<MFormatNumbersTask<T> *> tasks;
+        for (int begin = chunk; begin < count; begin += chunk) {
+            MFormatNumbersTask<T> *task = new MFormatNumbersTask<T>(
+                d, static_cast<icu::NumberFormat *>(nf->clone()),
+                numbers.constData() + begin, qMin(chunk, count - begin),
+                packedOffsets.data() + begin, &done);
+            tasks.append(task);
+            // run it here if the pool is exhausted, this avoids
+            // a deadlock when called from a pool thread:
+            if (!QThreadPool::globalInstance()->tryStart(task))
+                task->run();
+        }
+        appendFormattedNumbers(d, nf, numbers.constData(), qMin(chunk, count),
+                               &result, packedOffsets.data());
+        done.acquire(tasks.size());
+
+        for (int t = 0; t < tasks.size(); ++t) {
+            const int shift = result.size();
+            const int begin = (t + 1) * chunk;
+            const int end = qMin(begin + chunk, count);
+            for (int i = begin; i < end; ++i)
+                packedOffsets[i] += shift;
+            result.append(tasks.at(t)->_result);
+        }
+        qDeleteAll(tasks);
+        packedOffsets[count] = result.size();
+        return result;
+    }
+}
+#endif
+
+#ifndef HAVE_ICU
+namespace
+{
+    inline QString localeNumberString(const QLocale &locale, qlonglong number, int)
+    {
+        return locale.toString(number);
+    }
+
+    inline QString localeNumberString(const QLocale &locale, int number, int)
+    {
+        return locale.toString(number);
+    }
+
+    inline QString localeNumberString(const QLocale &locale, double number, int precision)
+    {
+        return locale.toString(number, 'g', precision);
+    }
+
+    template <typename T>
+    QString formatNumbersPacked(const QLocale &locale, const QVector<T> &numbers,
+                                QVector<int> *offsets, int precision = -1)
+    {
+        const int count = numbers.size();
+        if (offsets)
+            offsets->resize(count + 1);
+        QString result;
+        for (int i = 0; i < count; ++i) {
+            if (offsets)
+                (*offsets)[i] = result.size();
+            result += localeNumberString(locale, numbers.at(i), precision);
+        }
+        if (offsets)
+            (*offsets)[count] = result.size();
+        return result;
+    }
+}
+#endif
+
+QString MLocale::formatNumbers(const QVector<qlonglong> &numbers, QVector<int> *offsets,
+                               int threads) const
+{
+    Q_D(const MLocale);
+#ifdef HAVE_ICU
+    if (!d->_numberFormat)
+        return QString(); // "null" string
+    return formatNumbersPacked(d, d->_numberFormat, numbers, offsets, threads);
+#else
+    Q_UNUSED(threads);
+    return formatNumbersPacked(d->createQLocale(MLcNumeric), numbers, offsets);
+#endif
+}
+
+QString MLocale::formatNumbers(const QVector<int> &numbers, QVector<int> *offsets,
+                               int threads) const
+{
+    Q_D(const MLocale);
 #ifdef HAVE_ICU
-void MLocalePrivate::removeDirectionalFormattingCodes(QString *str) const
+    if (!d->_numberFormat)
+        return QString(); // "null" string
+    return formatNumbersPacked(d, d->_numberFormat, numbers, offsets, threads);
+#else
+    Q_UNUSED(threads);
+    return formatNumbersPacked(d->createQLocale(MLcNumeric), numbers, offsets);
+#endif
+}
+
+QString MLocale::formatNumbers(const QVector<double> &numbers, QVector<int> *offsets,
+                               int maxPrecision, int minPrecision, int threads) const
 {
-    str->remove(QChar(0x200F)); // RIGHT-TO-LEFT MARK
-    str->remove(QChar(0x200E)); // LEFT-TO-RIGHT MARK
-    str->remove(QChar(0x202D)); // LEFT-TO-RIGHT OVERRIDE
-    str->remove(QChar(0x202E)); // RIGHT-TO-LEFT OVERRIDE
-    str->remove(QChar(0x202A)); // LEFT-TO-RIGHT EMBEDDING
-    str->remove(QChar(0x202B)); // RIGHT-TO-LEFT EMBEDDING
-    str->remove(QChar(0x202C)); // POP DIRECTIONAL FORMATTING
+    Q_D(const MLocale);
+#ifdef HAVE_ICU
+    const icu::NumberFormat *nf = d->_numberFormat;
+    if (maxPrecision >= 0)
+        nf = d->precisionNumberFormat(maxPrecision, minPrecision);
+    if (!nf)
+        return QString(); // "null" string
+    return formatNumbersPacked(d, nf, numbers, offsets, threads);
+#else
+    Q_UNUSED(minPrecision);
+    Q_UNUSED(threads);
+    return formatNumbersPacked(d->createQLocale(MLcNumeric), numbers, offsets, maxPrecision);
+#endif
+}
+
+#ifdef HAVE_ICU
+void MLocalePrivate::removeDirectionalFormattingCodes(QString *str, bool *hasArabicIndicDigits) const
+{
+    // a single pass over the string which drops the
+    // formatting codes in place and looks for Arabic-Indic
+    // digits at the same time:
+    bool digitsFound = false;
+    const int size = str->size();
+    const QChar *in = str->constData();
+    QChar *out = 0;
+    int w = 0;
+    for (int r = 0; r < size; ++r) {
+        const ushort u = in[r].unicode();
+        switch (u) {
+        case 0x200F: // RIGHT-TO-LEFT MARK
+        case 0x200E: // LEFT-TO-RIGHT MARK
+        case 0x202D: // LEFT-TO-RIGHT OVERRIDE
+        case 0x202E: // RIGHT-TO-LEFT OVERRIDE
+        case 0x202A: // LEFT-TO-RIGHT EMBEDDING
+        case 0x202B: // RIGHT-TO-LEFT EMBEDDING
+        case 0x202C: // POP DIRECTIONAL FORMATTING
+            if (!out) {
+                // detach only if something has to be removed
+                out = str->data();
+                in = out;
+            }
+            continue;
+        default:
+            break;
+        }
+        if ((u >= 0x0660 && u <= 0x0669)     // ARABIC-INDIC DIGIT ZERO … NINE
+            || (u >= 0x06F0 && u <= 0x06F9)) // EXTENDED ARABIC-INDIC DIGIT ZERO … NINE
+            digitsFound = true;
+        if (out)
+            out[w] = in[r];
+        ++w;
+    }
+    if (out)
+        str->truncate(w);
+    if (hasArabicIndicDigits)
+        *hasArabicIndicDigits = digitsFound;
 }
 #endif
 
 
 #ifdef HAVE_ICU
+namespace
+{
+    inline bool isNumberDigit(QChar c)
+    {
+        const QChar::Direction direction = c.direction();
+        return direction == QChar::DirEN || direction == QChar::DirAN;
+    }
+
+    inline bool isLetterOrPunct(QChar c)
+    {
+        return c.isLetter() || c.isPunct();
+    }
+
+    inline bool isLetterPunctOrSpace(QChar c)
+    {
+        return c.isLetter() || c.isPunct() || c.isSpace();
+    }
+
+    // returns true if str contains any strong right-to-left character
+    // (all characters below the Hebrew block are left-to-right or neutral)
+    bool containsRightToLeft(const QString &str)
+    {
+        const QChar *it = str.constData();
+        const QChar *end = it + str.size();
+        for (; it != end; ++it) {
+            if (it->unicode() < 0x0590)
+                continue;
+            const QChar::Direction direction = it->direction();
+            if (direction == QChar::DirR || direction == QChar::DirAL)
+                return true;
+        }
+        return false;
+    }
+
+    // replaces str by <first>str[0, i)<PDF><second>str[i, size)<PDF>
+    void embedNumberParts(QString *str, int i, QChar first, QChar second)
+    {
+        const QChar pdf(0x202C); // POP DIRECTIONAL FORMATTING
+        QString result;
+        result.reserve(str->size() + 4);
+        result += first;
+        result.append(str->constData(), i);
+        result += pdf;
+        result += second;
+        result.append(str->constData() + i, str->size() - i);
+        result += pdf;
+        str->swap(result);
+    }
+}
+
 void MLocalePrivate::swapPostAndPrefixOfFormattedNumber(QString *formattedNumber) const
 {
-    QString newPostfix;
-    QString newPrefix;
-    while(!formattedNumber->isEmpty()
-          && formattedNumber->at(0).direction() != QChar::DirEN
-          && formattedNumber->at(0).direction() != QChar::DirAN) {
-        if(formattedNumber->at(0).isLetter() || formattedNumber->at(0).isPunct()) {
+    const int size = formattedNumber->size();
+    const QChar *data = formattedNumber->constData();
+
+    // find the number itself, everything before it becomes the
+    // new postfix, everything after it the new prefix:
+    int begin = 0;
+    while (begin < size && !isNumberDigit(data[begin]))
+        ++begin;
+    int end = size;
+    while (end > begin && !isNumberDigit(data[end - 1]))
+        --end;
+    if (begin == 0 && end == size)
+        return;
+
+    QVarLengthArray<QChar, 16> newPostfix;
+    for (int j = 0; j < begin; ++j) {
+        if (isLetterOrPunct(data[j])) {
             int i = 0;
-            while (i < newPostfix.size() && (newPostfix.at(i).isLetter() || newPostfix.at(i).isPunct()))
+            while (i < newPostfix.size() && isLetterOrPunct(newPostfix[i]))
                 ++i;
-            newPostfix.insert(i, formattedNumber->at(0));
+            newPostfix.insert(i, data[j]);
         }
         else
-            newPostfix.prepend(formattedNumber->at(0));
-        formattedNumber->remove(0,1);
+            newPostfix.prepend(data[j]);
     }
-    while(!formattedNumber->isEmpty()
-          && formattedNumber->right(1).at(0).direction() != QChar::DirEN
-          && formattedNumber->right(1).at(0).direction() != QChar::DirAN) {
-        if(formattedNumber->right(1).at(0).isLetter() || formattedNumber->right(1).at(0).isPunct()) {
+    QVarLengthArray<QChar, 16> newPrefix;
+    for (int j = size - 1; j >= end; --j) {
+        if (isLetterOrPunct(data[j])) {
             int i = newPrefix.size();
-            while (i > 0 && (newPrefix.at(i-1).isLetter() || newPrefix.at(i-1).isPunct()))
+            while (i > 0 && isLetterOrPunct(newPrefix[i-1]))
                 --i;
-            newPrefix.insert(i, formattedNumber->right(1).at(0));
+            newPrefix.insert(i, data[j]);
         }
         else
-            newPrefix.append(formattedNumber->right(1).at(0));
-        formattedNumber->remove(formattedNumber->size()-1,1);
+            newPrefix.append(data[j]);
     }
-    formattedNumber->prepend(newPrefix);
-    formattedNumber->append(newPostfix);
+
+    QString result;
+    result.reserve(size);
+    result.append(newPrefix.constData(), newPrefix.size());
+    result.append(data + begin, end - begin);
+    result.append(newPostfix.constData(), newPostfix.size());
+    formattedNumber->swap(result);
 }
 #endif
 
 #ifdef HAVE_ICU
 void MLocalePrivate::fixFormattedNumberForRTL(QString *formattedNumber) const
 {
-    Q_Q(const MLocale);
-    QString categoryNameNumeric = categoryName(MLocale::MLcNumeric);
-    if(categoryNameNumeric.startsWith(QLatin1String("ar"))
-       || categoryNameNumeric.startsWith(QLatin1String("fa"))) {
+    if(_profile.numericNeedsRtlFixup) {
         // remove formatting codes already found in the format, there
         // should not be any but better make sure
         // (actually some of the Arabic currency symbols have RLM markers in the icu
         // data ...).
-        removeDirectionalFormattingCodes(formattedNumber);
-        if (formattedNumber->contains(QRegularExpression(QString::fromUtf8("[٠١٢٣٤٥٦٧٨٩۰۱۲۳۴۵۶۷۸۹]")))) {
+        bool hasArabicIndicDigits;
+        removeDirectionalFormattingCodes(formattedNumber, &hasArabicIndicDigits);
+        if (hasArabicIndicDigits) {
             swapPostAndPrefixOfFormattedNumber(formattedNumber);
         }
     }
+    // Numbers without any right-to-left characters (i.e. without
+    // Arabic or Hebrew currency symbols) need no further markup:
+    if (formattedNumber->isEmpty() || !containsRightToLeft(*formattedNumber))
+        return;
     if(formattedNumber->at(0).direction() == QChar::DirAL) {
         // there is an Arabic currency symbol at the beginning, add markup
         // like this: <RLE>currency symbol with trailing spaces<PDF><LRE>rest of number<PDF>
         int i = 0;
         while (i < formattedNumber->size()
-               && (formattedNumber->at(i).isLetter()
-                   || formattedNumber->at(i).isPunct()
-                   || formattedNumber->at(i).isSpace()))
+               && isLetterPunctOrSpace(formattedNumber->at(i)))
             ++i;
-        formattedNumber->insert(i, QChar(0x202A)); // LEFT-TO-RIGHT EMBEDDING
-        formattedNumber->insert(i, QChar(0x202C)); // POP DIRECTIONAL FORMATTING
-        formattedNumber->prepend(QChar(0x202B));   // RIGHT-TO-LEFT EMBEDDING
-        formattedNumber->append(QChar(0x202C));    // POP DIRECTIONAL FORMATTING
+        embedNumberParts(formattedNumber, i,
+                         QChar(0x202B),  // RIGHT-TO-LEFT EMBEDDING
+                         QChar(0x202A)); // LEFT-TO-RIGHT EMBEDDING
     } else if(MLocale::directionForText(*formattedNumber) == Qt::RightToLeft) {
         // there is an Arabic currency symbol at the end, add markup like this:
         // <LRE>rest of number<PDF><RLE>leading spaces and currency symbol<PDF>
         int i = formattedNumber->size();
         while (i > 0
-               && (formattedNumber->at(i-1).isLetter()
-                   || formattedNumber->at(i-1).isPunct()
-                   || formattedNumber->at(i-1).isSpace()))
+               && isLetterPunctOrSpace(formattedNumber->at(i-1)))
             --i;
-        formattedNumber->insert(i, QChar(0x202B)); // RIGHT-TO-LEFT EMBEDDING
-        formattedNumber->insert(i, QChar(0x202C)); // POP DIRECTIONAL FORMATTING
-        formattedNumber->prepend(QChar(0x202A));   // LEFT-TO-RIGHT EMBEDDING
-        formattedNumber->append(QChar(0x202C));    // POP DIRECTIONAL FORMATTING
+        embedNumberParts(formattedNumber, i,
+                         QChar(0x202A),  // LEFT-TO-RIGHT EMBEDDING
+                         QChar(0x202B)); // RIGHT-TO-LEFT EMBEDDING
     }
     // see http://comments.gmane.org/gmane.comp.internationalization.bidi/2
     // and consider the bugs:
@@ -2863,12 +4751,12 @@ void MLocalePrivate::fixFormattedNumberForRTL(QString *formattedNumber) const
     // context (this assumes that the formats are all edited exactly
     // as they should appear in display order already!):
 #if 0 // non-functional
+    Q_Q(const MLocale);
     if(q->localeScripts()[0] != "Arab" && q->localeScripts()[0] != "Hebr")
         return;
     formattedNumber->prepend(QChar(0x202A)); // LEFT-TO-RIGHT EMBEDDING
     formattedNumber->append(QChar(0x202C)); // POP DIRECTIONAL FORMATTING
 #endif
-    Q_UNUSED(q)
     return;
 }
 #endif
@@ -2876,32 +4764,176 @@ void MLocalePrivate::fixFormattedNumberForRTL(QString *formattedNumber) const
 #ifdef HAVE_ICU
 void MLocalePrivate::fixParseInputForRTL(QString *formattedNumber) const
 {
-    removeDirectionalFormattingCodes(formattedNumber);
-    if(formattedNumber->contains(QRegularExpression(QString::fromUtf8("[٠١٢٣٤٥٦٧٨٩۰۱۲۳۴۵۶۷۸۹]")))) {
+    bool hasArabicIndicDigits;
+    removeDirectionalFormattingCodes(formattedNumber, &hasArabicIndicDigits);
+    if(hasArabicIndicDigits) {
         swapPostAndPrefixOfFormattedNumber(formattedNumber);
     }
 }
 #endif
 
+#ifdef HAVE_ICU
+MLocalePrivate::IntegerFormatSymbols::IntegerFormatSymbols()
+    : probed(false),
+      usable(false),
+      groupingSize(0),
+      secondaryGroupingSize(0),
+      minimumGroupingDigits(1)
+{
+}
+
+MLocalePrivate::IntegerFormatSymbols MLocalePrivate::integerFormatSymbols() const
+{
+    QMutexLocker locker(&_integerFormatSymbolsLock);
+    return _integerFormatSymbols;
+}
+
+void MLocalePrivate::updateIntegerFormatSymbols() const
+{
+    // forCurrentThread() of another thread may copy the symbols
+    // while they are probed here:
+    QMutexLocker locker(&_integerFormatSymbolsLock);
+    IntegerFormatSymbols &symbols = _integerFormatSymbols;
+    symbols.probed = true;
+    symbols.usable = false;
+    // Arabic and Persian numbers need fixFormattedNumberForRTL(),
+    // leave them to ICU:
+    if (!_numberFormat || _profile.numericNeedsRtlFixup)
+        return;
+
+    const icu::DecimalFormat *decimalFormat
+        = static_cast<const icu::DecimalFormat *>(_numberFormat);
+    if (decimalFormat->areSignificantDigitsUsed()
+        || decimalFormat->getFormatWidth() > 0)
+        return;
+    const icu::DecimalFormatSymbols *decimalFormatSymbols
+        = decimalFormat->getDecimalFormatSymbols();
+    for (int digit = 0; digit < 10; ++digit) {
+        const DecimalFormatSymbols::ENumberFormatSymbol key = digit == 0
+            ? DecimalFormatSymbols::kZeroDigitSymbol
+            : static_cast<DecimalFormatSymbols::ENumberFormatSymbol>(
+                DecimalFormatSymbols::kOneDigitSymbol + digit - 1);
+        const icu::UnicodeString &digitSymbol = decimalFormatSymbols->getSymbol(key);
+        // only digits which are single UTF-16 code units:
+        if (digitSymbol.length() != 1)
+            return;
+        symbols.digits[digit] = QChar(digitSymbol.charAt(0));
+    }
+    symbols.groupingSeparator = MIcuConversions::unicodeStringToQString(
+        decimalFormatSymbols->getSymbol(DecimalFormatSymbols::kGroupingSeparatorSymbol));
+    if (decimalFormat->isGroupingUsed()) {
+        symbols.groupingSize = qMax(0, int(decimalFormat->getGroupingSize()));
+        symbols.secondaryGroupingSize = decimalFormat->getSecondaryGroupingSize();
+        if (symbols.secondaryGroupingSize <= 0)
+            symbols.secondaryGroupingSize = symbols.groupingSize;
+    } else {
+        symbols.groupingSize = 0;
+        symbols.secondaryGroupingSize = 0;
+    }
+    icu::UnicodeString affix;
+    symbols.positivePrefix = MIcuConversions::unicodeStringToQString(
+        decimalFormat->getPositivePrefix(affix));
+    symbols.positiveSuffix = MIcuConversions::unicodeStringToQString(
+        decimalFormat->getPositiveSuffix(affix));
+    symbols.negativePrefix = MIcuConversions::unicodeStringToQString(
+        decimalFormat->getNegativePrefix(affix));
+    symbols.negativeSuffix = MIcuConversions::unicodeStringToQString(
+        decimalFormat->getNegativeSuffix(affix));
+
+    // The grouping may be suppressed for short numbers (e.g. “1234”
+    // but “12 345” in Spanish), and there are more properties which
+    // are not obvious from the API above (multipliers, padding, …).
+    // Instead of trying to interpret them all, compare the results
+    // with ICU for a set of probes and use the fast path only if all
+    // of them agree:
+    static const qlonglong probes[] = {
+        Q_INT64_C(0), Q_INT64_C(7), Q_INT64_C(-7), Q_INT64_C(12), Q_INT64_C(123),
+        Q_INT64_C(1234), Q_INT64_C(-1234), Q_INT64_C(12345), Q_INT64_C(123456),
+        Q_INT64_C(1234567), Q_INT64_C(-12345678), Q_INT64_C(123456789012),
+        Q_INT64_C(9223372036854775807), -Q_INT64_C(9223372036854775807) - 1
+    };
+    const int probeCount = int(sizeof(probes) / sizeof(probes[0]));
+    for (symbols.minimumGroupingDigits = 1;
+         symbols.minimumGroupingDigits <= 2;
+         ++symbols.minimumGroupingDigits) {
+        symbols.usable = true;
+        int i = 0;
+        for (; i < probeCount; ++i) {
+            icu::UnicodeString str;
+            _numberFormat->format(static_cast<int64_t>(probes[i]), str); //krazy:exclude=typedefs
+            QString expected = MIcuConversions::unicodeStringToQString(str);
+            fixFormattedNumberForRTL(&expected);
+            QString formatted;
+            appendFormattedInteger(probes[i], &formatted);
+            if (formatted != expected)
+                break;
+        }
+        if (i == probeCount)
+            return;
+    }
+    symbols.usable = false;
+}
+
+bool MLocalePrivate::appendFormattedInteger(qlonglong number, QString *result) const
+{
+    const IntegerFormatSymbols &symbols = _integerFormatSymbols;
+    if (!symbols.probed)
+        updateIntegerFormatSymbols();
+    if (!symbols.usable)
+        return false;
+
+    // the digit values, least significant first:
+    quint64 magnitude = number < 0 ? 0 - quint64(number) : quint64(number);
+    uchar digitValues[20];
+    int digitCount = 0;
+    do {
+        digitValues[digitCount++] = uchar(magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+
+    const int groupingSize = symbols.groupingSize;
+    const int secondaryGroupingSize = symbols.secondaryGroupingSize;
+    int separatorCount = 0;
+    if (groupingSize > 0
+        && digitCount >= groupingSize + symbols.minimumGroupingDigits) {
+        separatorCount = 1 + (digitCount - groupingSize - 1) / secondaryGroupingSize;
+    }
+    const QString &prefix = number < 0 ? symbols.negativePrefix : symbols.positivePrefix;
+    const QString &suffix = number < 0 ? symbols.negativeSuffix : symbols.positiveSuffix;
+    const QString &separator = symbols.groupingSeparator;
+
+    // write everything directly into the UTF-16 buffer of the result:
+    const int oldSize = result->size();
+    result->resize(oldSize + prefix.size() + digitCount
+                   + separatorCount * separator.size() + suffix.size());
+    QChar *out = result->data() + oldSize;
+    memcpy(out, prefix.constData(), prefix.size() * sizeof(QChar));
+    out += prefix.size();
+    for (int i = digitCount - 1; i >= 0; --i) {
+        *out++ = symbols.digits[digitValues[i]];
+        // i digits are left on the right side:
+        if (separatorCount > 0 && i > 0
+            && (i == groupingSize
+                || (i > groupingSize && (i - groupingSize) % secondaryGroupingSize == 0))) {
+            memcpy(out, separator.constData(), separator.size() * sizeof(QChar));
+            out += separator.size();
+        }
+    }
+    memcpy(out, suffix.constData(), suffix.size() * sizeof(QChar));
+    return true;
+}
+#endif
+
 #ifdef HAVE_ICU
 QString MLocale::formatPercent(double i, int decimals) const
 {
     Q_D(const MLocale);
-    QString categoryNameNumeric
-        = d->fixCategoryNameForNumbers(categoryName(MLocale::MLcNumeric));
-    icu::Locale numericLocale = icu::Locale(qPrintable(categoryNameNumeric));
-    UErrorCode status = U_ZERO_ERROR;
-    icu::NumberFormat *nf = NumberFormat::createPercentInstance(numericLocale, status);
-
-    if (!U_SUCCESS(status)) {
-        qWarning() << "NumberFormat creating failed" << u_errorName(status);
+    icu::NumberFormat *nf = d->percentNumberFormat(decimals);
+    if (!nf)
         return QString();
-    }
 
-    nf->setMinimumFractionDigits(decimals);
     icu::UnicodeString str;
     nf->format(i, str);
-    delete nf;
     QString result = MIcuConversions::unicodeStringToQString(str);
     d->fixFormattedNumberForRTL(&result);
     return result;
@@ -2912,30 +4944,12 @@ QString MLocale::formatCurrency(double amount, const QString &currency) const
 {
 #ifdef HAVE_ICU
     Q_D(const MLocale);
-    QString monetaryCategoryName = d->fixCategoryNameForNumbers(categoryName(MLcMonetary));
-    UErrorCode status = U_ZERO_ERROR;
-    icu::Locale monetaryLocale = icu::Locale(qPrintable(monetaryCategoryName));
-    icu::NumberFormat *nf = icu::NumberFormat::createCurrencyInstance(monetaryLocale, status);
-
-    if (!U_SUCCESS(status)) {
-        qWarning() << "icu::NumberFormat::createCurrencyInstance failed with error"
-                   << u_errorName(status);
-        return QString();
-    }
-
-    icu::UnicodeString currencyString = MIcuConversions::qStringToUnicodeString(currency);
-    nf->setCurrency(currencyString.getTerminatedBuffer(), status);
-
-    if (!U_SUCCESS(status)) {
-        qWarning() << "icu::NumberFormat::setCurrency failed with error"
-                   << u_errorName(status);
-        delete nf;
+    icu::NumberFormat *nf = d->currencyNumberFormat(currency);
+    if (!nf)
         return QString();
-    }
 
     icu::UnicodeString str;
     nf->format(amount, str);
-    delete nf;
     QString result = MIcuConversions::unicodeStringToQString(str);
     d->fixFormattedNumberForRTL(&result);
     return result;
@@ -2949,9 +4963,17 @@ QString MLocale::formatDateTime(const QDateTime &dateTime, DateType dateType,
                                   TimeType timeType, CalendarType calendarType) const
 {
 #ifdef HAVE_ICU
-    MCalendar calendar(calendarType);
-    calendar.setDateTime(dateTime);
-    return formatDateTime(calendar, dateType, timeType);
+    Q_D(const MLocale);
+    if (dateType == DateNone && timeType == TimeNone)
+        return QString("");
+    MCalendar *calendar = d->scratchCalendar(calendarType);
+    QString result;
+    MIncrementalDateFormat *format
+        = d->incrementalDateFormat(dateType, timeType, calendar->type());
+    if (format)
+        format->append(calendar->d_ptr->_calendar,
+                       MLocalePrivate::scratchDate(calendar, dateTime), &result);
+    return result;
 #else
     Q_UNUSED(dateType);
     Q_UNUSED(timeType);
@@ -2961,6 +4983,167 @@ QString MLocale::formatDateTime(const QDateTime &dateTime, DateType dateType,
 #endif
 }
 
+QString MLocale::formatDateTime(qint64 msecsSinceEpoch, DateType dateType,
+                                TimeType timeType, CalendarType calendarType) const
+{
+#ifdef HAVE_ICU
+    Q_D(const MLocale);
+    if (dateType == DateNone && timeType == TimeNone)
+        return QString("");
+    MCalendar *calendar = d->scratchCalendar(calendarType);
+    QString result;
+    MIncrementalDateFormat *format
+        = d->incrementalDateFormat(dateType, timeType, calendar->type());
+    if (format)
+        format->append(calendar->d_ptr->_calendar, UDate(msecsSinceEpoch), &result);
+    return result;
+#else
+    Q_UNUSED(dateType);
+    Q_UNUSED(timeType);
+    Q_UNUSED(calendarType);
+    Q_D(const MLocale);
+    return d->createQLocale(MLcTime).toString(
+        QDateTime::fromMSecsSinceEpoch(msecsSinceEpoch));
+#endif
+}
+
+#ifdef HAVE_ICU
+namespace
+{
+    // below this many times per thread splitting a batch between
+    // threads costs more than it gains
+    const int MinDateTimesPerThread = 256;
+
+    // Formats count times with format and cal and appends them to
+    // *result, the position where each time starts is stored in
+    // offsets. Consecutive times mostly hit the caches of format, if
+    // they don't there is no allocation per time once the buffers
+    // are big enough.
+    void appendFormattedDateTimes(MIncrementalDateFormat *format, icu::Calendar *cal,
+                                  const qint64 *msecsSinceEpoch, int count,
+                                  QString *result, int *offsets)
+    {
+        for (int i = 0; i < count; ++i) {
+            offsets[i] = result->size();
+            format->append(cal, UDate(msecsSinceEpoch[i]), result);
+        }
+    }
+
+    class MFormatDateTimesTask : public QRunnable
+    {
+    public:
+        MFormatDateTimesTask(MIncrementalDateFormat *format, icu::Calendar *cal,
+                             const qint64 *msecsSinceEpoch, int count, int *offsets,
+                             QSemaphore *done)
+            : _format(format), _cal(cal), _msecsSinceEpoch(msecsSinceEpoch), _count(count),
+              _offsets(offsets), _done(done)
+        {
+            setAutoDelete(false);
+        }
+
+        virtual ~MFormatDateTimesTask()
+        {
+            delete _format;
+            delete _cal;
+        }
+
+        virtual void run()
+        {
+            appendFormattedDateTimes(_format, _cal, _msecsSinceEpoch, _count, &_result,
+                                     _offsets);
+            _done->release();
+        }
+
+        QString _result;
+
+    private:
+        MIncrementalDateFormat *_format;
+        icu::Calendar *_cal;
+        const qint64 *_msecsSinceEpoch;
+        int _count;
+        int *_offsets;
+        QSemaphore *_done;
+    };
+}
+#endif
+
+QString MLocale::formatDateTimes(const QVector<qint64> &msecsSinceEpoch, QVector<int> *offsets,
+                                 DateType dateType, TimeType timeType,
+                                 CalendarType calendarType, int threads) const
+{
+    Q_D(const MLocale);
+    const int count = msecsSinceEpoch.size();
+    QVector<int> ownOffsets;
+    QVector<int> &packedOffsets = offsets ? *offsets : ownOffsets;
+    packedOffsets.fill(0, count + 1);
+    QString result;
+#ifdef HAVE_ICU
+    if (dateType == DateNone && timeType == TimeNone)
+        return result;
+    MCalendar *calendar = d->scratchCalendar(calendarType);
+    icu::Calendar *cal = calendar->d_ptr->_calendar;
+    MIncrementalDateFormat *format
+        = d->incrementalDateFormat(dateType, timeType, calendar->type());
+    if (!format)
+        return result;
+
+    threads = qBound(1, threads, count / MinDateTimesPerThread);
+    result.reserve(count * 16);
+    if (threads == 1) {
+        appendFormattedDateTimes(format, cal, msecsSinceEpoch.constData(), count,
+                                 &result, packedOffsets.data());
+        packedOffsets[count] = result.size();
+        return result;
+    }
+
+    // the first chunk is formatted in the calling thread with the
+    // cached formatter and the scratch calendar, all other chunks by
+    // the thread pool, each with its own formatter and calendar:
+    const icu::DateFormat *df = d->createDateFormat(dateType, timeType,
+                                                    calendar->type(),
+                                                    d->_timeFormat24h);
+    const int chunk = (count + threads - 1) / threads;
+    QSemaphore done;
+    QList<MFormatDateTimesTask *> tasks;
+    for (int begin = chunk; begin < count; begin += chunk) {
+        MFormatDateTimesTask *task = new MFormatDateTimesTask(
+            new MIncrementalDateFormat(*df), cal->clone(),
+            msecsSinceEpoch.constData() + begin, qMin(chunk, count - begin),
+            packedOffsets.data() + begin, &done);
+        tasks.append(task);
+        // run it here if the pool is exhausted, this avoids
+        // a deadlock when called from a pool thread:
+        if (!QThreadPool::globalInstance()->tryStart(task))
+            task->run();
+    }
+    appendFormattedDateTimes(format, cal, msecsSinceEpoch.constData(), qMin(chunk, count),
+                             &result, packedOffsets.data());
+    done.acquire(tasks.size());
+
+    for (int t = 0; t < tasks.size(); ++t) {
+        const int shift = result.size();
+        const int begin = (t + 1) * chunk;
+        const int end = qMin(begin + chunk, count);
+        for (int i = begin; i < end; ++i)
+            packedOffsets[i] += shift;
+        result.append(tasks.at(t)->_result);
+    }
+    qDeleteAll(tasks);
+#else
+    Q_UNUSED(dateType);
+    Q_UNUSED(timeType);
+    Q_UNUSED(calendarType);
+    Q_UNUSED(threads);
+    const QLocale locale = d->createQLocale(MLcTime);
+    for (int i = 0; i < count; ++i) {
+        packedOffsets[i] = result.size();
+        result += locale.toString(QDateTime::fromMSecsSinceEpoch(msecsSinceEpoch.at(i)));
+    }
+#endif
+    packedOffsets[count] = result.size();
+    return result;
+}
+
 #ifdef HAVE_ICU
 QString MLocale::formatDateTime(const MCalendar &mcalendar,
                                   DateType datetype, TimeType timetype) const
@@ -3038,24 +5221,11 @@ QString MLocale::formatDateTimeICU(const MCalendar &mCalendar,
                                      const QString &formatString) const
 {
     Q_D(const MLocale);
-    QString categoryNameTime = categoryName(MLocale::MLcTime);
-    QString categoryNameNumeric = categoryName(MLocale::MLcNumeric);
-    QString categoryNameMessages = categoryName(MLocale::MLcMessages);
-    QString key = QString("%1_%2_%3_%4_%5")
-        .arg(formatString)
-        .arg(mCalendar.type())
-        .arg(categoryNameTime)
-        .arg(categoryNameNumeric)
-        .arg(categoryNameMessages);
-    categoryNameTime = d->fixCategoryNameForNumbers(
-        MIcuConversions::setCalendarOption(categoryNameTime, mCalendar.type()));
-    categoryNameMessages = d->fixCategoryNameForNumbers(
-        MIcuConversions::setCalendarOption(categoryNameMessages, mCalendar.type()));
-    icu::SimpleDateFormat *formatter;
-    if(d->_simpleDateFormatCache.contains(key)) {
-        formatter = d->_simpleDateFormatCache.object(key);
-    }
-    else {
+    const MLocalePrivate::SimpleDateFormatKey key(d, formatString, mCalendar.type());
+    icu::SimpleDateFormat *formatter = d->formatters()->simpleDateFormatCache.object(key);
+    if (!formatter) {
+        QString categoryNameTime = d->categoryNameForCalendar(MLocale::MLcTime, mCalendar.type());
+        QString categoryNameMessages = d->categoryNameForCalendar(MLocale::MLcMessages, mCalendar.type());
         UErrorCode status = U_ZERO_ERROR;
         formatter = new icu::SimpleDateFormat(
             MIcuConversions::qStringToUnicodeString(formatString),
@@ -3065,15 +5235,16 @@ QString MLocale::formatDateTimeICU(const MCalendar &mCalendar,
                        << u_errorName(status);
             formatter = NULL;
         }
-        if (formatter && d->mixingSymbolsWanted(categoryNameMessages, categoryNameTime)) {
+        if (formatter && d->_profile.mixingSymbolsWanted) {
             // mixing in symbols like month name and weekday name from the message locale
-            DateFormatSymbols *dfs =
-                MLocalePrivate::createDateFormatSymbols(
-                    icu::Locale(qPrintable(categoryNameMessages)));
-            formatter->adoptDateFormatSymbols(dfs);
+            const DateFormatSymbols *dfs =
+                MLocalePrivate::cachedDateFormatSymbols(categoryNameMessages);
+            if (dfs)
+                formatter->setDateFormatSymbols(*dfs);
          }
         if(formatter)
-            d->_simpleDateFormatCache.insert(key, formatter);
+            d->formatters()->simpleDateFormatCache.insert(key, formatter,
+                                                         MLocalePrivate::approximateSize(formatter));
     }
     if(!formatter) {
         return QString();
@@ -3088,401 +5259,397 @@ QString MLocale::formatDateTimeICU(const MCalendar &mCalendar,
 #endif
 
 #ifdef HAVE_ICU
-// return weeknumber based on first week starting from the first given weekday of the year
-// i.e. using sunday week 1 is the first week that contains sunday, zero before it
-// note: week also starts from given weekday
-// TODO: should this be moved to MCalendar?
-static int weekNumberStartingFromDay(const MCalendar &calendar, int weekday)
-{
-    MCalendar calendarCopy = calendar;
-    calendarCopy.setFirstDayOfWeek(weekday);
-    calendarCopy.setMinimalDaysInFirstWeek(1);
-    // this is icu week number, starts from 1
-    int weeknumber = calendarCopy.weekNumber();
-
-    // check if there's week 0
-    bool weekZero = true;
-    int year = calendarCopy.year();
-    calendarCopy.setDate(year, 1, 1); // reuse the copy
-
-    // a bit crude. check if the first week includes sunday
-    // note: should start always from week 1 because minimal days is 1.
-    while (calendarCopy.weekOfYear() == 1) {
-        if (calendarCopy.dayOfWeek() == weekday) {
-            weekZero = false;
-        }
+MLocalePrivate::PosixFormatPlan *MLocalePrivate::compilePosixFormat(const QString &formatString) const
+{
+    // convert POSIX format string into ICU format. Everything ICU has
+    // a pattern for ends up in IcuPattern segments, the conversions
+    // which depend on the date or time are left as slots which
+    // MLocale::formatDateTime(const MCalendar &, const QString &)
+    // fills in for every calendar.
+    PosixFormatPlan *plan = new PosixFormatPlan;
+    QString icuFormat;
 
-        calendarCopy.addDays(1);
-    }
+    bool isInNormalText = false; // a-zA-Z should be between <'>-quotations
 
-    if (weekZero == true) {
-        weeknumber--;
-    }
+    const int length = formatString.length();
+    for (int i = 0; i < length; ++i) {
 
-    return weeknumber;
-}
-#endif
+        QChar current = formatString.at(i);
 
-#ifdef HAVE_ICU
-QString MLocale::formatDateTime(const MCalendar &mCalendar,
-                                  const QString &formatString) const
-{
-    Q_D(const MLocale);
-    // convert POSIX format string into ICU format
+        if (current == '%') {
+            i++;
+            if (i >= length)
+                break;
+            QChar next = formatString.at(i);
 
-    QString icuFormat;
+            // end plain text icu quotation
+            if (isInNormalText == true) {
+                icuFormat.append('\'');
+                isInNormalText = false;
+            }
 
-    if ( ! d->_icuFormatStringCache.contains( formatString ) )
-    {
-        // determine if we can cache this format string, or if
-        // we have to add something to it that is a part of a date or time.
-        bool canCacheIcuFormat = true;
+            PosixFormatSegment::Kind slot = PosixFormatSegment::IcuPattern;
 
-        bool isInNormalText = false; // a-zA-Z should be between <'>-quotations
+            switch (next.unicode()) {
 
-        const int length = formatString.length();
-        for (int i = 0; i < length; ++i) {
+                case 'a':
+                    // abbreviated weekday name
+                    icuFormat.append("ccc");
+                    break;
 
-            QChar current = formatString.at(i);
+                case 'A':
+                    // stand-alone full weekday name
+                    icuFormat.append("cccc");
+                    break;
 
-            if (current == '%') {
-                i++;
-                QChar next = formatString.at(i);
+                case 'b':
+                case 'h':
+                    // abbreviated month name
+                    icuFormat.append("LLL");
+                break;
 
-                // end plain text icu quotation
-                if (isInNormalText == true) {
-                    icuFormat.append('\'');
-                    isInNormalText = false;
-                }
+                case 'B':
+                    // full month name
+                    icuFormat.append("LLLL");
+                    break;
 
-                switch (next.unicode()) {
+                case 'c':
+                    // FDCC-set's appropriate date and time representation
+                    slot = PosixFormatSegment::DateTimeRepresentation;
+                    break;
 
-                    case 'a':
-                        // abbreviated weekday name
-                        icuFormat.append("ccc");
-                        break;
+                case 'C':
+                    // century, no corresponding icu pattern
+                    slot = PosixFormatSegment::Century;
+                    break;
 
-                    case 'A':
-                        // stand-alone full weekday name
-                        icuFormat.append("cccc");
-                        break;
+                case 'd':
+                    // Day of the month as a decimal number (01-31)
+                    icuFormat.append("dd");
+                    break;
 
-                    case 'b':
-                    case 'h':
-                        // abbreviated month name
-                        icuFormat.append("LLL");
+                case 'D':
+                    // %D Date in the format mm/dd/yy.
+                    icuFormat.append("MM/dd/yy"); // yy really shortened?
                     break;
 
-                    case 'B':
-                        // full month name
-                        icuFormat.append("LLLL");
-                        break;
+                case 'e':
+                    // correct? there should be explicit space fill or something?
+                    icuFormat.append("d");
+                    break;
 
-                    case 'c': {
-                        // FDCC-set's appropriate date and time representation
-
-                        // This is ugly but possibly the only way to get the appropriate presentation
-                        icu::Locale msgLocale = d->getCategoryLocale(MLcMessages);
-                        DateFormat *df
-                            = icu::DateFormat::createDateTimeInstance(icu::DateFormat::kDefault,
-                                                                      icu::DateFormat::kDefault,
-                                                                      msgLocale);
-                        icu::UnicodeString dateTime;
-                        icu::FieldPosition fieldPos;
-                        dateTime = df->format(*mCalendar.d_ptr->_calendar, dateTime, fieldPos);
-                        icuFormat.append('\'');
-                        QString pattern = MIcuConversions::unicodeStringToQString(dateTime);
-                        icuFormat.append(MIcuConversions::icuDatePatternEscaped(pattern));
-                        icuFormat.append('\'');
-                        delete df;
+                case 'F':
+                    //The date in the format YYYY-MM-DD (An ISO 8601 format).
+                    icuFormat.append("yyyy-MM-dd");
+                    break;
 
-                        canCacheIcuFormat = false;
-                        break;
-                    }
+                case 'g':
+                    icuFormat.append("YY");
+                    break;
 
-                    case 'C': {
-                        // century, no corresponding icu pattern
-                        UnicodeString str;
-                        d->_numberFormatLcTime->format(static_cast<int32_t>(mCalendar.year() / 100), str); //krazy:exclude=typedefs
-                        icuFormat.append(MIcuConversions::unicodeStringToQString(str));
+                case 'G':
+                    icuFormat.append("YYYY");
+                    break;
 
-                        canCacheIcuFormat = false;
-                        break;
-                    }
+                case 'H':
+                    // Hour (24-hour clock), as a decimal number (00-23).
+                    icuFormat.append("HH");
+                    break;
 
-                    case 'd':
-                        // Day of the month as a decimal number (01-31)
-                        icuFormat.append("dd");
-                        break;
+                case 'I':
+                    // Hour (12-hour clock), as a decimal number (01-12).
+                    icuFormat.append("hh");
+                    break;
 
-                    case 'D':
-                        // %D Date in the format mm/dd/yy.
-                        icuFormat.append("MM/dd/yy"); // yy really shortened?
-                        break;
+                case 'j':
+                    // day of year
+                    icuFormat.append("DDD");
+                    break;
 
-                    case 'e':
-                        // correct? there should be explicit space fill or something?
-                        icuFormat.append("d");
-                        break;
+                case 'm':
+                    // month
+                    icuFormat.append("MM");
+                    break;
 
-                    case 'F':
-                        //The date in the format YYYY-MM-DD (An ISO 8601 format).
-                        icuFormat.append("yyyy-MM-dd");
-                        break;
+                case 'M':
+                    // minute
+                    icuFormat.append("mm");
+                    break;
 
-                    case 'g':
-                        icuFormat.append("YY");
-                        break;
+                case 'n':
+                    // newline
+                    icuFormat.append('\n');
+                    break;
 
-                    case 'G':
-                        icuFormat.append("YYYY");
-                        break;
+                case 'p':
+                    // AM/PM
+                    icuFormat.append("aaa");
+                    break;
 
-                    case 'H':
-                        // Hour (24-hour clock), as a decimal number (00-23).
-                        icuFormat.append("HH");
-                        break;
+                case 'r': {
+                    // 12 hour clock with am/pm
+                    QString timeShortFormat
+                        = icuFormatString(MLocale::DateNone, MLocale::TimeShort,
+                                          MLocale::GregorianCalendar,
+                                          MLocale::TwelveHourTimeFormat24h);
+                    icuFormat.append(timeShortFormat);
+                    break;
+                }
 
-                    case 'I':
-                        // Hour (12-hour clock), as a decimal number (01-12).
-                        icuFormat.append("hh");
-                        break;
+                case 'R': {
+                    // 24-hour clock time, in the format "%H:%M"
+                    QString timeShortFormat
+                        = icuFormatString(MLocale::DateNone, MLocale::TimeShort,
+                                          MLocale::GregorianCalendar,
+                                          MLocale::TwentyFourHourTimeFormat24h);
+                    icuFormat.append(timeShortFormat);
+                    break;
+                }
 
-                    case 'j':
-                        // day of year
-                        icuFormat.append("DDD");
-                        break;
+                case 'S':
+                    // seconds
+                    icuFormat.append("ss");
+                    break;
 
-                    case 'm':
-                        // month
-                        icuFormat.append("MM");
-                        break;
+                case 't':
+                    // tab
+                    icuFormat.append('\t');
+                    break;
 
-                    case 'M':
-                        // minute
-                        icuFormat.append("mm");
-                        break;
+                case 'T': // FIXME!
+                    // 24 hour clock HH:MM:SS
+                    icuFormat.append("kk:mm:ss");
+                    break;
 
-                    case 'n':
-                        // newline
-                        icuFormat.append('\n');
-                        break;
+                case 'u':
+                    // Weekday, as a decimal number (1(Monday)-7)
+                    // no corresponding icu pattern for monday based weekday
+                    slot = PosixFormatSegment::WeekdayFromMonday;
+                    break;
 
-                    case 'p':
-                        // AM/PM
-                        icuFormat.append("aaa");
-                        break;
+                case 'U':
+                    // Week number of the year (Sunday as the first day of the week) as a
+                    // decimal number (00-53). First week starts from first Sunday.
+                    slot = PosixFormatSegment::WeekNumberFromSunday;
+                    break;
 
-                    case 'r': {
-                        // 12 hour clock with am/pm
-                        QString timeShortFormat
-                            = d->icuFormatString(MLocale::DateNone, MLocale::TimeShort,
-                                                 MLocale::GregorianCalendar,
-                                                 MLocale::TwelveHourTimeFormat24h);
-                        icuFormat.append(timeShortFormat);
-                        break;
-                    }
+                case 'v': // same as %V, for compatibility
+                case 'V':
+                    // Week of the year (Monday as the first day of the week), as a decimal
+                    // number (01-53). according to ISO-8601
+                    slot = PosixFormatSegment::IsoWeekNumber;
+                    break;
 
-                    case 'R': {
-                        // 24-hour clock time, in the format "%H:%M"
-                        QString timeShortFormat
-                            = d->icuFormatString(MLocale::DateNone, MLocale::TimeShort,
-                                                 MLocale::GregorianCalendar,
-                                                 MLocale::TwentyFourHourTimeFormat24h);
-                        icuFormat.append(timeShortFormat);
-                        break;
-                    }
+                case 'w':
+                    // Weekday, as a decimal number (0(Sunday)-6)
+                    slot = PosixFormatSegment::WeekdayFromSunday;
+                    break;
 
-                    case 'S':
-                        // seconds
-                        icuFormat.append("ss");
-                        break;
+                case 'W':
+                    // Week number of the year (Monday as the first day of the week), as a
+                    // decimal number (00-53). Week starts from the first monday
+                    slot = PosixFormatSegment::WeekNumberFromMonday;
+                    break;
 
-                    case 't':
-                        // tab
-                        icuFormat.append('\t');
-                        break;
+                case 'x':
+                    // appropriate date representation
+                    slot = PosixFormatSegment::DateRepresentation;
+                    break;
 
-                    case 'T': // FIXME!
-                        // 24 hour clock HH:MM:SS
-                        icuFormat.append("kk:mm:ss");
-                        break;
+                case 'X':
+                    // appropriate time representation
+                    slot = PosixFormatSegment::TimeRepresentation;
+                    break;
 
-                    case 'u': {
-                        // Weekday, as a decimal number (1(Monday)-7)
-                        // no corresponding icu pattern for monday based weekday
-                        UnicodeString str;
-                        d->_numberFormatLcTime->format(static_cast<int32_t>(mCalendar.dayOfWeek()), str); //krazy:exclude=typedefs
-                        icuFormat.append(MIcuConversions::unicodeStringToQString(str));
+                case 'y':
+                    // year within century
+                    icuFormat.append("yy");
+                    break;
 
-                        canCacheIcuFormat = false;
-                        break;
-                    }
+                case 'Y':
+                    // year with century
+                    icuFormat.append("yyyy");
+                    break;
 
-                    case 'U': {
-                        // Week number of the year (Sunday as the first day of the week) as a
-                        // decimal number (00-53). First week starts from first Sunday.
-                        UnicodeString str;
-                        d->_numberFormatLcTime->format(static_cast<int32_t>(0), str); //krazy:exclude=typedefs
-                        d->_numberFormatLcTime->format(static_cast<int32_t>(weekNumberStartingFromDay(mCalendar, MLocale::Sunday)), str); //krazy:exclude=typedefs
-                        QString weeknumber = MIcuConversions::unicodeStringToQString(str);
-                        if (weeknumber.length() > 2)
-                            weeknumber = weeknumber.right(2);
-                        icuFormat.append(weeknumber);
-
-                        canCacheIcuFormat = false;
-                        break;
-                    }
+                case 'z':
+                    // The offset from UTC in the ISO 8601 format "-0430" (meaning 4 hours
+                    // 30 minutes behind UTC, west of Greenwich), or by no characters if no
+                    // time zone is determinable
+                    icuFormat.append("Z"); // correct?
+                    break;
 
-                    case 'v': // same as %V, for compatibility
-                    case 'V': {
-                        // Week of the year (Monday as the first day of the week), as a decimal
-                        // number (01-53). according to ISO-8601
-                        MCalendar calendarCopy = mCalendar;
-                        calendarCopy.setFirstDayOfWeek(MLocale::Monday);
-                        calendarCopy.setMinimalDaysInFirstWeek(4);
-                        UnicodeString str;
-                        d->_numberFormatLcTime->format(static_cast<int32_t>(0), str); //krazy:exclude=typedefs
-                        d->_numberFormatLcTime->format(static_cast<int32_t>(calendarCopy.weekNumber()), str); //krazy:exclude=typedefs
-                        QString weeknumber = MIcuConversions::unicodeStringToQString(str);
-                        if (weeknumber.length() > 2)
-                            weeknumber = weeknumber.right(2); // cut leading 0
-                        icuFormat.append(weeknumber);
-
-                        canCacheIcuFormat = false;
-                        break;
-                    }
+                case 'Z':
+                    // ISO-14652 (draft):
+                    //   Time-zone name, or no characters if no time zone is determinable
+                    // Linux date command, strftime (glibc):
+                    //   alphabetic time zone abbreviation (e.g., EDT)
+                    // note that the ISO-14652 draft does not mention abbreviation,
+                    // i.e. it is a bit unclear how exactly this should look like.
+                    icuFormat.append("vvvv"); // generic time zone info
+                    break;
 
-                    case 'w': {
-                        // Weekday, as a decimal number (0(Sunday)-6)
-                        int weekday = mCalendar.dayOfWeek();
-                        if (weekday == Sunday) {
-                            weekday = 0;
-                        }
-                        UnicodeString str;
-                        d->_numberFormatLcTime->format(static_cast<int32_t>(weekday), str); //krazy:exclude=typedefs
-                        icuFormat.append(MIcuConversions::unicodeStringToQString(str));
+                case '%':
+                    icuFormat.append("%");
+                    break;
+            }
 
-                        canCacheIcuFormat = false;
-                        break;
-                    }
+            if (slot != PosixFormatSegment::IcuPattern) {
+                // the pattern so far is complete, quotations are
+                // closed at the '%' already
+                if (!icuFormat.isEmpty()) {
+                    PosixFormatSegment segment = { PosixFormatSegment::IcuPattern, icuFormat };
+                    plan->append(segment);
+                    icuFormat.clear();
+                }
+                PosixFormatSegment segment = { slot, QString() };
+                plan->append(segment);
+            }
 
-                    case 'W': {
-                        // Week number of the year (Monday as the first day of the week), as a
-                        // decimal number (00-53). Week starts from the first monday
-                        int weeknumber = weekNumberStartingFromDay(mCalendar, MLocale::Monday);
-                        UnicodeString str;
-                        d->_numberFormatLcTime->format(static_cast<int32_t>(weeknumber), str); //krazy:exclude=typedefs
-                        icuFormat.append(MIcuConversions::unicodeStringToQString(str));
+        } else {
+            if (current == '\'') {
+                icuFormat.append("''"); // icu escape
 
-                        canCacheIcuFormat = false;
-                        break;
-                    }
+            } else if ((current >= 'a' && current <= 'z') || (current >= 'A' && current <= 'Z')) {
+                if (isInNormalText == false) {
+                    icuFormat.append('\'');
+                    isInNormalText = true;
+                }
 
-                    case 'x': {
-                        // appropriate date representation
-                        icu::Locale msgLocale = d->getCategoryLocale(MLcMessages);
-                        DateFormat *df
-                            = icu::DateFormat::createDateInstance(icu::DateFormat::kDefault,
-                                                                  msgLocale);
-                        icu::UnicodeString dateTime;
-                        icu::FieldPosition fieldPos;
-                        dateTime = df->format(*mCalendar.d_ptr->_calendar, dateTime, fieldPos);
-                        icuFormat.append('\'');
-                        QString pattern = MIcuConversions::unicodeStringToQString(dateTime);
-                        icuFormat.append(MIcuConversions::icuDatePatternEscaped(pattern));
-                        icuFormat.append('\'');
-                        delete df;
+                icuFormat.append(current);
 
-                        canCacheIcuFormat = false;
-                        break;
-                    }
+            } else {
+                icuFormat.append(current);
+            }
+        }
+    } // for loop
 
-                    case 'X': {
-                        // appropriate time representation
-                        icu::Locale msgLocale = d->getCategoryLocale(MLcMessages);
-                        DateFormat *df
-                            = icu::DateFormat::createTimeInstance(icu::DateFormat::kDefault,
-                                                                  msgLocale);
-                        icu::UnicodeString dateTime;
-                        icu::FieldPosition fieldPos;
-                        dateTime = df->format(*mCalendar.d_ptr->_calendar, dateTime, fieldPos);
-                        icuFormat.append('\'');
-                        QString pattern = MIcuConversions::unicodeStringToQString(dateTime);
-                        icuFormat.append(MIcuConversions::icuDatePatternEscaped(pattern));
-                        icuFormat.append('\'');
-                        delete df;
+    if (!icuFormat.isEmpty()) {
+        PosixFormatSegment segment = { PosixFormatSegment::IcuPattern, icuFormat };
+        plan->append(segment);
+    }
+    return plan;
+}
+#endif
 
-                        canCacheIcuFormat = false;
-                        break;
-                    }
+#ifdef HAVE_ICU
+icu::DateFormat *MLocalePrivate::posixRepresentationFormat(PosixFormatSegment::Kind kind) const
+{
+    const int index = kind - PosixFormatSegment::DateTimeRepresentation;
+    icu::DateFormat *&format = formatters()->posixRepresentationFormats[index];
+    if (!format) {
+        // This is ugly but possibly the only way to get the appropriate presentation
+        icu::Locale msgLocale = getCategoryLocale(MLocale::MLcMessages);
+        switch (kind) {
+        case PosixFormatSegment::DateTimeRepresentation:
+            format = icu::DateFormat::createDateTimeInstance(icu::DateFormat::kDefault,
+                                                             icu::DateFormat::kDefault,
+                                                             msgLocale);
+            break;
+        case PosixFormatSegment::DateRepresentation:
+            format = icu::DateFormat::createDateInstance(icu::DateFormat::kDefault,
+                                                         msgLocale);
+            break;
+        default:
+            format = icu::DateFormat::createTimeInstance(icu::DateFormat::kDefault,
+                                                         msgLocale);
+            break;
+        }
+    }
+    return format;
+}
 
-                    case 'y':
-                        // year within century
-                        icuFormat.append("yy");
-                        break;
+void MLocalePrivate::FormatterStore::dropPosixRepresentationFormats()
+{
+    for (int i = 0; i < PosixRepresentationCount; ++i) {
+        delete posixRepresentationFormats[i];
+        posixRepresentationFormats[i] = 0;
+    }
+}
+#endif
 
-                    case 'Y':
-                        // year with century
-                        icuFormat.append("yyyy");
-                        break;
+#ifdef HAVE_ICU
+QString MLocale::formatDateTime(const MCalendar &mCalendar,
+                                  const QString &formatString) const
+{
+    Q_D(const MLocale);
 
-                    case 'z':
-                        // The offset from UTC in the ISO 8601 format "-0430" (meaning 4 hours
-                        // 30 minutes behind UTC, west of Greenwich), or by no characters if no
-                        // time zone is determinable
-                        icuFormat.append("Z"); // correct?
-                        break;
+    const MLocalePrivate::PosixFormatPlan *plan
+        = d->formatters()->posixFormatPlanCache.object(formatString);
+    if (!plan) {
+        MLocalePrivate::PosixFormatPlan *newPlan = d->compilePosixFormat(formatString);
+        d->formatters()->posixFormatPlanCache.insert(formatString, newPlan,
+                                                    MLocalePrivate::approximateSize(*newPlan));
+        plan = newPlan;
+    }
+    // the common case, no slots:
+    if (plan->size() == 1 && plan->at(0).kind == MLocalePrivate::PosixFormatSegment::IcuPattern)
+        return formatDateTimeICU(mCalendar, plan->at(0).pattern);
 
-                    case 'Z':
-                        // ISO-14652 (draft):
-                        //   Time-zone name, or no characters if no time zone is determinable
-                        // Linux date command, strftime (glibc):
-                        //   alphabetic time zone abbreviation (e.g., EDT)
-                        // note that the ISO-14652 draft does not mention abbreviation,
-                        // i.e. it is a bit unclear how exactly this should look like.
-                        icuFormat.append("vvvv"); // generic time zone info
-                        break;
+    QString result;
+    for (int i = 0; i < plan->size(); ++i) {
+        const MLocalePrivate::PosixFormatSegment &segment = plan->at(i);
+        UnicodeString str;
+        switch (segment.kind) {
+        case MLocalePrivate::PosixFormatSegment::IcuPattern:
+            result.append(formatDateTimeICU(mCalendar, segment.pattern));
+            continue;
 
-                    case '%':
-                        icuFormat.append("%");
-                        break;
-                }
+        case MLocalePrivate::PosixFormatSegment::DateTimeRepresentation:
+        case MLocalePrivate::PosixFormatSegment::DateRepresentation:
+        case MLocalePrivate::PosixFormatSegment::TimeRepresentation: {
+            icu::DateFormat *df = d->posixRepresentationFormat(segment.kind);
+            icu::FieldPosition fieldPos;
+            if (df)
+                df->format(*mCalendar.d_ptr->_calendar, str, fieldPos);
+            break;
+        }
 
-            } else {
-                if (current == '\'') {
-                    icuFormat.append("''"); // icu escape
+        case MLocalePrivate::PosixFormatSegment::Century:
+            d->_numberFormatLcTime->format(static_cast<int32_t>(mCalendar.year() / 100), str); //krazy:exclude=typedefs
+            break;
 
-                } else if ((current >= 'a' && current <= 'z') || (current >= 'A' && current <= 'Z')) {
-                    if (isInNormalText == false) {
-                        icuFormat.append('\'');
-                        isInNormalText = true;
-                    }
+        case MLocalePrivate::PosixFormatSegment::WeekdayFromMonday:
+            d->_numberFormatLcTime->format(static_cast<int32_t>(mCalendar.dayOfWeek()), str); //krazy:exclude=typedefs
+            break;
 
-                    icuFormat.append(current);
+        case MLocalePrivate::PosixFormatSegment::WeekNumberFromSunday: {
+            d->_numberFormatLcTime->format(static_cast<int32_t>(0), str); //krazy:exclude=typedefs
+            d->_numberFormatLcTime->format(static_cast<int32_t>(mCalendar.weekNumberStartingFromDay(MLocale::Sunday)), str); //krazy:exclude=typedefs
+            QString weeknumber = MIcuConversions::unicodeStringToQString(str);
+            if (weeknumber.length() > 2)
+                weeknumber = weeknumber.right(2);
+            result.append(weeknumber);
+            continue;
+        }
+
+        case MLocalePrivate::PosixFormatSegment::IsoWeekNumber: {
+            d->_numberFormatLcTime->format(static_cast<int32_t>(0), str); //krazy:exclude=typedefs
+            d->_numberFormatLcTime->format(static_cast<int32_t>(mCalendar.isoWeekNumber()), str); //krazy:exclude=typedefs
+            QString weeknumber = MIcuConversions::unicodeStringToQString(str);
+            if (weeknumber.length() > 2)
+                weeknumber = weeknumber.right(2); // cut leading 0
+            result.append(weeknumber);
+            continue;
+        }
 
-                } else {
-                    icuFormat.append(current);
-                }
+        case MLocalePrivate::PosixFormatSegment::WeekdayFromSunday: {
+            int weekday = mCalendar.dayOfWeek();
+            if (weekday == Sunday) {
+                weekday = 0;
             }
-        } // for loop
-
-        // save formatString -> icuFormat pair for future use,
-        // if it does not contain content from the input date or time
-        if ( canCacheIcuFormat )
-        {
-            QString* value = new QString( icuFormat );
+            d->_numberFormatLcTime->format(static_cast<int32_t>(weekday), str); //krazy:exclude=typedefs
+            break;
+        }
 
-            d->_icuFormatStringCache.insert( formatString, value );
+        case MLocalePrivate::PosixFormatSegment::WeekNumberFromMonday: {
+            int weeknumber = mCalendar.weekNumberStartingFromDay(MLocale::Monday);
+            d->_numberFormatLcTime->format(static_cast<int32_t>(weeknumber), str); //krazy:exclude=typedefs
+            break;
         }
+        }
+        result.append(MIcuConversions::unicodeStringToQString(str));
     }
-    else
-    {
-        // formatString does exist in hash
-        icuFormat = *d->_icuFormatStringCache[ formatString ];
-    }
-
-    return formatDateTimeICU(mCalendar, icuFormat);
+    return result;
 }
 #endif
 
@@ -3497,6 +5664,36 @@ QString MLocale::icuFormatString( DateType dateType,
 }
 #endif
 
+#ifdef HAVE_ICU
+QString MLocale::icuFormatStringForSkeleton(const QString &skeleton,
+                                            CalendarType calendarType) const
+{
+    Q_D(const MLocale);
+    return d->skeletonFormatString(skeleton, calendarType);
+}
+
+QString MLocale::formatDateTimeWithSkeleton(const MCalendar &mCalendar,
+                                            const QString &skeleton) const
+{
+    Q_D(const MLocale);
+    const QString pattern = d->skeletonFormatString(skeleton, mCalendar.type());
+    if (pattern.isEmpty())
+        return QString();
+    return formatDateTimeICU(mCalendar, pattern);
+}
+
+QString MLocale::formatDateTimeWithSkeleton(const QDateTime &dateTime,
+                                            const QString &skeleton,
+                                            CalendarType calendarType) const
+{
+    Q_D(const MLocale);
+    MCalendar *calendar = d->scratchCalendar(calendarType);
+    UErrorCode status = U_ZERO_ERROR;
+    calendar->d_ptr->_calendar->setTime(MLocalePrivate::scratchDate(calendar, dateTime), status);
+    return formatDateTimeWithSkeleton(*calendar, skeleton);
+}
+#endif
+
 #ifdef HAVE_ICU
 QDateTime MLocale::parseDateTime(const QString &dateTime, DateType dateType,
                                    TimeType timeType, CalendarType calendarType) const
@@ -3505,7 +5702,7 @@ QDateTime MLocale::parseDateTime(const QString &dateTime, DateType dateType,
         return QDateTime();
 
     Q_D(const MLocale);
-    MCalendar mcalendar(calendarType);
+    MCalendar &mcalendar = *d->scratchCalendar(calendarType);
 
     UnicodeString text = MIcuConversions::qStringToUnicodeString(dateTime);
     icu::DateFormat *df = d->createDateFormat(dateType, timeType,
@@ -3535,6 +5732,13 @@ QDateTime MLocale::parseDateTime(const QString &dateTime, CalendarType calendarT
 }
 #endif
 
+#ifdef HAVE_ICU
+MDateTimeParser MLocale::dateTimeParser(CalendarType calendarType) const
+{
+    return MDateTimeParser(*this, calendarType);
+}
+#endif
+
 #ifdef HAVE_ICU
 QString MLocale::monthName(const MCalendar &mCalendar, int monthNumber) const
 {
@@ -3548,40 +5752,20 @@ QString MLocale::monthName(const MCalendar &mCalendar, int monthNumber,
                              DateSymbolLength symbolLength) const
 {
     Q_D(const MLocale);
+    // months in array starting from index zero
+    return d->dateSymbolNames(MLocalePrivate::MonthSymbols, mCalendar.type(),
+                              context, symbolLength).value(monthNumber - 1);
+}
+#endif
 
-    monthNumber--; // months in array starting from index zero
-
-    QString categoryNameMessages = d->categoryName(MLcMessages);
-    QString categoryName = d->categoryName(MLcTime);
-    if(d->mixingSymbolsWanted(categoryNameMessages, categoryName))
-        categoryName = categoryNameMessages;
-    categoryName = MIcuConversions::setCalendarOption(categoryName, mCalendar.type());
-    icu::Locale symbolLocale = icu::Locale(qPrintable(categoryName));
-
-    icu::DateFormatSymbols *dfs = MLocalePrivate::createDateFormatSymbols(symbolLocale);
-
-    // map context type
-    icu::DateFormatSymbols::DtContextType icuContext =
-        MIcuConversions::mDateContextToIcu(context);
-
-    // map length type
-    icu::DateFormatSymbols::DtWidthType icuWidth =
-        MIcuConversions::mDateWidthToIcu(symbolLength);
-
-    int len = -1;
-    const UnicodeString *months = dfs->getMonths(len, icuContext, icuWidth);
-
-    QString result;
-
-    if (len > 0 && monthNumber < len && monthNumber >= 0) {
-        result = MIcuConversions::unicodeStringToQString(months[monthNumber]);
-    }
-
-    delete dfs;
-
-    if(!result.isEmpty() && context == MLocale::DateSymbolStandalone)
-        result[0] = toUpper(result.at(0))[0];
-    return result;
+#ifdef HAVE_ICU
+QStringList MLocale::monthNames(const MCalendar &mCalendar,
+                                DateSymbolContext context,
+                                DateSymbolLength symbolLength) const
+{
+    Q_D(const MLocale);
+    return d->dateSymbolNames(MLocalePrivate::MonthSymbols, mCalendar.type(),
+                              context, symbolLength);
 }
 #endif
 
@@ -3598,36 +5782,20 @@ QString MLocale::weekdayName(const MCalendar &mCalendar, int weekday,
                                DateSymbolLength symbolLength) const
 {
     Q_D(const MLocale);
-    QString categoryNameMessages = d->categoryName(MLcMessages);
-    QString categoryName = d->categoryName(MLcTime);
-     if(d->mixingSymbolsWanted(categoryNameMessages, categoryName))
-        categoryName = categoryNameMessages;
-    categoryName = MIcuConversions::setCalendarOption(categoryName, mCalendar.type());
-    icu::Locale symbolLocale = icu::Locale(qPrintable(categoryName));
-
-    icu::DateFormatSymbols *dfs = MLocalePrivate::createDateFormatSymbols(symbolLocale);
-
-    icu::DateFormatSymbols::DtContextType icuContext
-    = MIcuConversions::mDateContextToIcu(context);
-
-    icu::DateFormatSymbols::DtWidthType icuWidth
-    = MIcuConversions::mDateWidthToIcu(symbolLength);
-
-    int len = -1;
-    const UnicodeString *weekdayNames = dfs->getWeekdays(len, icuContext, icuWidth);
-    int weekdayNum = MIcuConversions::icuWeekday(weekday);
-
-    QString result;
-
-    if (len > 0 && weekdayNum < len && weekdayNum > 0) {
-        result = MIcuConversions::unicodeStringToQString(weekdayNames[weekdayNum]);
-    }
-
-    delete dfs;
+    // the list starts with Monday = 1
+    return d->dateSymbolNames(MLocalePrivate::WeekdaySymbols, mCalendar.type(),
+                              context, symbolLength).value(weekday - 1);
+}
+#endif
 
-    if(!result.isEmpty() && context == MLocale::DateSymbolStandalone)
-        result[0] = toUpper(result.at(0))[0];
-    return result;
+#ifdef HAVE_ICU
+QStringList MLocale::weekdayNames(const MCalendar &mCalendar,
+                                  DateSymbolContext context,
+                                  DateSymbolLength symbolLength) const
+{
+    Q_D(const MLocale);
+    return d->dateSymbolNames(MLocalePrivate::WeekdaySymbols, mCalendar.type(),
+                              context, symbolLength);
 }
 #endif
 
@@ -3645,45 +5813,25 @@ QString MLocale::countryEndonym() const
 {
 #ifdef HAVE_ICU
     Q_D(const MLocale);
-    QString resourceBundleLocaleName = d->_defaultLocale;
     QString countryCode = country();
     if (countryCode.isEmpty())
         return QString();
 
-    do {
-        // Trying several resource bundles is a workaround for
-        // http://site.icu-project.org/design/resbund/issues
-        UErrorCode status = U_ZERO_ERROR;
-        UResourceBundle *res = ures_open(U_ICUDATA_NAME "-region",
-                                         qPrintable(resourceBundleLocaleName),
-                                         &status);
-        if (U_FAILURE(status)) {
-            mDebug("MLocale") << __PRETTY_FUNCTION__ << "Error ures_open"
-                              << u_errorName(status);
-            ures_close(res);
-            return countryCode;
-        }
-        res = ures_getByKey(res, Countries, res, &status);
-        if (U_FAILURE(status)) {
-            mDebug("MLocale") << __PRETTY_FUNCTION__ << "Error ures_getByKey"
-                              << u_errorName(status);
-            ures_close(res);
-            return countryCode;
-        }
-        int len;
-        const UChar *val = ures_getStringByKey(res,
-                                               countryCode.toStdString().c_str(),
-                                               &len,
-                                               &status);
-        ures_close(res);
-        if (U_SUCCESS(status)) {
-            // found country endonym, return it:
-            return QString::fromUtf16(val, len);
-        }
-    } while (d->truncateLocaleName(&resourceBundleLocaleName));
-    // no country endonym found and there are no other resource
-    // bundles left to try, return the country code as a fallback:
-    return countryCode;
+    const MLocaleMetadataTable *table = MLocaleMetadataTable::instance();
+    QString countryEndonym;
+    if (table && table->lookup(d->_defaultLocale, MLocaleMetadataTable::CountryEndonym,
+                               &countryEndonym))
+        return countryEndonym;
+    countryEndonym
+        = MLocalePrivate::cachedResourceString(U_ICUDATA_NAME "-region",
+                                               d->_defaultLocale,
+                                               QString::fromLatin1(Countries)
+                                               + QLatin1Char('/') + countryCode);
+    // if no country endonym is found, return the country code as a
+    // fallback:
+    if (countryEndonym.isNull())
+        return countryCode;
+    return countryEndonym;
 #else
     Q_D(const MLocale);
     return QLocale::countryToString(d->createQLocale(MLcMessages).country());
@@ -3700,41 +5848,16 @@ QString MLocalePrivate::numberingSystem(const QString &localeName) const
     // system actually exists for this locale:
     if (!numberingSystem.isEmpty())
         return numberingSystem;
-    QString resourceBundleLocaleName = localeName;
-    numberingSystem = QLatin1String("latn");
-    do {
-        // Trying several resource bundles is a workaround for
-        // http://site.icu-project.org/design/resbund/issues
-        UErrorCode status = U_ZERO_ERROR;
-        UResourceBundle *res = ures_open(NULL,
-                                         qPrintable(resourceBundleLocaleName),
-                                         &status);
-        if (U_FAILURE(status)) {
-            mDebug("MLocale") << __PRETTY_FUNCTION__ << "Error ures_open"
-                              << resourceBundleLocaleName
-                              << u_errorName(status);
-            ures_close(res);
-            return numberingSystem;
-        }
-        int len;
-        res = ures_getByKey(res, "NumberElements", res, &status);
-        if (U_FAILURE(status)) {
-            ures_close(res);
-            continue;
-        }
-        const UChar *val = ures_getStringByKey(res,
-                                               "default",
-                                               &len,
-                                               &status);
-
-        ures_close(res);
-        if (U_SUCCESS(status)) {
-            // found numbering system, return it:
-            return QString::fromUtf16(val, len);
-        }
-    } while (truncateLocaleName(&resourceBundleLocaleName));
-    // no numbering system found and there are no other resource
-    // bundles left to try, return “latn” as a fallback:
+    const MLocaleMetadataTable *table = MLocaleMetadataTable::instance();
+    if (table && table->lookup(localeName, MLocaleMetadataTable::NumberingSystem,
+                               &numberingSystem))
+        return numberingSystem;
+    numberingSystem
+        = cachedResourceString(NULL, localeName,
+                               QLatin1String("NumberElements/default"));
+    // if no numbering system is found, return “latn” as a fallback:
+    if (numberingSystem.isNull())
+        return QLatin1String("latn");
     return numberingSystem;
 #else
     QString language = parseLanguage(localeName);
@@ -3766,50 +5889,21 @@ QString MLocale::decimalPoint() const
 #ifdef HAVE_ICU
     Q_D(const MLocale);
     QString categoryNameNumeric =
-        d->fixCategoryNameForNumbers(d->categoryName(MLocale::MLcNumeric));
+        d->categoryNameForNumbers(MLocale::MLcNumeric);
+    const MLocaleMetadataTable *table = MLocaleMetadataTable::instance();
+    QString decimal;
+    if (table && table->lookup(categoryNameNumeric, MLocaleMetadataTable::DecimalPoint,
+                               &decimal))
+        return decimal;
     QString numberingSystem = d->numberingSystem(categoryNameNumeric);
-    QString resourceBundleLocaleName = categoryNameNumeric;
-    QString decimal = QLatin1String(".");
-    do {
-        // Trying several resource bundles is a workaround for
-        // http://site.icu-project.org/design/resbund/issues
-        UErrorCode status = U_ZERO_ERROR;
-        UResourceBundle *res = ures_open(NULL,
-                                         qPrintable(resourceBundleLocaleName),
-                                         &status);
-        if (U_FAILURE(status)) {
-            mDebug("MLocale") << __PRETTY_FUNCTION__ << "Error ures_open"
-                              << resourceBundleLocaleName
-                              << u_errorName(status);
-            ures_close(res);
-            return decimal;
-        }
-        res = ures_getByKey(res, "NumberElements", res, &status);
-        if (U_FAILURE(status)) {
-            ures_close(res);
-            continue;
-        }
-        int len;
-        res = ures_getByKey(res, numberingSystem.toStdString().c_str(),
-                            res, &status);
-        if (U_FAILURE(status)) {
-            ures_close(res);
-            continue;
-        }
-        res = ures_getByKey(res, "symbols", res, &status);
-        if (U_FAILURE(status)) {
-            ures_close(res);
-            continue;
-        }
-        const UChar *val = ures_getStringByKey(res, "decimal", &len, &status);
-        ures_close(res);
-        if (U_SUCCESS(status)) {
-            // found decimal point, return it:
-            return QString::fromUtf16(val, len);
-        }
-    } while (d->truncateLocaleName(&resourceBundleLocaleName));
-    // no decimal point found and there are no other resource
-    // bundles left to try, return “.” as a fallback:
+    decimal
+        = MLocalePrivate::cachedResourceString(NULL, categoryNameNumeric,
+                                               QLatin1String("NumberElements/")
+                                               + numberingSystem
+                                               + QLatin1String("/symbols/decimal"));
+    // if no decimal point is found, return “.” as a fallback:
+    if (decimal.isNull())
+        return QLatin1String(".");
     return decimal;
 #else
     Q_D(const MLocale);
@@ -3845,7 +5939,11 @@ QString MLocale::joinStringList(const QStringList &texts) const
 QStringList MLocale::exemplarCharactersIndex() const
 {
     Q_D(const MLocale);
-    QString collationLocaleName = d->categoryName(MLcCollate);
+    return d->cachedExemplarCharactersIndex();
+}
+
+QStringList MLocalePrivate::lookupExemplarCharactersIndex(QString collationLocaleName)
+{
     // exemplarCharactersIndex is initialized with A...Z which is
     // returned as a fallback when no real index list can be found for
     // the current locale:
@@ -4090,6 +6188,7 @@ QStringList MLocale::localeScripts() const
 void MLocale::copyCatalogsFrom(const MLocale &other)
 {
     Q_D(MLocale);
+    d->dropThreadPrivates();
 
     MLocalePrivate::CatalogList::const_iterator end =
         other.d_ptr->_messageTranslations.constEnd();
@@ -4131,6 +6230,7 @@ void MLocale::copyCatalogsFrom(const MLocale &other)
 void MLocale::installTrCatalog(const QString &name)
 {
     Q_D(MLocale);
+    d->dropThreadPrivates();
 
     // Make sure that previous installations of a catalog are removed
     // first before trying to install a catalog.  There is no need to
@@ -4156,6 +6256,7 @@ void MLocale::installTrCatalog(const QString &name)
 void MLocale::removeTrCatalog(const QString &name)
 {
     Q_D(MLocale);
+    d->dropThreadPrivates();
     MLocalePrivate::CatalogList::iterator it = d->_trTranslations.begin();
     while (it != d->_trTranslations.end()) {
         if ((*it)->_name == name || (*it)->_name == name + ".qm") {
@@ -4223,7 +6324,12 @@ void MLocale::setDataPaths(const QStringList &dataPaths)
     }
 
     u_setDataDirectory(qPrintable(pathString));
+    MLocalePrivate::clearResourceCache();
+    MLocaleMetadataTable::reset();
+    // formatters created from the old data are not used any more:
+    MLocalePrivate::_dataPathsSerial.ref();
 #endif
+    MLocalePrivate::clearLocalizedDigits();
 }
 
 // convenience method for just one path
@@ -4237,12 +6343,26 @@ QStringList MLocale::dataPaths()
     return MLocalePrivate::dataPaths;
 }
 
-QString MLocale::toLocalizedNumbers(const QString &text) const
+namespace
+{
+    // process wide table of the digits used by the numeric locales,
+    // see MLocalePrivate::localizedDigits()
+    struct MLocalizedDigitsTable
+    {
+        MLocalizedDigitsTable() : generation(0) {}
+
+        QMutex mutex;
+        QHash<QString, QString> digits;
+        // incremented by clearLocalizedDigits(), lookups which were
+        // started before are not inserted
+        int generation;
+    };
+}
+
+Q_GLOBAL_STATIC(MLocalizedDigitsTable, localizedDigitsTable)
+
+QString MLocalePrivate::digitsOfNumberingSystem(const QString &targetNumberingSystem)
 {
-    Q_D(const MLocale);
-    QString categoryNameNumeric =
-        d->fixCategoryNameForNumbers(d->categoryName(MLocale::MLcNumeric));
-    QString targetNumberingSystem = d->numberingSystem(categoryNameNumeric);
     QString targetDigits;
 #ifdef HAVE_ICU
     UErrorCode status = U_ZERO_ERROR;
@@ -4279,7 +6399,7 @@ QString MLocale::toLocalizedNumbers(const QString &text) const
     }
     delete targetNumSys;
     if (!ok)
-        return text;
+        return QString();
 #else
     if(targetNumberingSystem == "arab")
         targetDigits = QString::fromUtf8("٠١٢٣٤٥٦٧٨٩");
@@ -4322,52 +6442,212 @@ QString MLocale::toLocalizedNumbers(const QString &text) const
     else
         targetDigits = QString::fromUtf8("0123456789");
 #endif
-    return MLocale::toLocalizedNumbers(text, targetDigits);
+    return targetDigits;
 }
 
-QString MLocale::toLocalizedNumbers(const QString &text, const QString &targetDigits)
+QString MLocalePrivate::localizedDigits() const
 {
-    QString result = text;
-    if(targetDigits.size() != 10)
-        return text;
-    if(targetDigits == QLatin1String("0123456789")) {
-        bool isLatin1 = true;
-        for(int i = 0; i < text.size(); ++i) {
-            if(!text.at(i).toLatin1()) {
-                isLatin1 = false;
+    const QString &categoryNameNumeric = categoryNameForNumbers(MLocale::MLcNumeric);
+    MLocalizedDigitsTable *table = localizedDigitsTable();
+    int generation;
+    {
+        QMutexLocker locker(&table->mutex);
+        QHash<QString, QString>::const_iterator it
+            = table->digits.constFind(categoryNameNumeric);
+        if (it != table->digits.constEnd())
+            return it.value();
+        generation = table->generation;
+    }
+    // look the digits up without holding the lock, the resource
+    // bundle lookups are slow and the result is the same for every
+    // thread anyway:
+    QString targetDigits
+        = digitsOfNumberingSystem(numberingSystem(categoryNameNumeric));
+    QMutexLocker locker(&table->mutex);
+    if (generation == table->generation)
+        table->digits.insert(categoryNameNumeric, targetDigits);
+    return targetDigits;
+}
+
+void MLocalePrivate::clearLocalizedDigits()
+{
+    MLocalizedDigitsTable *table = localizedDigitsTable();
+    QMutexLocker locker(&table->mutex);
+    table->digits.clear();
+    ++table->generation;
+}
+
+namespace
+{
+    const ushort latinDigits[10] = {
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9'
+    };
+
+    // the digits of the “hanidec” numbering system, these are no
+    // decimal digits for QChar::digitValue()
+    const ushort hanidecDigits[10] = {
+        0x3007, 0x4E00, 0x4E8C, 0x4E09, 0x56DB,
+        0x4E94, 0x516D, 0x4E03, 0x516B, 0x4E5D
+    };
+
+    inline int hanidecDigitValue(ushort u)
+    {
+        if (u != 0x3007 && (u < 0x4E00 || u > 0x56DB))
+            return -1;
+        for (int i = 0; i < 10; ++i) {
+            if (hanidecDigits[i] == u)
+                return i;
+        }
+        return -1;
+    }
+
+    inline bool isDirectionalFormattingCode(ushort u)
+    {
+        return u == 0x200E  // LEFT-TO-RIGHT MARK
+            || u == 0x200F  // RIGHT-TO-LEFT MARK
+            || (u >= 0x202A && u <= 0x202E); // LRE, RLE, PDF, LRO, RLO
+    }
+
+    // returns the index of the first UTF-16 unit in s[from, size)
+    // which has one of the bits of unitMask set, size if there is none
+    inline int skipUnits(const ushort *s, int from, int size, ushort unitMask)
+    {
+        // test four UTF-16 units at once:
+        const quint64 wordMask = quint64(unitMask) * Q_UINT64_C(0x0001000100010001);
+        while (from + 4 <= size) {
+            quint64 word;
+            memcpy(&word, s + from, sizeof(word));
+            if (word & wordMask)
+                break;
+            from += 4;
+        }
+        while (from < size && !(s[from] & unitMask))
+            ++from;
+        return from;
+    }
+
+    // returns the converted UTF-16 unit, -1 if u has to be removed
+    inline int convertDigit(ushort u, const ushort *targetDigits, bool latinTarget)
+    {
+        if (u < 0x80) {
+            if (u >= '0' && u <= '9')
+                return targetDigits[u - '0'];
+            return u;
+        }
+        if (latinTarget && isDirectionalFormattingCode(u))
+            return -1;
+        const int hanidecValue = hanidecDigitValue(u);
+        if (hanidecValue >= 0)
+            u = targetDigits[hanidecValue];
+        const QChar c(u);
+        if (c.isNumber()) {
+            const int value = c.digitValue();
+            if (value >= 0)
+                return targetDigits[value];
+        }
+        return u;
+    }
+
+    // Converts all digits in *text to targetDigits in a single pass.
+    // The string is only detached if something changes. If the
+    // targetDigits are Latin digits, runs of ASCII are skipped
+    // without looking at the individual characters.
+    void convertDigits(QString *text, const ushort *targetDigits)
+    {
+        const bool latinTarget
+            = memcmp(targetDigits, latinDigits, sizeof(latinDigits)) == 0;
+        const ushort *s = text->utf16();
+        const int size = text->size();
+        // Latin-1 text is returned unchanged for Latin digits:
+        if (latinTarget && skipUnits(s, 0, size, 0xFF00) == size)
+            return;
+        const ushort asciiMask = latinTarget ? 0xFF80 : 0xFFFF;
+
+        int first = 0;
+        for (;; ++first) {
+            first = skipUnits(s, first, size, asciiMask);
+            if (first == size)
+                return;
+            if (convertDigit(s[first], targetDigits, latinTarget) != s[first])
                 break;
+        }
+
+        ushort *data = reinterpret_cast<ushort *>(text->data());
+        int out = first;
+        int i = first;
+        while (i < size) {
+            const int next = skipUnits(data, i, size, asciiMask);
+            if (next > i) {
+                if (out != i)
+                    memmove(data + out, data + i, (next - i) * sizeof(ushort));
+                out += next - i;
+                i = next;
+                if (i == size)
+                    break;
             }
+            const int converted = convertDigit(data[i], targetDigits, latinTarget);
+            if (converted >= 0)
+                data[out++] = ushort(converted);
+            ++i;
         }
-        if(isLatin1)
-            return text;
-        result.remove(QChar(0x200F)); // RIGHT-TO-LEFT MARK
-        result.remove(QChar(0x200E)); // LEFT-TO-RIGHT MARK
-        result.remove(QChar(0x202D)); // LEFT-TO-RIGHT OVERRIDE
-        result.remove(QChar(0x202E)); // RIGHT-TO-LEFT OVERRIDE
-        result.remove(QChar(0x202A)); // LEFT-TO-RIGHT EMBEDDING
-        result.remove(QChar(0x202B)); // RIGHT-TO-LEFT EMBEDDING
-        result.remove(QChar(0x202C)); // POP DIRECTIONAL FORMATTING
-    }
-    QStringList sourceDigitsList;
-    sourceDigitsList << QString::fromUtf8("〇一二三四五六七八九");
-    foreach(const QString &sourceDigits, sourceDigitsList)
-        for(int i = 0; i <= 9; ++i)
-            result.replace(sourceDigits.at(i), targetDigits.at(i));
-    for(int i = 0; i < result.size(); ++i)
-        if(result[i].isNumber() && result[i].digitValue() >= 0)
-            result[i] = targetDigits[result[i].digitValue()];
+        if (out < size)
+            text->truncate(out);
+    }
+}
+
+QString MLocale::toLocalizedNumbers(const QString &text) const
+{
+    QString result = text;
+    toLocalizedNumbers(&result);
+    return result;
+}
+
+void MLocale::toLocalizedNumbers(QString *text) const
+{
+    Q_D(const MLocale);
+    const QString targetDigits = d->localizedDigits();
+    if (targetDigits.size() == 10)
+        convertDigits(text, targetDigits.utf16());
+}
+
+QString MLocale::toLocalizedNumbers(const QString &text, const QString &targetDigits)
+{
+    QString result = text;
+    toLocalizedNumbers(&result, targetDigits);
     return result;
 }
 
+void MLocale::toLocalizedNumbers(QString *text, const QString &targetDigits)
+{
+    if (targetDigits.size() == 10)
+        convertDigits(text, targetDigits.utf16());
+}
+
 QString MLocale::toLatinNumbers(const QString &text)
 {
-    return MLocale::toLocalizedNumbers(text, QLatin1String("0123456789"));
+    QString result = text;
+    toLatinNumbers(&result);
+    return result;
+}
+
+void MLocale::toLatinNumbers(QString *text)
+{
+    convertDigits(text, latinDigits);
 }
 
 #ifdef HAVE_ICU
 QString MLocale::localeScript(const QString &locale)
 {
-    QString s = MLocalePrivate::parseScript(locale);
+    const MLocaleMetadataTable *table = MLocaleMetadataTable::instance();
+    QString script;
+    if (table && table->lookup(locale, MLocaleMetadataTable::Script, &script))
+        return script;
+    return MLocalePrivate::lookupLocaleScript(locale);
+}
+
+QString MLocalePrivate::lookupLocaleScript(const QString &locale)
+{
+    QString s = parseScript(locale);
 
     if(!s.isEmpty())
         return s;
@@ -4396,7 +6676,9 @@ QString MLocale::localeScript(const QString &locale)
     return ret;
 }
 
-QString MLocale::languageEndonym(const QString &locale)
+QString MLocalePrivate::lookupLanguageEndonym(const char *bundleName,
+                                              const QString &locale,
+                                              const QString &keyPath)
 {
     QString resourceBundleLocaleName = locale;
 
@@ -4404,21 +6686,21 @@ QString MLocale::languageEndonym(const QString &locale)
         // Trying several resource bundles is a workaround for
         // http://site.icu-project.org/design/resbund/issues
         UErrorCode status = U_ZERO_ERROR;
-        UResourceBundle *res = ures_open(U_ICUDATA_NAME "-lang",
+        UResourceBundle *res = ures_open(bundleName,
                                          qPrintable(resourceBundleLocaleName),
                                          &status);
         if (U_FAILURE(status)) {
             mDebug("MLocale") << __PRETTY_FUNCTION__ << "Error ures_open"
                               << u_errorName(status);
             ures_close(res);
-            return locale;
+            return QString();
         }
-        res = ures_getByKey(res, Languages, res, &status);
+        res = ures_getByKey(res, qPrintable(keyPath), res, &status);
         if (U_FAILURE(status)) {
             mDebug("MLocale") << __PRETTY_FUNCTION__ << "Error ures_getByKey"
                               << u_errorName(status);
             ures_close(res);
-            return locale;
+            return QString();
         }
         QString keyLocaleName = locale;
         // it’s not nice if “zh_CN”, “zh_HK”, “zh_MO”, “zh_TW” all fall back to
@@ -4453,8 +6735,25 @@ QString MLocale::languageEndonym(const QString &locale)
         ures_close(res);
     } while (MLocalePrivate::truncateLocaleName(&resourceBundleLocaleName));
     // no language endonym found at all, no other keys or resource
-    // bundles left to try, return the full locale name as a fallback:
-    return locale;
+    // bundles left to try:
+    return QString();
+}
+
+QString MLocale::languageEndonym(const QString &locale)
+{
+    const MLocaleMetadataTable *table = MLocaleMetadataTable::instance();
+    QString languageEndonym;
+    if (table && table->lookup(locale, MLocaleMetadataTable::LanguageEndonym,
+                               &languageEndonym))
+        return languageEndonym;
+    languageEndonym
+        = MLocalePrivate::cachedResourceString(U_ICUDATA_NAME "-lang", locale,
+                                               QLatin1String(Languages),
+                                               MLocalePrivate::lookupLanguageEndonym);
+    // return the full locale name as a fallback:
+    if (languageEndonym.isNull())
+        return locale;
+    return languageEndonym;
 }
 #endif
 
@@ -4488,6 +6787,99 @@ Qt::LayoutDirection MLocale::defaultLayoutDirection()
     return _defaultLayoutDirection;
 }
 
+MLocale::CacheStatistics MLocale::cacheStatistics(FormatterCache cache) const
+{
+    CacheStatistics statistics;
+    memset(&statistics, 0, sizeof(statistics));
+#ifdef HAVE_ICU
+    const MLocalePrivate *d = d_ptr;
+    // the threads of the privates may move them to other stores and
+    // release the old ones meanwhile. They replace _formatters only
+    // under the mutex of the store registry, and a store is not
+    // deleted while it is held:
+    MFormatterStoreRegistry *registry = formatterStoreRegistry();
+    QMutexLocker storesLocker(registry ? &registry->mutex : 0);
+    const MFormatterCacheCounters *counters = d->formatterCache(cache);
+    if (counters)
+        counters->addTo(&statistics);
+    QReadLocker locker(&d->_threadPrivatesLock);
+    foreach (const MLocalePrivate *threadPrivate, d->_threadPrivates) { // krazy:exclude=foreach
+        counters = threadPrivate->formatterCache(cache);
+        if (counters)
+            counters->addTo(&statistics);
+    }
+#else
+    Q_UNUSED(cache);
+#endif
+    return statistics;
+}
+
+MLocale::CacheStatistics MLocale::totalCacheStatistics(FormatterCache cache)
+{
+    MFormatterCacheRegistry *registry = formatterCacheRegistry();
+    if (!registry) {
+        CacheStatistics statistics;
+        memset(&statistics, 0, sizeof(statistics));
+        return statistics;
+    }
+    return registry->total(cache);
+}
+
+void MLocale::setCacheCapacity(FormatterCache cache, int bytes)
+{
+    MFormatterCacheRegistry *registry = formatterCacheRegistry();
+    if (registry)
+        registry->capacities[cache].storeRelease(qMax(0, bytes));
+}
+
+int MLocale::cacheCapacity(FormatterCache cache)
+{
+    return MFormatterCacheCounters::capacity(cache);
+}
+
+#ifdef HAVE_ICU
+namespace
+{
+    // runs MLocalePrivate::prepareFormatters() for a copy of a
+    // private, which keeps the store it publishes to alive
+    class MPrepareFormattersTask : public QRunnable
+    {
+    public:
+        MPrepareFormattersTask(MLocalePrivate *d, MLocale::PrepareFlags flags)
+            : _d(d), _flags(flags)
+        {
+        }
+
+        virtual ~MPrepareFormattersTask()
+        {
+            delete _d;
+        }
+
+        virtual void run()
+        {
+            _d->prepareFormatters(_flags);
+        }
+
+    private:
+        MLocalePrivate *_d;
+        MLocale::PrepareFlags _flags;
+    };
+}
+#endif
+
+void MLocale::prepare(PrepareFlags flags) const
+{
+#ifdef HAVE_ICU
+    Q_D(const MLocale);
+    // the copy is made here, i.e. it shares the store of this thread
+    // and the locale may change or go away meanwhile:
+    MLocalePrivate *copy = new MLocalePrivate(*d);
+    QThreadPool::globalInstance()->start(new MPrepareFormattersTask(copy, flags));
+#else
+    Q_UNUSED(flags);
+#endif
+}
+
 Qt::LayoutDirection MLocale::textDirection() const
 {
 #ifdef HAVE_ICU
@@ -4561,6 +6953,7 @@ void MLocale::refreshSettings()
     if (localeName != d->_defaultLocale) {
         settingsHaveReallyChanged = true;
         d->_defaultLocale = localeName;
+        d->updateLocaleIdentifiers();
         // force recreation of the number formatter if
         // the numeric locale inherits from the default locale:
         if(d->_numericLocale.isEmpty())
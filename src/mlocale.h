@@ -26,6 +26,7 @@
 #include <QtGlobal>
 #include <QObject>
 #include <QMap>
+#include <QVector>
 
 class QString;
 #if QT_VERSION < 0x051500
@@ -37,6 +38,7 @@ class QTranslator;
 namespace ML10N {
 
 class MCollator;
+class MDateTimeParser;
 class MAbstractName;
 class MCalendar;
 class MBreakIteratorPrivate;
@@ -92,7 +94,11 @@ struct MStaticLocaleDestroyer;
  * connect to the settingsChanged() signal by using the
  * connectSettings() method.
  *
- * \note The methods are not thread-safe. For number/string formatting etc. the class is re-entrant. If one needs to have formatting in multiple threads it is suggested to create separate locales.
+ * \note The methods which change the locale are not thread-safe. The
+ * const methods, i.e. all formatting and parsing, can be called for
+ * the same MLocale from several threads at the same time as long as
+ * the MLocale itself is not changed meanwhile. Every thread gets its
+ * own caches and ICU formatters the first time it uses the MLocale.
  */
 
 class MLOCALE_EXPORT MLocale : public QObject
@@ -305,6 +311,76 @@ public:
       NorthAmericanPhoneNumberGrouping
     };
 
+    /*!
+     * \brief The caches of ICU formatters kept by every MLocale
+     *
+     * DateFormatCache holds the formatters of formatDateTime() with
+     * date and time types, SimpleDateFormatCache those of
+     * formatDateTimeICU(), PosixFormatCache the compiled format
+     * strings of formatDateTime() with POSIX format strings,
+     * PrecisionNumberFormatCache, PercentNumberFormatCache and
+     * CurrencyNumberFormatCache the number formatters of
+     * formatNumber() with precision, formatPercent() and
+     * formatCurrency(), IncrementalDateFormatCache the formatters
+     * which remember formatted parts of consecutive time stamps,
+     * PatternCache the patterns of icuFormatString() and
+     * icuFormatStringForSkeleton(), and PatternGeneratorCache the ICU
+     * pattern generators which find the patterns for skeletons.
+     *
+     * \sa cacheStatistics(), setCacheCapacity()
+     */
+    enum FormatterCache {
+        DateFormatCache,
+        SimpleDateFormatCache,
+        PosixFormatCache,
+        PrecisionNumberFormatCache,
+        PercentNumberFormatCache,
+        CurrencyNumberFormatCache,
+        IncrementalDateFormatCache,
+        PatternCache,
+        PatternGeneratorCache
+    };
+
+    /*!
+     * \brief Usage of a formatter cache
+     *
+     * \c hits and \c misses count the lookups, \c evictions the
+     * entries dropped to stay within the capacity. \c entries and
+     * \c bytes describe the current content, the sizes of the ICU
+     * objects are estimates.
+     *
+     * \sa cacheStatistics(), totalCacheStatistics()
+     */
+    struct CacheStatistics {
+        qint64 hits;
+        qint64 misses;
+        qint64 evictions;
+        qint64 entries;
+        qint64 bytes;
+    };
+
+    /*!
+     * \brief What prepare() creates in advance
+     *
+     * PrepareDateFormats creates the formatters of formatDateTime()
+     * for every combination of DateNone to DateFull with TimeNone to
+     * TimeFull in the default calendar and in the calendar of the
+     * locale, PrepareNumberFormats
+     * those of formatNumber() with a precision of 0 to 2 and of
+     * formatPercent() with 0 to 2 decimals, PrepareCollator the
+     * collator which collator() copies and PrepareIndexBuckets the
+     * list of exemplarCharactersIndex() which indexBucket() and
+     * MLocaleBuckets use.
+     */
+    enum PrepareFlag {
+        PrepareDateFormats = 0x1,
+        PrepareNumberFormats = 0x2,
+        PrepareCollator = 0x4,
+        PrepareIndexBuckets = 0x8,
+        PrepareAll = 0xf
+    };
+    Q_DECLARE_FLAGS(PrepareFlags, PrepareFlag)
+
 
     static MLocale *createSystemMLocale();
 
@@ -1358,6 +1434,120 @@ public:
      */
     float toFloat(const QString &s, bool *ok = 0) const;
 
+    /*!
+     * \brief Parses many localized integers at once
+     * \param strings localized strings to parse
+     * \param numbers receives strings.size() numbers
+     * \param ok if not NULL, receives strings.size() flags indicating success
+     * \return the number of strings which could be parsed
+     *
+     * Every string is parsed exactly as toLongLong() would parse it,
+     * strings which cannot be parsed give 0. The parser state is set
+     * up once for the whole batch, this is much cheaper than calling
+     * toLongLong() for every column of a big CSV import.
+     *
+     * Parsing does not modify the MLocale, toLongLong(), toShort(),
+     * toInt(), toDouble(), toFloat() and parseNumbers() can be called
+     * for the same MLocale from several threads at the same time as
+     * long as the MLocale itself is not changed meanwhile.
+     *
+     * Example:
+     *
+     * \code
+     * MLocale locale("de_CH");
+     * QVector<qlonglong> numbers;
+     * QVector<bool> ok;
+     * locale.parseNumbers(QStringList() << "1'234" << "x", &numbers, &ok);
+     * // now numbers contains 1234, 0 and ok contains true, false
+     * \endcode
+     *
+     * \sa toLongLong(const QString &s, bool *ok) const
+     */
+    int parseNumbers(const QStringList &strings, QVector<qlonglong> *numbers,
+                     QVector<bool> *ok = 0) const;
+
+    /*!
+     * \brief Parses many localized floating point numbers at once
+     * \param strings localized strings to parse
+     * \param numbers receives strings.size() numbers
+     * \param ok if not NULL, receives strings.size() flags indicating success
+     * \return the number of strings which could be parsed
+     *
+     * Same as parseNumbers(const QStringList &strings, QVector<qlonglong> *numbers, QVector<bool> *ok) const
+     * but parses like toDouble().
+     *
+     * \sa toDouble(const QString &s, bool *ok) const
+     */
+    int parseNumbers(const QStringList &strings, QVector<double> *numbers,
+                     QVector<bool> *ok = 0) const;
+
+    /*!
+     * \brief Returns the string representations of many numbers packed into one string
+     * \param numbers numbers to format
+     * \param offsets if not NULL, receives numbers.size() + 1 offsets into the result
+     * \param threads maximum number of threads to use
+     *
+     * Every number is formatted exactly as formatNumber(qlonglong i)
+     * would format it and appended to the returned string. The
+     * formatted number \c numbers[i] is
+     * \c result.mid(offsets[i], offsets[i+1] - offsets[i]).
+     *
+     * This is much cheaper than calling formatNumber() for every
+     * number when formatting big tables or many axis labels because
+     * no QString is created per number.
+     *
+     * If \a threads is larger than 1, big batches are split between
+     * up to \a threads threads of the global QThreadPool, each of
+     * them uses its own copy of the number formatter.
+     *
+     * Example:
+     *
+     * \code
+     * MLocale locale("de_CH");
+     * QVector<qlonglong> numbers;
+     * numbers << 1234 << -5678;
+     * QVector<int> offsets;
+     * QString formatted = locale.formatNumbers(numbers, &offsets);
+     * // now formatted contains “1'234-5'678”
+     * // and offsets contains 0, 5, 11
+     * \endcode
+     *
+     * \sa formatNumber(qlonglong i) const
+     */
+    QString formatNumbers(const QVector<qlonglong> &numbers, QVector<int> *offsets,
+                          int threads = 1) const;
+
+    /*!
+     * \brief Returns the string representations of many numbers packed into one string
+     * \param numbers numbers to format
+     * \param offsets if not NULL, receives numbers.size() + 1 offsets into the result
+     * \param threads maximum number of threads to use
+     *
+     * Same as formatNumbers(const QVector<qlonglong> &numbers, QVector<int> *offsets, int threads) const
+     * but formats like formatNumber(int i).
+     *
+     * \sa formatNumber(int i) const
+     */
+    QString formatNumbers(const QVector<int> &numbers, QVector<int> *offsets,
+                          int threads = 1) const;
+
+    /*!
+     * \brief Returns the string representations of many numbers packed into one string
+     * \param numbers numbers to format
+     * \param offsets if not NULL, receives numbers.size() + 1 offsets into the result
+     * \param maxPrecision maximum number of fractional digits
+     * \param minPrecision minimum number of fractional digits
+     * \param threads maximum number of threads to use
+     *
+     * Same as formatNumbers(const QVector<qlonglong> &numbers, QVector<int> *offsets, int threads) const
+     * but formats like formatNumber(double i, int maxPrecision, int minPrecision).
+     *
+     * \sa formatNumber(double i, int maxPrecision, int minPrecision) const
+     */
+    QString formatNumbers(const QVector<double> &numbers, QVector<int> *offsets,
+                          int maxPrecision = -1, int minPrecision = 0,
+                          int threads = 1) const;
+
     /*!
      * \brief Returns the string representation of a number as percentage
      * \param i number to format
@@ -1420,6 +1610,61 @@ public:
                            TimeType timeType = TimeLong,
                            CalendarType calendarType = DefaultCalendar) const;
 
+    /*!
+     * \brief Creates a string presentation for a point in time given in milliseconds since the epoch
+     * \param msecsSinceEpoch milliseconds since 1970-01-01T00:00:00.000 UTC
+     * \param dateType style of date formatting
+     * \param timeType style of time formatting
+     * \param calendarType calendar type to use for formatting
+     *
+     * The time is shown in the system time zone, see
+     * MCalendar::systemTimeZone(). If dateType is MLocale::DateNone
+     * <b>and</b> timeType is MLocale::TimeNone, an empty string is
+     * returned.
+     *
+     * This is meant for formatting many time stamps, for example one
+     * for every row of a list. Like
+     * formatDateTime(const QDateTime &dateTime, DateType dateType = DateLong, TimeType timeType = TimeLong, CalendarType calendarType = DefaultCalendar) const
+     * it reuses a calendar kept by the MLocale but it does not need
+     * any time zone conversions of a QDateTime.
+     *
+     * \sa formatDateTime(const QDateTime &dateTime, DateType dateType = DateLong, TimeType timeType = TimeLong, CalendarType calendarType = DefaultCalendar) const
+     */
+    QString formatDateTime(qint64 msecsSinceEpoch, DateType dateType = DateLong,
+                           TimeType timeType = TimeLong,
+                           CalendarType calendarType = DefaultCalendar) const;
+
+    /*!
+     * \brief Returns the string representations of many points in time packed into one string
+     * \param msecsSinceEpoch milliseconds since 1970-01-01T00:00:00.000 UTC
+     * \param offsets if not NULL, receives msecsSinceEpoch.size() + 1 offsets into the result
+     * \param dateType style of date formatting
+     * \param timeType style of time formatting
+     * \param calendarType calendar type to use for formatting
+     * \param threads maximum number of threads to use
+     *
+     * Every time is formatted exactly as
+     * formatDateTime(qint64 msecsSinceEpoch, DateType dateType, TimeType timeType, CalendarType calendarType) const
+     * would format it and appended to the returned string. The
+     * formatted time \c msecsSinceEpoch[i] is
+     * \c result.mid(offsets[i], offsets[i+1] - offsets[i]).
+     *
+     * The date format is looked up only once for the whole batch
+     * and a single calendar is reused for all times, neither a
+     * QDateTime, an MCalendar nor a QString is created per time.
+     *
+     * If \a threads is larger than 1, big batches are split between
+     * up to \a threads threads of the global QThreadPool, each of
+     * them uses its own copy of the date format and the calendar.
+     *
+     * \sa formatDateTime(qint64 msecsSinceEpoch, DateType dateType, TimeType timeType, CalendarType calendarType) const
+     * \sa formatNumbers(const QVector<qlonglong> &numbers, QVector<int> *offsets, int threads) const
+     */
+    QString formatDateTimes(const QVector<qint64> &msecsSinceEpoch, QVector<int> *offsets,
+                            DateType dateType = DateLong, TimeType timeType = TimeLong,
+                            CalendarType calendarType = DefaultCalendar,
+                            int threads = 1) const;
+
     /*!
      * \brief String presentation with explicit calendar type
      * \param dateTime time to format
@@ -1608,6 +1853,53 @@ public:
                               TimeType timeType = TimeLong,
                               CalendarType calendarType = DefaultCalendar) const;
 
+    /*!
+     * \brief returns the ICU date and time format string of the current
+     * locale which best fits a skeleton
+     * \param skeleton the fields to show, e.g. “yMMMd” or “EEEEjm”
+     * \param calendarType calendar to use for formatting
+     *
+     * A skeleton lists the ICU date field symbols wanted in any
+     * order and without separators, the locale decides about order,
+     * separators and literal text. E.g. the skeleton “MMMd” gives
+     * “d MMM” for fi_FI and “MMM d” for en_US. “j” stands for the
+     * hour of the clock which timeFormat24h() selects, the other hour
+     * symbols are changed to this clock as well.
+     *
+     * The patterns are looked up once per locale, skeleton and
+     * calendar type and kept in a cache which does not hold any
+     * formatters.
+     *
+     * \sa formatDateTimeWithSkeleton(const MCalendar &mCalendar, const QString &skeleton) const
+     */
+    QString icuFormatStringForSkeleton(const QString &skeleton,
+                                       CalendarType calendarType = DefaultCalendar) const;
+
+    /*!
+     * \brief formats a date and time with the pattern which best fits a skeleton
+     * \param mCalendar the calendar set to the date and time to format
+     * \param skeleton the fields to show, e.g. “yMMMd” or “EEEEjm”
+     *
+     * This is the same as
+     * formatDateTimeICU(mCalendar, icuFormatStringForSkeleton(skeleton, mCalendar.type())).
+     *
+     * \sa icuFormatStringForSkeleton()
+     */
+    QString formatDateTimeWithSkeleton(const MCalendar &mCalendar,
+                                       const QString &skeleton) const;
+
+    /*!
+     * \brief formats a QDateTime with the pattern which best fits a skeleton
+     * \param dateTime the date and time to format
+     * \param skeleton the fields to show, e.g. “yMMMd” or “EEEEjm”
+     * \param calendarType calendar to use for formatting
+     *
+     * \sa icuFormatStringForSkeleton()
+     */
+    QString formatDateTimeWithSkeleton(const QDateTime &dateTime,
+                                       const QString &skeleton,
+                                       CalendarType calendarType = DefaultCalendar) const;
+
     /*!
      * \brief Creates a datetime object from a string with explicit format lengths.
      * \param dateTime string to parse
@@ -1629,6 +1921,17 @@ public:
      */
     QDateTime parseDateTime(const QString &dateTime, CalendarType calendarType) const;
 
+    /*!
+     * \brief Returns a MDateTimeParser for parsing many strings with this locale
+     * \param calendarType calendar to parse into
+     *
+     * The returned parser has no styles yet, add them with
+     * MDateTimeParser::addStyle(). Prefer it over parseDateTime() when
+     * many strings have to be parsed or when the style of the strings
+     * is not known in advance.
+     */
+    MDateTimeParser dateTimeParser(CalendarType calendarType = DefaultCalendar) const;
+
     /*!
      * \brief Returns the locale dependent name for a month number
      *
@@ -1668,6 +1971,35 @@ public:
     QString weekdayName(const MCalendar &mCalendar, int weekday,
                         DateSymbolContext context, DateSymbolLength symbolLength) const;
 
+    /*!
+     * \brief Returns the names of all months of the calendar choosing context and length
+     *
+     * The name of month number \c n is at index \c n-1, i.e. this
+     * returns the same names as calling monthName() for every month
+     * but is much cheaper if many names are needed, for example for
+     * drawing a month view. The list is computed once and then
+     * cached until the locale changes. For calendars with a leap
+     * month, like the Hebrew calendar, the list has 13 entries.
+     *
+     * \sa QString monthName(const MCalendar &mCalendar, int monthNumber, DateSymbolContext context, DateSymbolLength symbolLength) const
+     */
+    QStringList monthNames(const MCalendar &mCalendar,
+                           DateSymbolContext context = DateSymbolStandalone,
+                           DateSymbolLength symbolLength = DateSymbolWide) const;
+
+    /*!
+     * \brief Returns the names of all weekdays choosing context and length
+     *
+     * The list starts with Monday, i.e. the name of the MLocale::Weekday
+     * \c w is at index \c w-1. Like monthNames() the list is
+     * cached until the locale changes.
+     *
+     * \sa weekdayName(const MCalendar &mCalendar, int weekday, DateSymbolContext context, DateSymbolLength symbolLength) const
+     */
+    QStringList weekdayNames(const MCalendar &mCalendar,
+                             DateSymbolContext context = DateSymbolStandalone,
+                             DateSymbolLength symbolLength = DateSymbolWide) const;
+
     // TODO: add versions for QDate and QTime?
 
     ////////////////////////////////
@@ -1871,6 +2203,19 @@ public:
      */
     QString toLocalizedNumbers(const QString &text) const;
 
+    /*!
+     * \brief converts all digits in \a text to localized digits in place
+     * \param text a string which may contain various localized digits
+     *
+     * Same as toLocalizedNumbers(const QString &text) but modifies
+     * \a text instead of returning a copy. \a text is only detached
+     * if it actually contains digits which have to be converted,
+     * this is meant for converting big texts or many lines of text.
+     *
+     * \sa toLocalizedNumbers(const QString &text)
+     */
+    void toLocalizedNumbers(QString *text) const;
+
     /*!
      * \brief converts all localized digits in the input to the given localized digits
      * \param text a string which may contain various localized digits
@@ -1896,6 +2241,18 @@ public:
      */
     static QString toLocalizedNumbers(const QString &text, const QString &targetDigits);
 
+    /*!
+     * \brief converts all localized digits in \a text to the given localized digits in place
+     * \param text a string which may contain various localized digits
+     * \param targetDigits a string of length 10 containing the target digits
+     *
+     * Same as toLocalizedNumbers(const QString &text, const QString &targetDigits)
+     * but modifies \a text instead of returning a copy.
+     *
+     * \sa toLocalizedNumbers(const QString &text, const QString &targetDigits)
+     */
+    static void toLocalizedNumbers(QString *text, const QString &targetDigits);
+
     /*!
      * \brief converts all localized digits in the input to Latin digits
      * \param text a string which may contain various localized digits
@@ -1920,6 +2277,19 @@ public:
      */
     static QString toLatinNumbers(const QString &text);
 
+    /*!
+     * \brief converts all localized digits in \a text to Latin digits in place
+     * \param text a string which may contain various localized digits
+     *
+     * Same as toLatinNumbers(const QString &text) but modifies
+     * \a text instead of returning a copy. Runs of plain ASCII are
+     * skipped quickly, i.e. converting log files or chat messages
+     * which are mostly ASCII is cheap.
+     *
+     * \sa toLatinNumbers(const QString &text)
+     */
+    static void toLatinNumbers(QString *text);
+
     /*!
      * \brief Sets the DataPaths for the (ICU) locale system to the given paths.
      *
@@ -1966,6 +2336,10 @@ public:
      *
      * etc.
      *
+     * The formatters, collators and other data cached by existing
+     * MLocale objects are created again from the new data when they
+     * are used next.
+     *
      * \sa void setDataPath(const QString &dataPath)
      * \sa dataPaths()
      */
@@ -2113,6 +2487,73 @@ public:
      */
     static Qt::LayoutDirection defaultLayoutDirection();
 
+    /*!
+     * \brief Returns the usage of one of the formatter caches of this locale
+     *
+     * The caches of the copies used by other threads, see the
+     * note about threads above, are included. MLocale instances of
+     * the same thread whose categories and time format are the same
+     * share their caches, i.e. the lookups made through each of
+     * them are counted.
+     *
+     * \sa totalCacheStatistics()
+     */
+    CacheStatistics cacheStatistics(FormatterCache cache) const;
+
+    /*!
+     * \brief Returns the usage of one of the formatter caches summed
+     * over all MLocale instances of the process
+     *
+     * The lookups of caches which have been destroyed already are
+     * included. If the environment variable
+     * \c MLOCALE_CACHE_STATISTICS is set to a value other than 0, the
+     * totals of all caches are printed when the process exits.
+     */
+    static CacheStatistics totalCacheStatistics(FormatterCache cache);
+
+    /*!
+     * \brief Sets the capacity of the formatter cache \a cache in bytes
+     *
+     * The capacity applies to every cache separately, i.e. to the
+     * caches shared by the MLocale instances of one configuration
+     * and thread. A cache which is already fuller than the new
+     * capacity shrinks at its next insertion. Entries are weighed
+     * with the approximate size of their ICU objects, e.g. about 54
+     * KiB for a date formatter and 8 KiB for a number formatter.
+     *
+     * \sa cacheCapacity(), cacheStatistics()
+     */
+    static void setCacheCapacity(FormatterCache cache, int bytes);
+
+    //! Returns the capacity of the formatter cache \a cache in bytes
+    static int cacheCapacity(FormatterCache cache);
+
+    /*!
+     * \brief Creates commonly used formatters in a background thread
+     *
+     * After a change of the locale the first calls of
+     * formatDateTime(), formatNumber(), collator() etc. create their
+     * ICU objects, which may take several milliseconds each. This
+     * function creates the objects selected by \a flags for the
+     * current settings in a thread of the global QThreadPool and
+     * returns at once. The calling thread takes them over at its
+     * next call which needs one of them, objects it has created
+     * itself meanwhile are kept. Prepared objects never evict cached
+     * ones, those which don't fit into the free capacity of their
+     * cache (see setCacheCapacity()) are dropped.
+     *
+     * The objects are only used by this and equal MLocale instances
+     * in the calling thread, and only as long as the settings stay
+     * the same. A good place to call it is a slot connected to
+     * settingsChanged().
+     *
+     * \code
+     * MLocale &locale = MLocale::getDefault();
+     * locale.prepare(MLocale::PrepareDateFormats | MLocale::PrepareCollator);
+     * \endcode
+     */
+    void prepare(PrepareFlags flags = PrepareAll) const;
+
 Q_SIGNALS:
     void settingsChanged();
     /*!
@@ -2136,10 +2577,16 @@ private:
     static MLocale *s_systemDefault;
     // private info is kept away from the public header
     MLocalePrivate *const d_ptr;
-    Q_DECLARE_PRIVATE(MLocale)
+    // like Q_DECLARE_PRIVATE(MLocale) but the const d_func() returns
+    // the private of the calling thread, see
+    // MLocalePrivate::forCurrentThread()
+    inline MLocalePrivate *d_func() { return d_ptr; }
+    const MLocalePrivate *d_func() const;
+    friend class MLocalePrivate;
 
     friend class MCalendar;
     friend class MCollator;
+    friend class MDateTimeParser;
     friend struct MStaticLocaleDestroyer;
     friend class MIcuBreakIteratorPrivate;
 
@@ -2147,6 +2594,8 @@ private Q_SLOTS:
     void refreshSettings();
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(MLocale::PrepareFlags)
+
 }
 
 #endif
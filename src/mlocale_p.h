@@ -27,6 +27,13 @@
 #include <QExplicitlySharedDataPointer>
 #include <QLocale>
 #include <QCache>
+#include <QHash>
+#include <QAtomicPointer>
+#include <QAtomicInteger>
+#include <QReadWriteLock>
+#include <QMutex>
+#include <QVector>
+#include <QPair>
 
 #ifdef HAVE_ICU
 #include <unicode/datefmt.h>
@@ -34,9 +41,12 @@
 #include <unicode/decimfmt.h>
 #include <unicode/unistr.h>
 #include <unicode/dtfmtsym.h>
+#include <unicode/coll.h>
+#include <unicode/dtptngen.h>
 #endif
 
 #include "mlocale.h"
+#include "mlocaleidentifier.h"
 
 class QString;
 
@@ -45,6 +55,154 @@ namespace ML10N {
 class MTranslationCatalog;
 class MLocaleAbstractConfigItem;
 
+#ifdef HAVE_ICU
+// Formats like the date format it is created from but splits the
+// pattern into its run of date fields and its run of time fields,
+// caches the formatted date part per local day and the time part per
+// minute (per second if the pattern shows seconds) and splices them.
+// Patterns which interleave date and time fields or show fractions
+// of a second are formatted in full every time.
+class MIncrementalDateFormat
+{
+public:
+    explicit MIncrementalDateFormat(const icu::DateFormat &df);
+    ~MIncrementalDateFormat();
+
+    // true if the pattern could be split, i.e. if the caches are used
+    bool isIncremental() const;
+
+    // the approximate size in bytes once the part caches are full
+    int approximateSize() const;
+
+    // sets cal, which has to have the calendar type of the date
+    // format, to date if needed and appends the formatted date to
+    // *result
+    void append(icu::Calendar *cal, UDate date, QString *result);
+
+private:
+    Q_DISABLE_COPY(MIncrementalDateFormat)
+
+    QString *formatPart(const icu::DateFormat *df, icu::Calendar *cal, UDate date,
+                        bool *calendarSet);
+
+    enum { MaxDateParts = 64, MaxTimeParts = 1440 };
+
+    // the full pattern, used if the pattern cannot be split
+    icu::DateFormat *_df;
+    // the two halves of the pattern, 0 if there are no fields of
+    // the kind, literals in between belong to the first half
+    icu::DateFormat *_dateFormat;
+    icu::DateFormat *_timeFormat;
+    bool _incremental;
+    bool _timeFirst;
+    // time zone names depend on the instant, not only on the time of
+    // day, so they are cached per UTC minute or second
+    bool _timePartsPerInstant;
+    qint64 _timeResolution;
+    // keyed by local day and by local (or UTC) minute or second
+    QCache<qint64, QString> _dateParts;
+    QCache<qint64, QString> _timeParts;
+    icu::UnicodeString _buffer;
+};
+#endif
+
+// The counters of one formatter cache which
+// MLocale::cacheStatistics() and MLocale::totalCacheStatistics() add
+// up. Only the thread which owns the cache updates them, they are
+// atomic so that other threads may read them at any time.
+class MFormatterCacheCounters
+{
+public:
+    MLocale::FormatterCache type() const;
+    // adds the counters to *statistics
+    void addTo(MLocale::CacheStatistics *statistics) const;
+
+    // the capacity in bytes set by MLocale::setCacheCapacity()
+    static int capacity(MLocale::FormatterCache type);
+
+protected:
+    // registers the cache for MLocale::totalCacheStatistics()
+    explicit MFormatterCacheCounters(MLocale::FormatterCache type);
+    ~MFormatterCacheCounters();
+
+    void countLookup(bool hit);
+    void countChange(int entries, int bytes, int evictions);
+
+private:
+    Q_DISABLE_COPY(MFormatterCacheCounters)
+
+    MLocale::FormatterCache _type;
+    QAtomicInteger<qint64> _hits;
+    QAtomicInteger<qint64> _misses;
+    QAtomicInteger<qint64> _evictions;
+    QAtomicInt _entries;
+    QAtomicInt _bytes;
+};
+
+// A QCache which counts its hits, misses and evictions and whose
+// capacity is MFormatterCacheCounters::capacity() in bytes, the cost
+// of an entry is the approximate size of the object in bytes.
+template <class Key, class T>
+class MFormatterCache : public MFormatterCacheCounters
+{
+public:
+    explicit MFormatterCache(MLocale::FormatterCache type)
+        : MFormatterCacheCounters(type),
+          _cache(capacity(type))
+    {
+    }
+
+    ~MFormatterCache()
+    {
+        clear();
+    }
+
+    T *object(const Key &key)
+    {
+        T *object = _cache.object(key);
+        countLookup(object != 0);
+        return object;
+    }
+
+    // unlike object() neither counted nor moving the entry to the
+    // front of the eviction order
+    bool contains(const Key &key) const
+    {
+        return _cache.contains(key);
+    }
+
+    // the bytes which can be inserted without evicting anything
+    int freeCapacity() const
+    {
+        return qMax(0, capacity(type()) - int(_cache.totalCost()));
+    }
+
+    // Inserts object, which the cache owns from now on. An object
+    // larger than the whole capacity is kept nevertheless until the
+    // next insertion because the callers go on using it.
+    void insert(const Key &key, T *object, int bytes)
+    {
+        const int oldCount = int(_cache.size());
+        const bool replaces = _cache.contains(key);
+        const int maxCost = capacity(type());
+        if (int(_cache.maxCost()) != maxCost)
+            _cache.setMaxCost(maxCost);
+        _cache.insert(key, object, qMin(bytes, maxCost));
+        const int count = int(_cache.size());
+        countChange(count, int(_cache.totalCost()),
+                    oldCount + (replaces ? 0 : 1) - count);
+    }
+
+    void clear()
+    {
+        _cache.clear();
+        countChange(0, 0, 0);
+    }
+
+private:
+    QCache<Key, T> _cache;
+};
+
 class MLocalePrivate
 {
     Q_DECLARE_PUBLIC(MLocale)
@@ -111,10 +269,64 @@ public:
      */
     static bool truncateLocaleName(QString *localeName);
 
+    typedef QString (*ResourceLookup)(const char *bundleName,
+                                      const QString &localeName,
+                                      const QString &keyPath);
+
+    /*!
+     * \brief returns the string at \a keyPath in a resource bundle
+     *
+     * \a keyPath lists the keys separated by “/”, e.g.
+     * “NumberElements/latn/symbols/decimal”. The resource bundles
+     * for \a localeName and its fallbacks (see truncateLocaleName())
+     * are tried in turn, a null string is returned if nothing is
+     * found.
+     */
+    static QString lookupResourceString(const char *bundleName,
+                                        const QString &localeName,
+                                        const QString &keyPath);
+
+    /*!
+     * \brief returns lookup(bundleName, localeName, keyPath), memoized
+     *
+     * The result of every lookup is kept in a process wide cache,
+     * i.e. the resource bundles are walked only once for each
+     * combination of bundle, locale name and key path. Several
+     * threads can read from the cache at the same time.
+     */
+    static QString cachedResourceString(const char *bundleName,
+                                        const QString &localeName,
+                                        const QString &keyPath,
+                                        ResourceLookup lookup = lookupResourceString);
+
+    // drops the cached resource strings, e.g. when the ICU data
+    // path changes
+    static void clearResourceCache();
+
+    // the uncached lookups behind MLocale::languageEndonym() and
+    // MLocale::localeScript()
+    static QString lookupLanguageEndonym(const char *bundleName,
+                                         const QString &locale,
+                                         const QString &keyPath);
+    static QString lookupLocaleScript(const QString &locale);
+
     // creates an icu::Locale for specific category
     icu::Locale getCategoryLocale(MLocale::Category category) const;
 
     static icu::DateFormatSymbols *createDateFormatSymbols(const icu::Locale &locale);
+    // returns the date format symbols of the locale \a localeName
+    // from a process wide cache, 0 if they could not be created. The
+    // symbols must not be modified, copy them to adopt them.
+    static const icu::DateFormatSymbols *cachedDateFormatSymbols(const QString &localeName);
+
+    enum DateSymbolKind { MonthSymbols, WeekdaySymbols };
+    // returns all month names or all weekday names (starting with
+    // Monday) for the calendar type, capitalized if the context is
+    // MLocale::DateSymbolStandalone, see MLocale::monthNames()
+    QStringList dateSymbolNames(DateSymbolKind kind,
+                                MLocale::CalendarType calendarType,
+                                MLocale::DateSymbolContext context,
+                                MLocale::DateSymbolLength symbolLength) const;
 
     // checks if an ICU format string is a twelve hour format string or not
     bool isTwelveHours(const QString &icuFormatQString) const;
@@ -137,11 +349,16 @@ public:
     // mixing in the month names and weekday names from a different
     // language less bad
     void simplifyDateFormatForMixing(icu::DateFormat *df) const;
-    // wrap an ICU date format in LRE...PDF or RLE...PDF
-    // according to to the direction given as a parameter
-    void maybeEmbedDateFormat(icu::DateFormat *df, const QString &categoryNameMessages, const QString &categoryNameTime) const;
-
-    bool mixingSymbolsWanted(const QString &categoryNameMessages, const QString &categoryNameTime) const;
+    // wrap an ICU date format in LRE...PDF or RLE...PDF if the
+    // script directions of the time and the messages locale differ
+    void maybeEmbedDateFormat(icu::DateFormat *df) const;
+
+    // decides whether symbols of the messages locale are mixed into
+    // date formats of the time locale, the result is kept in
+    // _profile.mixingSymbolsWanted
+    static bool mixingSymbolsWanted(const QString &categoryNameMessages,
+                                    const QString &categoryNameTime,
+                                    bool messagesIsRtl, bool timeIsRtl);
     /*!
      * \brief returns ICU date and time format string of the current locale
      * \param dateType style of date formatting
@@ -153,16 +370,63 @@ public:
                             MLocale::TimeType timeType,
                             MLocale::CalendarType calendarType,
                             MLocale::TimeFormat24h timeFormat24h) const;
-
-    // creates a dateformat object for datetime formatting/parsing
-    // the caller is responsible for deleting the dateformat object
+    // returns the pattern which best fits skeleton, see
+    // MLocale::icuFormatStringForSkeleton()
+    QString skeletonFormatString(const QString &skeleton,
+                                 MLocale::CalendarType calendarType) const;
+    // returns the cached pattern generator of the time category for
+    // the calendar type, 0 if it could not be created
+    icu::DateTimePatternGenerator *patternGenerator(MLocale::CalendarType calendarType) const;
+
+    // returns the cached dateformat object for datetime
+    // formatting/parsing, creates it on a cache miss
     icu::DateFormat *createDateFormat(MLocale::DateType dateType,
                                       MLocale::TimeType timeType,
                                       MLocale::CalendarType calendarType,
                                       MLocale::TimeFormat24h timeFormat24h) const;
+    // creates a new dateformat object without looking at the cache,
+    // the caller is responsible for deleting it
+    icu::DateFormat *newDateFormat(MLocale::DateType dateType,
+                                   MLocale::TimeType timeType,
+                                   MLocale::CalendarType calendarType,
+                                   MLocale::TimeFormat24h timeFormat24h) const;
 #endif
     QString fixCategoryNameForNumbers(const QString &categoryName) const;
     QString numberingSystem(const QString &localeName) const;
+    // returns the 10 digits of a numbering system like “arab”, an
+    // empty string if the numbering system has no decimal digits
+    static QString digitsOfNumberingSystem(const QString &numberingSystem);
+    // returns the digits used by the numeric locale, these are
+    // looked up only once per locale name and process
+    QString localizedDigits() const;
+    // drops the digits looked up by localizedDigits(), e.g. when
+    // the ICU data path changes
+    static void clearLocalizedDigits();
+
+    /*!
+     * \brief returns the interned identifier for \a localeName
+     *
+     * The identifier for a locale name is parsed only once per
+     * process and never freed, i.e. the returned pointer stays
+     * valid and is the same for equal locale names.
+     */
+    static const MLocaleIdentifier *internLocaleIdentifier(const QString &localeName);
+
+    // returns the parsed identifier of categoryName(category)
+    const MLocaleIdentifier *categoryIdentifier(MLocale::Category category) const;
+
+    // returns fixCategoryNameForNumbers(categoryName(category))
+    const QString &categoryNameForNumbers(MLocale::Category category) const;
+
+    // returns fixCategoryNameForNumbers(
+    //     MIcuConversions::setCalendarOption(categoryName(category), calendarType))
+    QString categoryNameForCalendar(MLocale::Category category,
+                                    MLocale::CalendarType calendarType) const;
+
+    // updates the identifiers and the profile derived from the
+    // category names, has to be called whenever one of the locale
+    // names below changes
+    void updateLocaleIdentifiers();
 
     static bool parseIcuLocaleString(const QString &localeString, QString *language, QString *script, QString *country, QString *variant);
     // these return the requested part of a locale string,
@@ -181,6 +445,27 @@ public:
 
     void dropCaches();
 
+    /*!
+     * \brief returns the private to use in the calling thread
+     *
+     * That is this private in the thread which created it and a
+     * copy with its own caches and ICU formatters in every other
+     * thread. The copies are created on first use and deleted by
+     * dropThreadPrivates(), which every method changing the locale
+     * has to call, with this private or when their thread finishes.
+     */
+    const MLocalePrivate *forCurrentThread() const;
+    void dropThreadPrivates();
+    // returns the cache of the given type in _formatters, 0 if there
+    // is none. Only reads, MLocale::cacheStatistics() calls it for
+    // privates of other threads too.
+    const MFormatterCacheCounters *formatterCache(MLocale::FormatterCache type) const;
+
+    // the thread which created this private and uses it directly
+    Qt::HANDLE _ownerThread;
+    mutable QReadWriteLock _threadPrivatesLock;
+    mutable QHash<Qt::HANDLE, MLocalePrivate *> _threadPrivates;
+
     bool _valid;
 
     // the default locale is used for messages and other categories if not
@@ -194,6 +479,39 @@ public:
     QString _nameLocale;
     QString _telephoneLocale;
 
+    // parsed identifiers of _defaultLocale and of the effective
+    // locale of each category, see updateLocaleIdentifiers()
+    const MLocaleIdentifier *_defaultIdentifier;
+    const MLocaleIdentifier *_categoryIdentifiers[MLocale::MLcTelephone + 1];
+
+    // facts derived from the category names which the formatting
+    // functions would otherwise work out again on every call. The
+    // profile is rebuilt as a whole by updateLocaleIdentifiers() and
+    // only read everywhere else.
+    struct Profile {
+        Profile();
+
+        // fixCategoryNameForNumbers(categoryName(category))
+        QString categoryNamesForNumbers[MLocale::MLcTelephone + 1];
+        // fixCategoryNameForNumbers(setCalendarOption(...)) of the
+        // time and the messages category for each calendar type
+        QString timeNamesForCalendar[MLocale::EthiopicCalendar + 1];
+        QString messagesNamesForCalendar[MLocale::EthiopicCalendar + 1];
+        // MLocale::localeScript() of the time and the messages
+        // category and whether these are right-to-left scripts
+        QString timeScript;
+        QString messagesScript;
+        bool timeIsRtl;
+        bool messagesIsRtl;
+        // true if month and weekday names of the messages locale are
+        // mixed into the date formats of the time locale
+        bool mixingSymbolsWanted;
+        // true if numbers formatted for the numeric category may need
+        // fixFormattedNumberForRTL() to swap prefix and postfix
+        bool numericNeedsRtlFixup;
+    };
+    Profile _profile;
+
     // the list of valid country codes for the formatPhoneNumber function
     QSet<QString> _validCountryCodes;
 
@@ -202,16 +520,279 @@ public:
     MLocale::PhoneNumberGrouping _phoneNumberGrouping;
 
 #ifdef HAVE_ICU
-    void removeDirectionalFormattingCodes(QString *str) const;
+    // removes all bidi formatting codes from str, optionally reports
+    // whether Arabic-Indic digits were found on the way
+    void removeDirectionalFormattingCodes(QString *str, bool *hasArabicIndicDigits = 0) const;
     void swapPostAndPrefixOfFormattedNumber(QString *formattedNumber) const;
     void fixFormattedNumberForRTL(QString *formattedNumber) const;
     void fixParseInputForRTL(QString *formattedNumber) const;
     // number format caching for better performance.
     icu::NumberFormat *_numberFormat;
     icu::NumberFormat *_numberFormatLcTime;
-    mutable QCache<QString, icu::DateFormat> _dateFormatCache;
-    mutable QCache<QString, icu::SimpleDateFormat> _simpleDateFormatCache;
-    mutable QCache<QString, QString> _icuFormatStringCache;
+    // Keys of _dateFormatCache and _simpleDateFormatCache. The
+    // interned identifiers of the time, numeric and messages
+    // categories stand for the category names and the hash is
+    // computed once, i.e. building a key and looking it up does not
+    // allocate anything.
+    struct DateFormatKey
+    {
+        DateFormatKey(const MLocalePrivate *d,
+                      MLocale::DateType dateType,
+                      MLocale::TimeType timeType,
+                      MLocale::CalendarType calendarType,
+                      MLocale::TimeFormat24h timeFormat24h);
+        bool operator==(const DateFormatKey &other) const;
+
+        quint8 dateType;
+        quint8 timeType;
+        quint8 calendarType;
+        quint8 timeFormat24h;
+        const MLocaleIdentifier *identifiers[3];
+        uint hash;
+    };
+    struct SimpleDateFormatKey
+    {
+        SimpleDateFormatKey(const MLocalePrivate *d,
+                            const QString &pattern,
+                            MLocale::CalendarType calendarType);
+        bool operator==(const SimpleDateFormatKey &other) const;
+
+        QString pattern;
+        quint8 calendarType;
+        const MLocaleIdentifier *identifiers[3];
+        uint hash;
+    };
+    // Keys of the pattern cache, either a date and time type or a
+    // skeleton. The store is specific to the categories and the time
+    // format, i.e. these need not be part of the key.
+    struct PatternKey
+    {
+        PatternKey(MLocale::DateType dateType,
+                   MLocale::TimeType timeType,
+                   MLocale::CalendarType calendarType,
+                   MLocale::TimeFormat24h timeFormat24h);
+        PatternKey(const QString &skeleton, MLocale::CalendarType calendarType);
+        bool operator==(const PatternKey &other) const;
+
+        QString skeleton;
+        // date type, time type, calendar type and time format in
+        // one byte each, 0xff as date type for skeletons
+        quint32 types;
+        uint hash;
+    };
+    // approximate heap size of a cached date formatter in bytes
+    static int approximateSize(const icu::DateFormat *df);
+    // A POSIX format string of MLocale::formatDateTime(const
+    // MCalendar &, const QString &) compiled into ICU patterns and
+    // slots for the conversions which have no ICU pattern
+    struct PosixFormatSegment
+    {
+        enum Kind {
+            IcuPattern,
+            // order as in _posixRepresentationFormats:
+            DateTimeRepresentation,
+            DateRepresentation,
+            TimeRepresentation,
+            Century,
+            WeekdayFromMonday,
+            WeekdayFromSunday,
+            WeekNumberFromSunday,
+            WeekNumberFromMonday,
+            IsoWeekNumber
+        };
+        Kind kind;
+        // the ICU pattern if kind is IcuPattern
+        QString pattern;
+    };
+    typedef QVector<PosixFormatSegment> PosixFormatPlan;
+    PosixFormatPlan *compilePosixFormat(const QString &formatString) const;
+    static int approximateSize(const PosixFormatPlan &plan);
+    // the formatters of the message locale for %c, %x and %X
+    enum { PosixRepresentationCount = 3 };
+    icu::DateFormat *posixRepresentationFormat(PosixFormatSegment::Kind kind) const;
+    // returns a cached number formatter of the numeric category with
+    // the given fraction digits set, 0 if it could not be created
+    icu::NumberFormat *precisionNumberFormat(int maxPrecision, int minPrecision) const;
+    icu::NumberFormat *percentNumberFormat(int decimals) const;
+    // create what precisionNumberFormat() and percentNumberFormat()
+    // cache, the caller owns the result
+    icu::NumberFormat *newPrecisionNumberFormat(int maxPrecision, int minPrecision) const;
+    icu::NumberFormat *newPercentNumberFormat(int decimals) const;
+
+    // the collator of the collate category, cloned by
+    // MCollator(const MLocale &), 0 if it could not be created
+    const icu::Collator *cachedCollator() const;
+    icu::Collator *newCollator() const;
+    // MLocale::exemplarCharactersIndex() of the collate category
+    const QStringList &cachedExemplarCharactersIndex() const;
+    static QStringList lookupExemplarCharactersIndex(QString collationLocaleName);
+
+    // Parsers for toLongLong(), toDouble() etc. They are cloned from
+    // _numberFormat on first use so that parsing never has to toggle
+    // setParseIntegerOnly() on a shared formatter, i.e. several
+    // threads can parse with the same MLocale at the same time.
+    enum ParserType { IntegerParser, DoubleParser, ParserTypeCount };
+    mutable QAtomicPointer<icu::NumberFormat> _parsers[ParserTypeCount];
+    const icu::NumberFormat *parser(ParserType type) const;
+    void dropParsers();
+    icu::NumberFormat *currencyNumberFormat(const QString &currency) const;
+
+    // symbols of _numberFormat used to format integers without ICU
+    // for locales with simple number formats, see
+    // updateIntegerFormatSymbols()
+    struct IntegerFormatSymbols
+    {
+        IntegerFormatSymbols();
+
+        bool probed;               // false until updateIntegerFormatSymbols() ran
+        bool usable;
+        QChar digits[10];
+        QString groupingSeparator;
+        int groupingSize;          // 0 if no grouping is used
+        int secondaryGroupingSize;
+        int minimumGroupingDigits;
+        QString positivePrefix;
+        QString positiveSuffix;
+        QString negativePrefix;
+        QString negativeSuffix;
+    };
+    mutable IntegerFormatSymbols _integerFormatSymbols;
+    // Only the thread using this private writes
+    // _integerFormatSymbols, under this lock. Other threads copying
+    // this private read them with integerFormatSymbols().
+    mutable QMutex _integerFormatSymbolsLock;
+    // extracts the symbols from _numberFormat and checks them
+    // against ICU. This is not done when _numberFormat is created
+    // but by appendFormattedInteger() the first time an integer is
+    // formatted, _integerFormatSymbols has to be reset whenever
+    // _numberFormat is recreated.
+    void updateIntegerFormatSymbols() const;
+    // a consistent copy of _integerFormatSymbols for copies of this
+    // private, the owning thread may be probing them meanwhile
+    IntegerFormatSymbols integerFormatSymbols() const;
+    // appends the formatted number to *result and returns true if
+    // the simple integer symbols can be used, returns false and
+    // leaves *result alone otherwise
+    bool appendFormattedInteger(qlonglong number, QString *result) const;
+
+    // The configuration a FormatterStore is made for: the interned
+    // identifiers of all categories, the time format, the thread
+    // which uses the store and the ICU data it was created with.
+    struct FormatterStoreKey
+    {
+        explicit FormatterStoreKey(const MLocalePrivate *d);
+        bool operator==(const FormatterStoreKey &other) const;
+
+        const MLocaleIdentifier *identifiers[MLocale::MLcTelephone + 1];
+        quint8 timeFormat24h;
+        Qt::HANDLE thread;
+        int dataPathsSerial;
+        uint hash;
+    };
+
+    // Formatters created by MLocale::prepare() in a background
+    // thread and handed to the thread of the store through
+    // FormatterStore::prepared, see FormatterStore::adoptPrepared()
+    struct PreparedFormatters
+    {
+        PreparedFormatters();
+        ~PreparedFormatters();
+
+        QList<QPair<DateFormatKey, icu::DateFormat *> > dateFormats;
+        QList<QPair<qint64, icu::NumberFormat *> > precisionNumberFormats;
+        QList<QPair<int, icu::NumberFormat *> > percentNumberFormats;
+        icu::Collator *collator;
+        bool hasExemplarCharactersIndex;
+        QStringList exemplarCharactersIndex;
+        // published earlier and not adopted yet
+        PreparedFormatters *next;
+
+    private:
+        Q_DISABLE_COPY(PreparedFormatters)
+    };
+    // creates the formatters selected by flags and publishes them to
+    // the store of this private, may be called from any thread as
+    // long as this private is not changed
+    void prepareFormatters(MLocale::PrepareFlags flags) const;
+
+    // The formatter caches. All privates of a thread with the same
+    // configuration share one store, i.e. a temporary MLocale copied
+    // from the default locale finds the formatters the default
+    // locale has created already. A store is never changed to fit
+    // another configuration, a private whose categories or time
+    // format change moves to the store of the new configuration, see
+    // updateFormatterStore(). Only the thread of the key uses the
+    // caches of a store.
+    struct FormatterStore
+    {
+        explicit FormatterStore(const FormatterStoreKey &key);
+        ~FormatterStore();
+
+        void dropPosixRepresentationFormats();
+        void dropScratchCalendars();
+        // moves the formatters published to prepared into the caches,
+        // keeping entries which are cached already
+        void adoptPrepared();
+
+        FormatterStoreKey key;
+        // guarded by the mutex of the store registry
+        int refCount;
+
+        MFormatterCache<DateFormatKey, icu::DateFormat> dateFormatCache;
+        MFormatterCache<SimpleDateFormatKey, icu::SimpleDateFormat> simpleDateFormatCache;
+        MFormatterCache<QString, PosixFormatPlan> posixFormatPlanCache;
+        // the formatters of the message locale for %c, %x and %X
+        icu::DateFormat *posixRepresentationFormats[PosixRepresentationCount];
+        // results of dateSymbolNames()
+        QHash<int, QStringList> dateSymbolNamesCache;
+        // number formatters for formatNumber(double, int, int) keyed
+        // by maximum and minimum precision, for formatPercent() keyed
+        // by decimals and for formatCurrency() keyed by ISO 4217
+        // currency code
+        MFormatterCache<qint64, icu::NumberFormat> precisionNumberFormatCache;
+        MFormatterCache<int, icu::NumberFormat> percentNumberFormatCache;
+        MFormatterCache<QString, icu::NumberFormat> currencyNumberFormatCache;
+
+        // the calendars of scratchCalendar() and the formatters used
+        // with them, see there
+        MCalendar *scratchCalendars[MLocale::EthiopicCalendar + 1];
+        int scratchCalendarsTimeZoneSerial;
+        MFormatterCache<DateFormatKey, MIncrementalDateFormat> incrementalDateFormatCache;
+
+        // patterns of icuFormatString() and skeletonFormatString(),
+        // and the pattern generators keyed by calendar type
+        MFormatterCache<PatternKey, QString> patternCache;
+        MFormatterCache<int, icu::DateTimePatternGenerator> patternGeneratorCache;
+
+        // see cachedCollator() and cachedExemplarCharactersIndex()
+        icu::Collator *collator;
+        bool hasExemplarCharactersIndex;
+        QStringList exemplarCharactersIndex;
+
+        // the only member other threads write to
+        QAtomicPointer<PreparedFormatters> prepared;
+
+    private:
+        Q_DISABLE_COPY(FormatterStore)
+    };
+
+    // returns the store for key with a reference added, creates it if
+    // there is none yet
+    static FormatterStore *acquireFormatterStore(const FormatterStoreKey &key);
+    // drops a reference, deletes the store with the last one
+    static void releaseFormatterStore(FormatterStore *store);
+    // moves to the store matching the current configuration, has to
+    // be called whenever a category or the time format changes
+    void updateFormatterStore();
+    // returns _formatters after adopting what has been prepared for
+    // it, only for the thread of the store. Moves to a new store
+    // first if the data paths have changed since _formatters was
+    // acquired.
+    FormatterStore *formatters() const;
+    FormatterStore *_formatters;
+    // incremented by MLocale::setDataPaths(), stores made for an
+    // older serial are not used any more
+    static QAtomicInt _dataPathsSerial;
 #endif
 
     // translations for two supported translation categories
@@ -236,11 +817,51 @@ public:
     // calendar instance used formatDateTimeICU()
 #ifdef HAVE_ICU
     MCalendar *_pDateTimeCalendar;
+
+    // returns the calendar of the given type which
+    // formatDateTime(const QDateTime &, ...) and
+    // formatDateTime(qint64, ...) set and format instead of creating
+    // a new MCalendar for every call. The scratch calendars are
+    // created for the time category of the formatter store and the
+    // system time zone current at that time. The formatters used
+    // with them cache
+    // parts which are only valid for the time zone of the scratch
+    // calendars and are dropped together with them.
+    MCalendar *scratchCalendar(MLocale::CalendarType calendarType) const;
+    // converts dateTime to an ICU date like MCalendar::setDateTime()
+    // but with the time zone the scratch calendar already has instead
+    // of creating the system time zone again
+    static UDate scratchDate(const MCalendar *calendar, const QDateTime &dateTime);
+    MIncrementalDateFormat *incrementalDateFormat(MLocale::DateType dateType,
+                                                  MLocale::TimeType timeType,
+                                                  MLocale::CalendarType calendarType) const;
 #endif
 
     MLocale *q_ptr;
 };
 
+#ifdef HAVE_ICU
+inline uint qHash(const MLocalePrivate::DateFormatKey &key, uint seed = 0)
+{
+    return key.hash ^ seed;
+}
+
+inline uint qHash(const MLocalePrivate::SimpleDateFormatKey &key, uint seed = 0)
+{
+    return key.hash ^ seed;
+}
+
+inline uint qHash(const MLocalePrivate::FormatterStoreKey &key, uint seed = 0)
+{
+    return key.hash ^ seed;
+}
+
+inline uint qHash(const MLocalePrivate::PatternKey &key, uint seed = 0)
+{
+    return key.hash ^ seed;
+}
+#endif
+
 }
 
 #endif
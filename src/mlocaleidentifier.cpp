@@ -0,0 +1,272 @@
+/***************************************************************************
+**
+** This file is part of libmlocale.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "mlocaleidentifier.h"
+
+namespace ML10N {
+
+namespace
+{
+    inline bool isAsciiLower(QChar c)
+    {
+        return c.unicode() >= 'a' && c.unicode() <= 'z';
+    }
+
+    inline bool isAsciiUpper(QChar c)
+    {
+        return c.unicode() >= 'A' && c.unicode() <= 'Z';
+    }
+
+    // Matches “(?:_{1,2}([A-Z][A-Z_]*))?$” starting at pos and
+    // returns the position where the variant starts in *variantStart,
+    // or -1 if there is no variant.
+    bool matchVariant(const QString &s, int pos, int *variantStart)
+    {
+        const int n = s.size();
+        *variantStart = -1;
+        if (pos == n)
+            return true;
+        if (s.at(pos) != QLatin1Char('_'))
+            return false;
+        ++pos;
+        if (pos < n && s.at(pos) == QLatin1Char('_'))
+            ++pos;
+        if (pos == n || !isAsciiUpper(s.at(pos)))
+            return false;
+        for (int i = pos + 1; i < n; ++i) {
+            if (!isAsciiUpper(s.at(i)) && s.at(i) != QLatin1Char('_'))
+                return false;
+        }
+        *variantStart = pos;
+        return true;
+    }
+
+    // returns true if the keyword token s[begin, end) is “key=...”
+    inline bool tokenHasKey(const QString &s, int begin, int end, const QString &key)
+    {
+        const int keySize = key.size();
+        if (end - begin <= keySize || s.at(begin + keySize) != QLatin1Char('='))
+            return false;
+        for (int i = 0; i < keySize; ++i) {
+            if (s.at(begin + i) != key.at(i))
+                return false;
+        }
+        return true;
+    }
+}
+
+MLocaleIdentifier::MLocaleIdentifier()
+    : _valid(false)
+{
+}
+
+MLocaleIdentifier::MLocaleIdentifier(const QString &localeName)
+    : _valid(false)
+{
+    const int at = localeName.indexOf(QLatin1Char('@'));
+    if (at < 0) {
+        _baseName = localeName;
+    } else {
+        _baseName = localeName.left(at);
+        const int n = localeName.size();
+        int begin = at + 1;
+        while (begin < n) {
+            int end = localeName.indexOf(QLatin1Char(';'), begin);
+            if (end < 0)
+                end = n;
+            if (end > begin) {
+                Keyword keyword;
+                const int eq = localeName.indexOf(QLatin1Char('='), begin);
+                if (eq < 0 || eq >= end) {
+                    keyword.key = localeName.mid(begin, end - begin);
+                } else {
+                    keyword.key = localeName.mid(begin, eq - begin);
+                    keyword.value = localeName.mid(eq + 1, end - eq - 1);
+                }
+                _keywords.append(keyword);
+            }
+            begin = end + 1;
+        }
+    }
+    _valid = parseBaseName();
+}
+
+bool MLocaleIdentifier::parseBaseName()
+{
+    // aa_Bbbb_CC_DDDDDD, i.e. the base name has to match
+    //     ^([a-z]{2,3})(?:_([A-Z][a-z]{3,3}))?(?:_([A-Z]{2,2}|419))?(?:_{1,2}([A-Z][A-Z_]*))?$
+    // The country part is usually a 2 letter uppercase code
+    // but there is the exception es_419, i.e. Spanish in Latin
+    // America where the “country code” is “419”.
+    const QString &s = _baseName;
+    const int n = s.size();
+
+    int pos = 0;
+    while (pos < n && isAsciiLower(s.at(pos)))
+        ++pos;
+    if (pos < 2 || pos > 3)
+        return false;
+    const int languageEnd = pos;
+
+    int scriptStart = -1;
+    if (pos + 5 <= n
+        && s.at(pos) == QLatin1Char('_')
+        && isAsciiUpper(s.at(pos + 1))
+        && isAsciiLower(s.at(pos + 2))
+        && isAsciiLower(s.at(pos + 3))
+        && isAsciiLower(s.at(pos + 4))) {
+        scriptStart = pos + 1;
+        pos += 5;
+    }
+
+    int countryStart = -1;
+    int variantStart = -1;
+    if (pos + 3 <= n
+        && s.at(pos) == QLatin1Char('_')
+        && ((isAsciiUpper(s.at(pos + 1)) && isAsciiUpper(s.at(pos + 2)))
+            || (s.at(pos + 1) == QLatin1Char('4')
+                && s.at(pos + 2) == QLatin1Char('1')
+                && (pos + 3 < n && s.at(pos + 3) == QLatin1Char('9'))))) {
+        const int countryLength = s.at(pos + 1) == QLatin1Char('4') ? 3 : 2;
+        if (matchVariant(s, pos + 1 + countryLength, &variantStart)) {
+            countryStart = pos + 1;
+            pos += 1 + countryLength;
+        }
+    }
+    // if there is no country, what follows may still be a variant
+    // as in “en__POSIX” or “de_DEU”:
+    if (countryStart < 0 && !matchVariant(s, pos, &variantStart))
+        return false;
+
+    _language = s.left(languageEnd);
+    if (scriptStart >= 0)
+        _script = s.mid(scriptStart, 4);
+    if (countryStart >= 0)
+        _country = s.mid(countryStart, pos - countryStart);
+    if (variantStart >= 0)
+        _variant = s.mid(variantStart);
+    return true;
+}
+
+bool MLocaleIdentifier::isValid() const
+{
+    return _valid;
+}
+
+const QString &MLocaleIdentifier::baseName() const
+{
+    return _baseName;
+}
+
+const QString &MLocaleIdentifier::language() const
+{
+    return _language;
+}
+
+const QString &MLocaleIdentifier::script() const
+{
+    return _script;
+}
+
+const QString &MLocaleIdentifier::country() const
+{
+    return _country;
+}
+
+const QString &MLocaleIdentifier::variant() const
+{
+    return _variant;
+}
+
+int MLocaleIdentifier::indexOfKeyword(const QString &key) const
+{
+    for (int i = 0; i < _keywords.size(); ++i) {
+        if (_keywords.at(i).key == key)
+            return i;
+    }
+    return -1;
+}
+
+bool MLocaleIdentifier::hasKeyword(const QString &key) const
+{
+    return indexOfKeyword(key) >= 0;
+}
+
+QString MLocaleIdentifier::keywordValue(const QString &key) const
+{
+    const int i = indexOfKeyword(key);
+    if (i < 0)
+        return QString();
+    return _keywords.at(i).value;
+}
+
+void MLocaleIdentifier::setKeywordValue(const QString &key, const QString &value)
+{
+    const int i = indexOfKeyword(key);
+    if (value.isEmpty()) {
+        if (i >= 0)
+            _keywords.remove(i);
+    } else if (i >= 0) {
+        _keywords[i].value = value;
+    } else {
+        Keyword keyword;
+        keyword.key = key;
+        keyword.value = value;
+        _keywords.append(keyword);
+    }
+}
+
+QString MLocaleIdentifier::toString() const
+{
+    if (_keywords.isEmpty())
+        return _baseName;
+
+    int size = _baseName.size();
+    for (int i = 0; i < _keywords.size(); ++i)
+        size += _keywords.at(i).key.size() + _keywords.at(i).value.size() + 2;
+
+    QString result;
+    result.reserve(size);
+    result += _baseName;
+    for (int i = 0; i < _keywords.size(); ++i) {
+        result += (i == 0) ? QLatin1Char('@') : QLatin1Char(';');
+        result += _keywords.at(i).key;
+        if (!_keywords.at(i).value.isNull()) {
+            result += QLatin1Char('=');
+            result += _keywords.at(i).value;
+        }
+    }
+    return result;
+}
+
+QString MLocaleIdentifier::keywordValue(const QString &localeName, const QString &key)
+{
+    const int at = localeName.indexOf(QLatin1Char('@'));
+    if (at <= 0 || key.isEmpty())
+        return QString();
+
+    const int n = localeName.size();
+    int begin = at + 1;
+    while (begin < n) {
+        int end = localeName.indexOf(QLatin1Char(';'), begin);
+        if (end < 0)
+            end = n;
+        if (tokenHasKey(localeName, begin, end, key)) {
+            const int valueStart = begin + key.size() + 1;
+            return localeName.mid(valueStart, end - valueStart);
+        }
+        begin = end + 1;
+    }
+    return QString();
+}
+
+}
@@ -0,0 +1,109 @@
+/***************************************************************************
+**
+** This file is part of libmlocale.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef ML10N_MLOCALEIDENTIFIER_H
+#define ML10N_MLOCALEIDENTIFIER_H
+
+#include <QString>
+#include <QVector>
+
+namespace ML10N {
+
+//! \internal
+
+/*!
+ * \brief A parsed ICU locale identifier
+ *
+ * An ICU locale identifier looks like this:
+ *
+ *     aa_Bbbb_CC_DDDDDD@foo=fooval;bar=barval
+ *
+ * see also http://userguide.icu-project.org/locale
+ *
+ * MLocaleIdentifier splits such a string once into its language,
+ * script, country and variant parts and its list of keywords so
+ * that options can be read and modified without reparsing the
+ * string (and without any regular expressions). The keywords keep
+ * the order in which they appear in the string, toString()
+ * reproduces a well formed identifier unchanged.
+ */
+class MLocaleIdentifier
+{
+public:
+    MLocaleIdentifier();
+    explicit MLocaleIdentifier(const QString &localeName);
+
+    /*!
+     * \brief returns true if the part before the “@” is a well formed
+     * aa_Bbbb_CC_DDDDDD locale name
+     *
+     * If it is not, language(), script(), country() and variant()
+     * return empty strings, the keywords are parsed nevertheless.
+     */
+    bool isValid() const;
+
+    //! returns the part of the identifier before the “@”
+    const QString &baseName() const;
+    const QString &language() const;
+    const QString &script() const;
+    const QString &country() const;
+    const QString &variant() const;
+
+    //! returns true if the identifier contains the keyword \a key
+    bool hasKeyword(const QString &key) const;
+
+    //! returns the value of the keyword \a key, an empty string if it is not set
+    QString keywordValue(const QString &key) const;
+
+    /*!
+     * \brief sets the keyword \a key to \a value
+     *
+     * An empty \a value removes the keyword. A new keyword is
+     * appended after the existing ones.
+     */
+    void setKeywordValue(const QString &key, const QString &value);
+
+    //! returns the identifier as a string, e.g. “fi_FI@calendar=gregorian”
+    QString toString() const;
+
+    /*!
+     * \brief returns the value of the keyword \a key in \a localeName
+     *
+     * Scans \a localeName in place, this is cheaper than
+     * constructing an MLocaleIdentifier if only a single value is
+     * needed.
+     */
+    static QString keywordValue(const QString &localeName, const QString &key);
+
+private:
+    struct Keyword {
+        QString key;
+        QString value;
+    };
+
+    bool parseBaseName();
+    int indexOfKeyword(const QString &key) const;
+
+    QString _baseName;
+    QString _language;
+    QString _script;
+    QString _country;
+    QString _variant;
+    QVector<Keyword> _keywords;
+    bool _valid;
+};
+
+//! \internal_end
+
+}
+
+#endif
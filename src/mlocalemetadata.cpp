@@ -0,0 +1,355 @@
+/***************************************************************************
+**
+** This file is part of libmlocale.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "mlocalemetadata.h"
+#include "mlocale.h"
+#include "mlocale_p.h"
+#include "mlocaleidentifier.h"
+
+#include <unicode/uloc.h>
+#include <unicode/uversion.h>
+
+#include <MDebug>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QAtomicPointer>
+#include <QList>
+#include <QStringList>
+
+#include <algorithm>
+
+namespace ML10N {
+
+namespace
+{
+    const char Magic[4] = { 'M', 'L', 'M', 'D' };
+    const quint32 Version = 2;
+    const qint64 HeaderSize = sizeof(Magic) + 4 * sizeof(quint32);
+    const qint64 EntrySize = MLocaleMetadataTable::FieldCount * sizeof(quint32);
+    const char *const FileName = "mlocalemetadata.bin";
+
+    bool recordLessThan(const MLocaleMetadataTable::Record &a,
+                        const MLocaleMetadataTable::Record &b)
+    {
+        return a.fields[MLocaleMetadataTable::LocaleName]
+            < b.fields[MLocaleMetadataTable::LocaleName];
+    }
+
+    // the ICU version and the data paths a table is generated with,
+    // it is valid only as long as both are the same
+    QString currentIcuVersion()
+    {
+        UVersionInfo versionInfo;
+        char version[U_MAX_VERSION_STRING_LENGTH];
+        u_getVersion(versionInfo);
+        u_versionToString(versionInfo, version);
+        return QString::fromLatin1(version);
+    }
+
+    QString currentDataPaths()
+    {
+        return MLocale::dataPaths().join(QLatin1Char('\n'));
+    }
+
+    // appends string to the string pool unless it is there already
+    // and returns its offset from the start of the file
+    quint32 appendString(QByteArray *strings, QHash<QString, quint32> *stringOffsets,
+                         qint64 stringsOffset, const QString &string)
+    {
+        QHash<QString, quint32>::const_iterator it = stringOffsets->constFind(string);
+        if (it != stringOffsets->constEnd())
+            return it.value();
+        const quint32 offset = quint32(stringsOffset + strings->size());
+        stringOffsets->insert(string, offset);
+        const quint16 length = quint16(string.size());
+        strings->append(reinterpret_cast<const char *>(&length), sizeof(length));
+        strings->append(reinterpret_cast<const char *>(string.constData()),
+                        length * sizeof(QChar));
+        return offset;
+    }
+
+    // compares the UTF-16 units of a with b like QString::operator<() does
+    int compareUnits(const QChar *a, int aLength, const QString &b)
+    {
+        const int length = qMin(aLength, b.size());
+        const QChar *bUnits = b.constData();
+        for (int i = 0; i < length; ++i) {
+            if (a[i] != bUnits[i])
+                return a[i].unicode() < bUnits[i].unicode() ? -1 : 1;
+        }
+        return aLength - b.size();
+    }
+
+    // the table of MLocaleMetadataTable::instance(), loaded once per
+    // set of data paths
+    struct MLocaleMetadataTableHolder
+    {
+        ~MLocaleMetadataTableHolder()
+        {
+            delete table.loadAcquire();
+            qDeleteAll(retired);
+        }
+
+        QMutex mutex;
+        QAtomicInt loaded;
+        QAtomicPointer<MLocaleMetadataTable> table;
+        // tables dropped by reset(), other threads may still be
+        // looking something up in them
+        QList<MLocaleMetadataTable *> retired;
+    };
+}
+
+Q_GLOBAL_STATIC(MLocaleMetadataTableHolder, metadataTableHolder)
+
+MLocaleMetadataTable::MLocaleMetadataTable(QFile *file, const uchar *data,
+                                           qint64 size, quint32 count)
+    : _file(file),
+      _data(data),
+      _size(size),
+      _count(count)
+{
+}
+
+MLocaleMetadataTable::~MLocaleMetadataTable()
+{
+    // unmaps the file as well:
+    delete _file;
+}
+
+const MLocaleMetadataTable *MLocaleMetadataTable::instance()
+{
+    MLocaleMetadataTableHolder *holder = metadataTableHolder();
+    if (!holder || holder->loaded.loadAcquire())
+        return holder ? holder->table.loadAcquire() : 0;
+
+    QMutexLocker locker(&holder->mutex);
+    if (!holder->loaded.loadAcquire()) {
+        const QStringList dataPaths = MLocale::dataPaths();
+        // the data paths are set when the first MLocale is created,
+        // try again later if that did not happen yet:
+        if (dataPaths.isEmpty())
+            return 0;
+        foreach (const QString &dataPath, dataPaths) { // krazy:exclude=foreach
+            MLocaleMetadataTable *table
+                = load(dataPath + QLatin1Char('/') + QLatin1String(FileName));
+            if (table) {
+                holder->table.storeRelease(table);
+                break;
+            }
+        }
+        holder->loaded.storeRelease(1);
+    }
+    return holder->table.loadAcquire();
+}
+
+void MLocaleMetadataTable::reset()
+{
+    MLocaleMetadataTableHolder *holder = metadataTableHolder();
+    if (!holder)
+        return;
+    QMutexLocker locker(&holder->mutex);
+    MLocaleMetadataTable *table = holder->table.fetchAndStoreOrdered(0);
+    if (table)
+        holder->retired.append(table);
+    holder->loaded.storeRelease(0);
+}
+
+MLocaleMetadataTable *MLocaleMetadataTable::load(const QString &fileName)
+{
+    QFile *file = new QFile(fileName);
+    if (!file->open(QIODevice::ReadOnly)) {
+        delete file;
+        return 0;
+    }
+    const qint64 size = file->size();
+    const uchar *data = size >= HeaderSize ? file->map(0, size) : 0;
+    quint32 header[4] = { 0, 0, 0, 0 };
+    if (data)
+        memcpy(header, data + sizeof(Magic), sizeof(header));
+    const quint32 version = header[0];
+    const quint32 count = header[1];
+    if (!data
+        || memcmp(data, Magic, sizeof(Magic)) != 0
+        || version != Version
+        || (size - HeaderSize) / EntrySize < qint64(count)) {
+        mDebug("MLocaleMetadataTable") << "Invalid locale metadata table" << fileName;
+        delete file;
+        return 0;
+    }
+    MLocaleMetadataTable *table = new MLocaleMetadataTable(file, data, size, count);
+    const QChar *units;
+    int length;
+    if (!table->string(header[2], &units, &length)
+        || QString(units, length) != currentIcuVersion()
+        || !table->string(header[3], &units, &length)
+        || QString(units, length) != currentDataPaths()) {
+        mDebug("MLocaleMetadataTable") << "Locale metadata table" << fileName
+                                       << "does not match the ICU version or data paths";
+        delete table;
+        return 0;
+    }
+    return table;
+}
+
+int MLocaleMetadataTable::size() const
+{
+    return int(_count);
+}
+
+quint32 MLocaleMetadataTable::offset(quint32 entry, Field field) const
+{
+    quint32 result;
+    memcpy(&result, _data + HeaderSize + entry * EntrySize + field * sizeof(quint32),
+           sizeof(result));
+    return result;
+}
+
+bool MLocaleMetadataTable::string(quint32 offset, const QChar **units, int *length) const
+{
+    if (offset % 2 != 0 || qint64(offset) + qint64(sizeof(quint16)) > _size)
+        return false;
+    quint16 stringLength;
+    memcpy(&stringLength, _data + offset, sizeof(stringLength));
+    if (qint64(offset) + qint64(sizeof(quint16)) + 2 * qint64(stringLength) > _size)
+        return false;
+    *units = reinterpret_cast<const QChar *>(_data + offset + sizeof(quint16));
+    *length = stringLength;
+    return true;
+}
+
+bool MLocaleMetadataTable::lookup(const QString &localeName, Field field,
+                                  QString *value) const
+{
+    quint32 low = 0;
+    quint32 high = _count;
+    while (low < high) {
+        const quint32 middle = low + (high - low) / 2;
+        const QChar *units;
+        int length;
+        if (!string(offset(middle, LocaleName), &units, &length))
+            return false;
+        const int comparison = compareUnits(units, length, localeName);
+        if (comparison < 0) {
+            low = middle + 1;
+        } else if (comparison > 0) {
+            high = middle;
+        } else {
+            if (!string(offset(middle, field), &units, &length))
+                return false;
+            *value = length > 0 ? QString(units, length) : QString();
+            return true;
+        }
+    }
+    return false;
+}
+
+QVector<MLocaleMetadataTable::Record> MLocaleMetadataTable::generate()
+{
+    QVector<Record> records;
+    const int numberOfAvailableLocales = uloc_countAvailable();
+    records.reserve(numberOfAvailableLocales);
+    for (int i = 0; i < numberOfAvailableLocales; ++i) {
+        // these are the same lookups MLocale does without the table:
+        const QString localeName = QString::fromLatin1(uloc_getAvailable(i));
+        Record record;
+        record.fields[LocaleName] = localeName;
+
+        QString languageEndonym
+            = MLocalePrivate::lookupLanguageEndonym(U_ICUDATA_NAME "-lang",
+                                                    localeName,
+                                                    QLatin1String("Languages"));
+        record.fields[LanguageEndonym]
+            = languageEndonym.isNull() ? localeName : languageEndonym;
+
+        const QString countryCode = MLocaleIdentifier(localeName).country();
+        if (!countryCode.isEmpty()) {
+            QString countryEndonym
+                = MLocalePrivate::lookupResourceString(U_ICUDATA_NAME "-region",
+                                                       localeName,
+                                                       QLatin1String("Countries/")
+                                                       + countryCode);
+            record.fields[CountryEndonym]
+                = countryEndonym.isNull() ? countryCode : countryEndonym;
+        }
+
+        record.fields[Script] = MLocalePrivate::lookupLocaleScript(localeName);
+
+        QString numberingSystem
+            = MLocalePrivate::lookupResourceString(NULL, localeName,
+                                                   QLatin1String("NumberElements/default"));
+        if (numberingSystem.isNull())
+            numberingSystem = QLatin1String("latn");
+        record.fields[NumberingSystem] = numberingSystem;
+
+        QString decimalPoint
+            = MLocalePrivate::lookupResourceString(NULL, localeName,
+                                                   QLatin1String("NumberElements/")
+                                                   + numberingSystem
+                                                   + QLatin1String("/symbols/decimal"));
+        record.fields[DecimalPoint]
+            = decimalPoint.isNull() ? QString(QLatin1String(".")) : decimalPoint;
+
+        records.append(record);
+    }
+    return records;
+}
+
+bool MLocaleMetadataTable::write(const QString &fileName, QVector<Record> records)
+{
+    std::sort(records.begin(), records.end(), recordLessThan);
+
+    // equal strings, e.g. the many “latn” and “.”, are stored only once:
+    QByteArray strings;
+    QHash<QString, quint32> stringOffsets;
+    QByteArray entries;
+    const qint64 stringsOffset = HeaderSize + records.size() * EntrySize;
+    const QString icuVersion = currentIcuVersion();
+    const QString dataPaths = currentDataPaths();
+    if (dataPaths.size() > 0xFFFF) {
+        mDebug("MLocaleMetadataTable") << "Data paths too long" << dataPaths;
+        return false;
+    }
+    const quint32 icuVersionOffset
+        = appendString(&strings, &stringOffsets, stringsOffset, icuVersion);
+    const quint32 dataPathsOffset
+        = appendString(&strings, &stringOffsets, stringsOffset, dataPaths);
+    for (int i = 0; i < records.size(); ++i) {
+        for (int field = 0; field < FieldCount; ++field) {
+            const QString &string = records.at(i).fields[field];
+            if (string.size() > 0xFFFF) {
+                mDebug("MLocaleMetadataTable") << "String too long" << string;
+                return false;
+            }
+            const quint32 offset
+                = appendString(&strings, &stringOffsets, stringsOffset, string);
+            entries.append(reinterpret_cast<const char *>(&offset), sizeof(offset));
+        }
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        mDebug("MLocaleMetadataTable") << "Cannot open" << fileName << file.errorString();
+        return false;
+    }
+    const quint32 count = quint32(records.size());
+    QByteArray header(Magic, sizeof(Magic));
+    header.append(reinterpret_cast<const char *>(&Version), sizeof(Version));
+    header.append(reinterpret_cast<const char *>(&count), sizeof(count));
+    header.append(reinterpret_cast<const char *>(&icuVersionOffset), sizeof(icuVersionOffset));
+    header.append(reinterpret_cast<const char *>(&dataPathsOffset), sizeof(dataPathsOffset));
+    return file.write(header) == header.size()
+        && file.write(entries) == entries.size()
+        && file.write(strings) == strings.size();
+}
+
+}
@@ -0,0 +1,137 @@
+/***************************************************************************
+**
+** This file is part of libmlocale.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef ML10N_MLOCALEMETADATA_H
+#define ML10N_MLOCALEMETADATA_H
+
+#include "mlocaleexport.h"
+
+#include <QString>
+#include <QVector>
+
+class QFile;
+
+namespace ML10N {
+
+//! \internal
+
+/*!
+ * \brief Precomputed metadata of all locales available in ICU
+ *
+ * The table is generated by the mlocale-metadata tool, which
+ * iterates over uloc_getAvailable(), and is installed as
+ * “mlocalemetadata.bin” into the ICU extra data directory. The file
+ * is mapped into memory, MLocale::languageEndonym(),
+ * MLocale::countryEndonym(), MLocale::localeScript(),
+ * MLocale::decimalPoint() and the numbering system lookups answer
+ * from it with a binary search if the locale name is in the table
+ * and fall back to the ICU resource bundles otherwise.
+ *
+ * The table describes the ICU data it was generated from. Its
+ * header records the ICU version and the MLocale::dataPaths() of
+ * the generator, a table which does not match the ICU library and
+ * the data paths of the process is not used.
+ *
+ * File format, native byte order:
+ *
+ *     header:  "MLMD", quint32 version, quint32 number of entries,
+ *              quint32 string offset of the ICU version,
+ *              quint32 string offset of the data paths (one per line)
+ *     entries: FieldCount quint32 string offsets, sorted by locale name
+ *     strings: quint16 length followed by the UTF-16 code units
+ *
+ * The string offsets are relative to the start of the file.
+ */
+class MLOCALE_EXPORT MLocaleMetadataTable
+{
+public:
+    enum Field {
+        LocaleName,
+        LanguageEndonym,
+        CountryEndonym,
+        Script,
+        NumberingSystem,
+        DecimalPoint,
+        FieldCount
+    };
+
+    struct Record {
+        QString fields[FieldCount];
+    };
+
+    ~MLocaleMetadataTable();
+
+    /*!
+     * \brief returns the table installed in one of the MLocale::dataPaths()
+     *
+     * The table is loaded on first use and stays mapped until the
+     * process exits. Returns 0 if no valid table is installed.
+     */
+    static const MLocaleMetadataTable *instance();
+
+    /*!
+     * \brief makes the next instance() load the table again
+     *
+     * Called by MLocale::setDataPaths(). The previous table stays
+     * mapped, callers may still use a pointer returned before.
+     */
+    static void reset();
+
+    /*!
+     * \brief maps the table in \a fileName
+     *
+     * Returns 0 if it is not a valid table or if it was generated
+     * with another ICU version or other data paths.
+     */
+    static MLocaleMetadataTable *load(const QString &fileName);
+
+    //! computes the records for all locales available in ICU
+    static QVector<Record> generate();
+
+    /*!
+     * \brief writes \a records to \a fileName in the format described above
+     *
+     * The header is stamped with the current ICU version and
+     * MLocale::dataPaths(), which have to be the ones \a records
+     * were generated with.
+     */
+    static bool write(const QString &fileName, QVector<Record> records);
+
+    //! returns the number of locales in the table
+    int size() const;
+
+    /*!
+     * \brief looks up \a field for \a localeName in O(log n)
+     *
+     * Returns false and leaves \a value alone if \a localeName is
+     * not in the table.
+     */
+    bool lookup(const QString &localeName, Field field, QString *value) const;
+
+private:
+    MLocaleMetadataTable(QFile *file, const uchar *data, qint64 size, quint32 count);
+    Q_DISABLE_COPY(MLocaleMetadataTable)
+
+    bool string(quint32 offset, const QChar **units, int *length) const;
+    quint32 offset(quint32 entry, Field field) const;
+
+    QFile *_file;
+    const uchar *_data;
+    qint64 _size;
+    quint32 _count;
+};
+
+//! \internal_end
+
+}
+
+#endif
@@ -27,11 +27,13 @@ PUBLIC_HEADERS += \
 
 PRIVATE_HEADERS += \
     mcalendar_p.h \
+    mlocaleidentifier.h \
     debug.h \
 
 SOURCES += \
     mbreakiterator.cpp \
     mlocale.cpp \
+    mlocaleidentifier.cpp \
     mlocalebuckets.cpp \
     mcountry.cpp \
     mcity.cpp \
@@ -46,19 +48,24 @@ contains(DEFINES, HAVE_ICU) {
     PUBLIC_HEADERS += \
         mcalendar.h \
         mcollator.h \
+        mdatetimeparser.h \
         mcharsetdetector.h \
         mcharsetmatch.h \
         mstringsearch.h \
 
     PRIVATE_HEADERS += \
         micubreakiterator.h \
-        micuconversions.h
+        micuconversions.h \
+        mdatetimeparser_p.h \
+        mlocalemetadata.h
 
     SOURCES += \
         mcalendar.cpp \
         mcollator.cpp \
+        mdatetimeparser.cpp \
         micubreakiterator.cpp \
         micuconversions.cpp \
+        mlocalemetadata.cpp \
         mcharsetdetector.cpp \
         mcharsetmatch.cpp \
         mstringsearch.cpp \
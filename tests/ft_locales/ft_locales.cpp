@@ -18,17 +18,105 @@
 ****************************************************************************/
 
 #include "ft_locales.h"
+#include "mlocalemetadata.h"
 
 #define VERBOSE_OUTPUT
 
 using ML10N::MLocale;
 using ML10N::MCalendar;
 using ML10N::MCollator;
+using ML10N::MLocaleMetadataTable;
 
 class TestLocale : public MLocale
 {
 };
 
+namespace
+{
+    // formats and parses a bit of everything which uses the caches of
+    // the locale, the results only depend on the locale
+    QStringList formatEverything(const MLocale &locale)
+    {
+        QStringList results;
+        results << locale.formatNumber(1234567)
+                << locale.formatNumber(-1234.5678, 2)
+                << locale.formatPercent(0.256, 1)
+                << locale.formatCurrency(1234.5, "EUR")
+                << QString::number(locale.toDouble(locale.formatNumber(1234.5678, 3)));
+#ifdef HAVE_ICU
+        MCalendar calendar(locale);
+        for (int i = 0; i < 40; ++i) {
+            // about 9 days and 5 hours apart
+            const qint64 msecsSinceEpoch
+                = Q_INT64_C(1262304000000) + qint64(i) * Q_INT64_C(795600000);
+            const MLocale::DateType dateType
+                = static_cast<MLocale::DateType>(MLocale::DateShort + i % 4);
+            const MLocale::TimeType timeType
+                = static_cast<MLocale::TimeType>(MLocale::TimeShort + i % 3);
+            const QString dateTime = locale.formatDateTime(msecsSinceEpoch,
+                                                           dateType, timeType);
+            calendar.setDateTime(QDateTime(QDate(1970, 1, 1), QTime(0, 0), Qt::UTC)
+                                 .addMSecs(msecsSinceEpoch));
+            results << dateTime
+                    << locale.parseDateTime(dateTime, dateType, timeType)
+                           .toString(Qt::ISODate)
+                    << locale.formatDateTime(calendar, "%A %d.%m.%Y %U %V %c");
+        }
+        results << locale.monthNames(calendar) << locale.weekdayNames(calendar);
+#endif
+        return results;
+    }
+
+    // formats with a locale shared between several of these tasks
+    // and counts the results which differ from the expected ones
+    class ConcurrentFormattingTask : public QRunnable
+    {
+    public:
+        ConcurrentFormattingTask(const MLocale *locale, const QStringList *expected,
+                                 int rounds, QAtomicInt *failures)
+            : _locale(locale), _expected(expected), _rounds(rounds), _failures(failures)
+        {
+        }
+
+        virtual void run()
+        {
+            for (int round = 0; round < _rounds; ++round) {
+                if (formatEverything(*_locale) != *_expected)
+                    _failures->ref();
+            }
+        }
+
+    private:
+        const MLocale *_locale;
+        const QStringList *_expected;
+        int _rounds;
+        QAtomicInt *_failures;
+    };
+
+    // formats a date with a locale created by another thread
+    class FormattingThread : public QThread
+    {
+    public:
+        explicit FormattingThread(const MLocale *locale)
+            : _locale(locale)
+        {
+        }
+
+        virtual void run()
+        {
+            const QDateTime dateTime(QDate(2008, 7, 21), QTime(14, 31, 3), Qt::LocalTime);
+            _result = _locale->formatDateTime(dateTime, MLocale::DateLong, MLocale::TimeShort);
+            _statistics = _locale->cacheStatistics(MLocale::DateFormatCache);
+        }
+
+        QString _result;
+        MLocale::CacheStatistics _statistics;
+
+    private:
+        const MLocale *_locale;
+    };
+}
+
 void Ft_Locales::initTestCase()
 {
 }
@@ -838,6 +926,53 @@ void Ft_Locales::testMLocaleCountryEndonym()
     QCOMPARE(locale.countryEndonym(), endonym_result);
 }
 
+void Ft_Locales::testMLocaleMetadataTable()
+{
+    QVector<MLocaleMetadataTable::Record> records = MLocaleMetadataTable::generate();
+    QVERIFY(records.size() > 100);
+    const QString fileName = QDir::tempPath() + "/ft_locales_mlocalemetadata.bin";
+    QVERIFY(MLocaleMetadataTable::write(fileName, records));
+    MLocaleMetadataTable *table = MLocaleMetadataTable::load(fileName);
+    QVERIFY(table != 0);
+    QCOMPARE(table->size(), records.size());
+
+    // the table has to give the same results as the lookups in the
+    // resource bundles:
+    foreach (const MLocaleMetadataTable::Record &record, records) {
+        const QString &localeName = record.fields[MLocaleMetadataTable::LocaleName];
+        QString value;
+        QVERIFY(table->lookup(localeName, MLocaleMetadataTable::LanguageEndonym, &value));
+        QCOMPARE(value, MLocale::languageEndonym(localeName));
+        QVERIFY(table->lookup(localeName, MLocaleMetadataTable::Script, &value));
+        QCOMPARE(value, MLocale::localeScript(localeName));
+        QVERIFY(table->lookup(localeName, MLocaleMetadataTable::CountryEndonym, &value));
+        QCOMPARE(value, MLocale(localeName).countryEndonym());
+    }
+    QString value;
+    QVERIFY(table->lookup("de_CH", MLocaleMetadataTable::DecimalPoint, &value));
+    QCOMPARE(value, QString("."));
+    QVERIFY(table->lookup("de_DE", MLocaleMetadataTable::DecimalPoint, &value));
+    QCOMPARE(value, QString(","));
+    QVERIFY(table->lookup("ar_EG", MLocaleMetadataTable::NumberingSystem, &value));
+    QCOMPARE(value, QString("arab"));
+    value = "unchanged";
+    QVERIFY(!table->lookup("xx_YY", MLocaleMetadataTable::LanguageEndonym, &value));
+    QVERIFY(!table->lookup("", MLocaleMetadataTable::LanguageEndonym, &value));
+    QCOMPARE(value, QString("unchanged"));
+    delete table;
+
+    // the table is stamped with the data paths, it is not used with others:
+    const QStringList dataPaths = MLocale::dataPaths();
+    MLocale::setDataPaths(QStringList(dataPaths) << QDir::tempPath());
+    QVERIFY(MLocaleMetadataTable::load(fileName) == 0);
+    MLocale::setDataPaths(dataPaths);
+    table = MLocaleMetadataTable::load(fileName);
+    QVERIFY(table != 0);
+    delete table;
+
+    QFile::remove(fileName);
+}
+
 void Ft_Locales::testMLocaleLocaleScripts_data()
 {
     QTest::addColumn<QString>("localeName");
@@ -4151,6 +4286,278 @@ void Ft_Locales::testDifferentStrengthComparison()
     
 }
 
+void Ft_Locales::testConcurrentFormatting_data()
+{
+    QTest::addColumn<QString>("localeName");
+
+    QTest::newRow("fi_FI") << "fi_FI";
+    QTest::newRow("ar_EG") << "ar_EG";
+    QTest::newRow("de_CH") << "de_CH";
+    QTest::newRow("ja_JP@calendar=japanese") << "ja_JP@calendar=japanese";
+}
+
+/*
+ * The const methods of one MLocale are used from several threads at
+ * the same time. Build with “qmake CONFIG+=tsan” to run this under
+ * ThreadSanitizer.
+ */
+void Ft_Locales::testConcurrentFormatting()
+{
+    QFETCH(QString, localeName);
+
+#ifdef HAVE_ICU
+    MCalendar::setSystemTimeZone("Europe/Helsinki");
+#endif
+    MLocale locale(localeName);
+    // the expected results are formatted by the thread which
+    // created the locale, the tasks run in other threads:
+    const QStringList expected = formatEverything(locale);
+
+    const int threads = 8;
+    QAtomicInt failures;
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    for (int i = 0; i < threads; ++i)
+        pool.start(new ConcurrentFormattingTask(&locale, &expected, 20, &failures));
+    // the creating thread keeps using the locale meanwhile:
+    for (int round = 0; round < 20; ++round)
+        QCOMPARE(formatEverything(locale), expected);
+    pool.waitForDone();
+    QCOMPARE(failures.loadAcquire(), 0);
+
+    // a changed locale is used by the tasks with its new settings:
+    locale.setCategoryLocale(MLocale::MLcNumeric, "en_US");
+    const QStringList changed = formatEverything(locale);
+    for (int i = 0; i < threads; ++i)
+        pool.start(new ConcurrentFormattingTask(&locale, &changed, 5, &failures));
+    pool.waitForDone();
+    QCOMPARE(failures.loadAcquire(), 0);
+}
+
+void Ft_Locales::testConcurrentFirstUse_data()
+{
+    testConcurrentFormatting_data();
+}
+
+/*
+ * Like testConcurrentFormatting() but the tasks start before the
+ * thread which created the locale has formatted anything, i.e. they
+ * copy its private while it still creates its formatters and probes
+ * its integer format symbols.
+ */
+void Ft_Locales::testConcurrentFirstUse()
+{
+    QFETCH(QString, localeName);
+
+#ifdef HAVE_ICU
+    MCalendar::setSystemTimeZone("Europe/Helsinki");
+#endif
+    const QStringList expected = formatEverything(MLocale(localeName));
+
+    const int threads = 8;
+    QAtomicInt failures;
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    MLocale locale(localeName);
+    for (int i = 0; i < threads; ++i)
+        pool.start(new ConcurrentFormattingTask(&locale, &expected, 2, &failures));
+    for (int round = 0; round < 2; ++round)
+        QCOMPARE(formatEverything(locale), expected);
+    pool.waitForDone();
+    QCOMPARE(failures.loadAcquire(), 0);
+}
+
+void Ft_Locales::testThreadPrivatesReleased()
+{
+    MLocale locale("fi_FI");
+    const QDateTime dateTime(QDate(2008, 7, 21), QTime(14, 31, 3), Qt::LocalTime);
+    const QString expected = locale.formatDateTime(dateTime, MLocale::DateLong, MLocale::TimeShort);
+    const qint64 entries = locale.cacheStatistics(MLocale::DateFormatCache).entries;
+
+    // every thread formats with its own copy of the private, the
+    // copy and its caches are deleted when the thread finishes:
+    for (int i = 0; i < 3; ++i) {
+        FormattingThread thread(&locale);
+        thread.start();
+        QVERIFY(thread.wait());
+        QCOMPARE(thread._result, expected);
+        QVERIFY(thread._statistics.entries > entries);
+        QCOMPARE(locale.cacheStatistics(MLocale::DateFormatCache).entries, entries);
+    }
+}
+
+void Ft_Locales::testCacheStatistics()
+{
+    MLocale locale("fi_FI");
+    MCalendar calendar(MLocale::GregorianCalendar);
+    calendar.setDateTime(QDateTime(QDate(2008, 7, 21), QTime(14, 31, 3), Qt::LocalTime));
+
+    const MLocale::CacheStatistics before = locale.cacheStatistics(MLocale::DateFormatCache);
+    const MLocale::CacheStatistics totalBefore =
+        MLocale::totalCacheStatistics(MLocale::DateFormatCache);
+
+    QString first = locale.formatDateTime(calendar, MLocale::DateLong, MLocale::TimeShort);
+    QCOMPARE(locale.formatDateTime(calendar, MLocale::DateLong, MLocale::TimeShort), first);
+    MLocale::CacheStatistics statistics = locale.cacheStatistics(MLocale::DateFormatCache);
+    QCOMPARE(statistics.misses - before.misses, qint64(1));
+    QCOMPARE(statistics.hits - before.hits, qint64(1));
+    QCOMPARE(statistics.entries - before.entries, qint64(1));
+    QVERIFY(statistics.bytes > before.bytes);
+
+    const MLocale::CacheStatistics total =
+        MLocale::totalCacheStatistics(MLocale::DateFormatCache);
+    QCOMPARE(total.misses - totalBefore.misses, qint64(1));
+    QCOMPARE(total.hits - totalBefore.hits, qint64(1));
+
+    // room for a single formatter, the others are evicted:
+    const int capacity = MLocale::cacheCapacity(MLocale::DateFormatCache);
+    const int formatterSize = int(statistics.bytes - before.bytes);
+    MLocale::setCacheCapacity(MLocale::DateFormatCache, formatterSize);
+    QCOMPARE(MLocale::cacheCapacity(MLocale::DateFormatCache), formatterSize);
+    QString second = locale.formatDateTime(calendar, MLocale::DateShort, MLocale::TimeShort);
+    const qint64 evictions = statistics.evictions + statistics.entries;
+    statistics = locale.cacheStatistics(MLocale::DateFormatCache);
+    QCOMPARE(statistics.entries, qint64(1));
+    QCOMPARE(statistics.evictions, evictions);
+
+    // the results do not depend on the capacity:
+    QCOMPARE(locale.formatDateTime(calendar, MLocale::DateLong, MLocale::TimeShort), first);
+    MLocale::setCacheCapacity(MLocale::DateFormatCache, 0);
+    QCOMPARE(locale.formatDateTime(calendar, MLocale::DateShort, MLocale::TimeShort), second);
+    MLocale::setCacheCapacity(MLocale::DateFormatCache, capacity);
+
+    // changing the locale moves it to the caches of its new
+    // configuration, a copy keeps using the caches of the old one:
+    locale.setCategoryLocale(MLocale::MLcNumeric, "ar_EG");
+    locale.formatNumber(1.5, 2);
+    QCOMPARE(locale.cacheStatistics(MLocale::PrecisionNumberFormatCache).entries, qint64(1));
+    const MLocale arabic(locale);
+    const MLocale::CacheStatistics arabicBefore =
+        arabic.cacheStatistics(MLocale::PrecisionNumberFormatCache);
+    locale.setCategoryLocale(MLocale::MLcNumeric, "fi_FI");
+    QVERIFY(locale.formatNumber(1.5, 2) != arabic.formatNumber(1.5, 2));
+    const MLocale::CacheStatistics arabicAfter =
+        arabic.cacheStatistics(MLocale::PrecisionNumberFormatCache);
+    QCOMPARE(arabicAfter.entries, qint64(1));
+    QCOMPARE(arabicAfter.misses, arabicBefore.misses);
+    QCOMPARE(arabicAfter.hits, arabicBefore.hits + 1);
+}
+
+void Ft_Locales::testSharedFormatterCaches()
+{
+    MLocale locale("de_DE");
+    MLocale copy(locale);
+    MCalendar calendar(MLocale::GregorianCalendar);
+    calendar.setDateTime(QDateTime(QDate(2008, 7, 21), QTime(14, 31, 3), Qt::LocalTime));
+
+    // the copy finds the formatter the original has created:
+    const QString formatted = locale.formatDateTime(calendar, MLocale::DateLong, MLocale::TimeShort);
+    const MLocale::CacheStatistics before = copy.cacheStatistics(MLocale::DateFormatCache);
+    QCOMPARE(copy.formatDateTime(calendar, MLocale::DateLong, MLocale::TimeShort), formatted);
+    MLocale::CacheStatistics statistics = copy.cacheStatistics(MLocale::DateFormatCache);
+    QCOMPARE(statistics.hits - before.hits, qint64(1));
+    QCOMPARE(statistics.misses - before.misses, qint64(0));
+
+    // changing the copy leaves the caches of the original alone:
+    copy.setCategoryLocale(MLocale::MLcTime, "en_US");
+    QVERIFY(copy.formatDateTime(calendar, MLocale::DateLong, MLocale::TimeShort) != formatted);
+    QCOMPARE(locale.formatDateTime(calendar, MLocale::DateLong, MLocale::TimeShort), formatted);
+    QCOMPARE(locale.cacheStatistics(MLocale::DateFormatCache).entries, statistics.entries);
+
+    // and changing it back shares them again:
+    copy.setCategoryLocale(MLocale::MLcTime, "");
+    statistics = copy.cacheStatistics(MLocale::DateFormatCache);
+    QCOMPARE(copy.formatDateTime(calendar, MLocale::DateLong, MLocale::TimeShort), formatted);
+    QCOMPARE(copy.cacheStatistics(MLocale::DateFormatCache).hits - statistics.hits, qint64(1));
+
+    // the formatters are created anew after the data paths were set:
+    MLocale::setDataPaths(MLocale::dataPaths());
+    QCOMPARE(locale.formatDateTime(calendar, MLocale::DateLong, MLocale::TimeShort), formatted);
+    statistics = locale.cacheStatistics(MLocale::DateFormatCache);
+    QCOMPARE(statistics.misses, qint64(1));
+    QCOMPARE(statistics.hits, qint64(0));
+    QCOMPARE(copy.formatDateTime(calendar, MLocale::DateLong, MLocale::TimeShort), formatted);
+    QCOMPARE(copy.cacheStatistics(MLocale::DateFormatCache).hits, qint64(1));
+}
+
+void Ft_Locales::testPrepare()
+{
+    MLocale locale("fr_FR");
+    // the results must be the same as without preparing, the name
+    // category keeps the caches apart but changes no results:
+    MLocale unprepared("fr_FR");
+    unprepared.setCategoryLocale(MLocale::MLcName, "fr_CA");
+    const QDateTime dateTime(QDate(2008, 7, 21), QTime(14, 31, 3), Qt::LocalTime);
+
+    locale.prepare();
+    QThreadPool::globalInstance()->waitForDone();
+
+    MLocale::CacheStatistics before = locale.cacheStatistics(MLocale::DateFormatCache);
+    QCOMPARE(locale.formatDateTime(dateTime, MLocale::DateLong, MLocale::TimeShort),
+             unprepared.formatDateTime(dateTime, MLocale::DateLong, MLocale::TimeShort));
+    MLocale::CacheStatistics statistics = locale.cacheStatistics(MLocale::DateFormatCache);
+    QCOMPARE(statistics.misses - before.misses, qint64(0));
+    QCOMPARE(statistics.hits - before.hits, qint64(1));
+    QVERIFY(statistics.entries >= 24);
+
+    before = locale.cacheStatistics(MLocale::PercentNumberFormatCache);
+    QCOMPARE(locale.formatPercent(0.125, 1), unprepared.formatPercent(0.125, 1));
+    statistics = locale.cacheStatistics(MLocale::PercentNumberFormatCache);
+    QCOMPARE(statistics.misses - before.misses, qint64(0));
+
+    QCOMPARE(locale.exemplarCharactersIndex(), unprepared.exemplarCharactersIndex());
+    QCOMPARE(locale.indexBucket(QString::fromUtf8("élan")), QString::fromUtf8("E"));
+    MCollator collator = locale.collator();
+    QVERIFY(collator(QString::fromUtf8("côte"), QString::fromUtf8("coter")));
+
+    // prepared formatters must not evict the cached ones:
+    const int capacity = MLocale::cacheCapacity(MLocale::DateFormatCache);
+    MLocale hebrew("he_IL@calendar=hebrew");
+    const QString formatted = hebrew.formatDateTime(dateTime, MLocale::DateLong, MLocale::TimeShort);
+    before = hebrew.cacheStatistics(MLocale::DateFormatCache);
+    MLocale::setCacheCapacity(MLocale::DateFormatCache, int(before.bytes) * 2);
+    hebrew.prepare(MLocale::PrepareDateFormats);
+    QThreadPool::globalInstance()->waitForDone();
+    QCOMPARE(hebrew.formatDateTime(dateTime, MLocale::DateLong, MLocale::TimeShort), formatted);
+    statistics = hebrew.cacheStatistics(MLocale::DateFormatCache);
+    QCOMPARE(statistics.evictions - before.evictions, qint64(0));
+    QCOMPARE(statistics.misses - before.misses, qint64(0));
+    QCOMPARE(statistics.hits - before.hits, qint64(1));
+    QVERIFY(statistics.bytes <= 2 * before.bytes);
+    MLocale::setCacheCapacity(MLocale::DateFormatCache, capacity);
+}
+
+void Ft_Locales::testSkeletonFormats()
+{
+    MLocale locale("en_US");
+    MLocale::CacheStatistics before = locale.cacheStatistics(MLocale::PatternCache);
+    QCOMPARE(locale.icuFormatStringForSkeleton("MMMd"), QString("MMM d"));
+    QCOMPARE(locale.icuFormatStringForSkeleton("MMMd"), QString("MMM d"));
+    MLocale::CacheStatistics statistics = locale.cacheStatistics(MLocale::PatternCache);
+    QCOMPARE(statistics.misses - before.misses, qint64(1));
+    QCOMPARE(statistics.hits - before.hits, qint64(1));
+    QCOMPARE(locale.cacheStatistics(MLocale::PatternGeneratorCache).entries, qint64(1));
+
+    MLocale finnish("fi_FI");
+    QCOMPARE(finnish.icuFormatStringForSkeleton("MMMd"), QString("d. MMM"));
+
+    locale.setTimeFormat24h(MLocale::TwentyFourHourTimeFormat24h);
+    QVERIFY(locale.icuFormatStringForSkeleton("jm").contains('H'));
+    locale.setTimeFormat24h(MLocale::TwelveHourTimeFormat24h);
+    QString pattern = locale.icuFormatStringForSkeleton("jm");
+    QVERIFY(pattern.contains('h'));
+    QVERIFY(!pattern.contains('H'));
+
+    const QDateTime dateTime(QDate(2008, 7, 21), QTime(14, 31, 3), Qt::LocalTime);
+    pattern = locale.icuFormatStringForSkeleton("yMMMdjm");
+    QCOMPARE(locale.formatDateTimeWithSkeleton(dateTime, "yMMMdjm"),
+             locale.formatDateTimeICU(dateTime, pattern));
+    MCalendar calendar(MLocale::GregorianCalendar);
+    calendar.setDateTime(dateTime);
+    QCOMPARE(locale.formatDateTimeWithSkeleton(calendar, "yMMMdjm"),
+             locale.formatDateTimeICU(calendar, pattern));
+}
+
 /*
  * To reduce the size of libicu, we customize the locale data included in
  * our package of libicu and include only what needs to be there.
@@ -29,6 +29,8 @@
 #include <MCalendar>
 
 #include <QCoreApplication>
+#include <QThreadPool>
+#include <QRunnable>
 
 #ifdef HAVE_ICU
 #include <unicode/unistr.h>
@@ -91,6 +93,7 @@ private slots:
     void testMLocaleLanguageEndonym();
     void testMLocaleCountryEndonym_data();
     void testMLocaleCountryEndonym();
+    void testMLocaleMetadataTable();
     void testMLocaleLocaleScripts_data();
     void testMLocaleLocaleScripts();
 
@@ -108,6 +111,17 @@ private slots:
     void testDifferentStrengthComparison_data();
     void testDifferentStrengthComparison();
 
+    void testConcurrentFormatting_data();
+    void testConcurrentFormatting();
+    void testConcurrentFirstUse_data();
+    void testConcurrentFirstUse();
+
+    void testThreadPrivatesReleased();
+    void testCacheStatistics();
+    void testSharedFormatterCaches();
+    void testPrepare();
+    void testSkeletonFormats();
+
     void checkAvailableLocales();
 };
 
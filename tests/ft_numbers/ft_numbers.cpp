@@ -3173,6 +3173,10 @@ void Ft_Numbers::testToLatinNumbers()
     debugStream.flush();
 #endif
     QCOMPARE(result, expectedResult);
+
+    QString inPlace = input;
+    MLocale::toLatinNumbers(&inPlace);
+    QCOMPARE(inPlace, expectedResult);
 }
 
 void Ft_Numbers::testToLocalizedNumbers_data()
@@ -3482,6 +3486,151 @@ void Ft_Numbers::testToLocalizedNumbers()
     debugStream.flush();
 #endif
     QCOMPARE(result, expectedResult);
+
+    QString inPlace = input;
+    locale.toLocalizedNumbers(&inPlace);
+    QCOMPARE(inPlace, expectedResult);
+    // converting again must not change anything:
+    locale.toLocalizedNumbers(&inPlace);
+    QCOMPARE(inPlace, expectedResult);
+}
+
+void Ft_Numbers::testFormatNumbers_data()
+{
+    QTest::addColumn<QString>("localeName");
+    QTest::addColumn<QString>("localeNameLcNumeric");
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("de_CH")
+        << QString("de_CH")
+        << QString("de_CH")
+        << 1;
+    QTest::newRow("de_CH threads")
+        << QString("de_CH")
+        << QString("de_CH")
+        << 4;
+    QTest::newRow("ar_EG")
+        << QString("ar")
+        << QString("ar_EG@numbers=arab")
+        << 1;
+    QTest::newRow("ar_EG threads")
+        << QString("ar")
+        << QString("ar_EG@numbers=arab")
+        << 4;
+}
+
+void Ft_Numbers::testFormatNumbers()
+{
+    QFETCH(QString, localeName);
+    QFETCH(QString, localeNameLcNumeric);
+    QFETCH(int, threads);
+    MLocale locale(localeName);
+    locale.setCategoryLocale(MLocale::MLcNumeric, localeNameLcNumeric);
+
+    // enough numbers to really split the batch between threads
+    QVector<qlonglong> longLongs;
+    QVector<int> ints;
+    QVector<double> doubles;
+    for (int i = 0; i < 5000; ++i) {
+        longLongs << qlonglong(i - 2500) * 1234567;
+        ints << (i - 2500) * 1234;
+        doubles << (i - 2500) * 12.3456789;
+    }
+
+    QVector<int> offsets;
+    QString packed = locale.formatNumbers(longLongs, &offsets, threads);
+    QCOMPARE(offsets.size(), longLongs.size() + 1);
+    QCOMPARE(offsets.last(), packed.size());
+    for (int i = 0; i < longLongs.size(); ++i)
+        QCOMPARE(packed.mid(offsets[i], offsets[i+1] - offsets[i]),
+                 locale.formatNumber(longLongs[i]));
+
+    packed = locale.formatNumbers(ints, &offsets, threads);
+    QCOMPARE(offsets.size(), ints.size() + 1);
+    for (int i = 0; i < ints.size(); ++i)
+        QCOMPARE(packed.mid(offsets[i], offsets[i+1] - offsets[i]),
+                 locale.formatNumber(ints[i]));
+
+    packed = locale.formatNumbers(doubles, &offsets, -1, 0, threads);
+    QCOMPARE(offsets.size(), doubles.size() + 1);
+    for (int i = 0; i < doubles.size(); ++i)
+        QCOMPARE(packed.mid(offsets[i], offsets[i+1] - offsets[i]),
+                 locale.formatNumber(doubles[i]));
+
+    packed = locale.formatNumbers(doubles, &offsets, 2, 2, threads);
+    for (int i = 0; i < doubles.size(); ++i)
+        QCOMPARE(packed.mid(offsets[i], offsets[i+1] - offsets[i]),
+                 locale.formatNumber(doubles[i], 2, 2));
+
+    // without offsets the result is just the concatenation:
+    QString concatenated;
+    for (int i = 0; i < longLongs.size(); ++i)
+        concatenated += locale.formatNumber(longLongs[i]);
+    QCOMPARE(locale.formatNumbers(longLongs, 0, threads), concatenated);
+}
+
+void Ft_Numbers::testParseNumbers_data()
+{
+    QTest::addColumn<QString>("localeName");
+    QTest::addColumn<QString>("localeNameLcNumeric");
+
+    QTest::newRow("de_CH")
+        << QString("de_CH")
+        << QString("de_CH");
+    QTest::newRow("fi_FI")
+        << QString("fi_FI")
+        << QString("fi_FI");
+    QTest::newRow("ar_EG")
+        << QString("ar")
+        << QString("ar_EG@numbers=arab");
+}
+
+void Ft_Numbers::testParseNumbers()
+{
+    QFETCH(QString, localeName);
+    QFETCH(QString, localeNameLcNumeric);
+    MLocale locale(localeName);
+    locale.setCategoryLocale(MLocale::MLcNumeric, localeNameLcNumeric);
+
+    QStringList integerStrings;
+    QStringList doubleStrings;
+    for (int i = 0; i < 200; ++i) {
+        integerStrings << locale.formatNumber(qlonglong(i - 100) * 1234567);
+        doubleStrings << locale.formatNumber((i - 100) * 12.25);
+    }
+    integerStrings << QString() << "foo";
+    doubleStrings << QString() << "foo";
+
+    QVector<qlonglong> integers;
+    QVector<bool> ok;
+    QCOMPARE(locale.parseNumbers(integerStrings, &integers, &ok), 200);
+    QCOMPARE(integers.size(), integerStrings.size());
+    QCOMPARE(ok.size(), integerStrings.size());
+    for (int i = 0; i < integerStrings.size(); ++i) {
+        bool expectedOk;
+        QCOMPARE(integers[i], locale.toLongLong(integerStrings[i], &expectedOk));
+        QCOMPARE(ok[i], expectedOk);
+    }
+
+    QVector<double> doubles;
+    QCOMPARE(locale.parseNumbers(doubleStrings, &doubles, &ok), 200);
+    QCOMPARE(doubles.size(), doubleStrings.size());
+    for (int i = 0; i < doubleStrings.size(); ++i) {
+        bool expectedOk;
+        QCOMPARE(doubles[i], locale.toDouble(doubleStrings[i], &expectedOk));
+        QCOMPARE(ok[i], expectedOk);
+    }
+
+    // integer parsing stops at the decimal separator, parsing
+    // doubles in between must not change that:
+    bool integerOk = true;
+    locale.toLongLong(locale.formatNumber(1.5), &integerOk);
+    QCOMPARE(integerOk, false);
+    bool doubleOk = false;
+    QCOMPARE(locale.toDouble(locale.formatNumber(1.5), &doubleOk), 1.5);
+    QCOMPARE(doubleOk, true);
+    locale.toInt(locale.formatNumber(1.5), &integerOk);
+    QCOMPARE(integerOk, false);
 }
 
 QTEST_GUILESS_MAIN(Ft_Numbers);
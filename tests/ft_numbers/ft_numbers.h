@@ -95,6 +95,12 @@ private slots:
     void testToLatinNumbers();
     void testToLocalizedNumbers_data();
     void testToLocalizedNumbers();
+
+    void testFormatNumbers_data();
+    void testFormatNumbers();
+
+    void testParseNumbers_data();
+    void testParseNumbers();
 };
 
 
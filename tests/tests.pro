@@ -11,6 +11,7 @@ SUBDIRS     =  \
     ut_translations/translations-qttrid \
     ut_phonenumberformatting \
     ut_mlocationdatabase \
+    ut_mlocaleidentifier \
 
 # enable only when we have icu available
 
@@ -2727,6 +2727,12 @@ void Ut_MCalendar::testMLocaleCalendarConversionsFromMCalendar()
                                       static_cast<MLocale::TimeType>(timeType),
                                       calType),
                 expectedResult);
+            QCOMPARE(
+                locale.formatDateTime(mcal.qDateTime(Qt::UTC).toMSecsSinceEpoch(),
+                                      static_cast<MLocale::DateType>(dateType),
+                                      static_cast<MLocale::TimeType>(timeType),
+                                      calType),
+                expectedResult);
             if (dateType == MLocale::DateLong
                 && timeType == MLocale::TimeLong) {
                 QCOMPARE(locale.formatDateTime(dateTime, calType), expectedResult);
@@ -2913,6 +2919,188 @@ void Ut_MCalendar::testWeekNumbers()
 
 }
 
+void Ut_MCalendar::testPosixAndIsoWeekNumbers_data()
+{
+    QTest::addColumn<QDate>("date");
+    QTest::addColumn<int>("sundayWeekNumber");
+    QTest::addColumn<int>("mondayWeekNumber");
+    QTest::addColumn<int>("isoWeekNumber");
+
+    // expected values as printed by “date +'%U %W %V'”
+    QTest::newRow("2008-02-03") << QDate(2008, 2, 3) << 5 << 4 << 5;
+    QTest::newRow("1995-12-26") << QDate(1995, 12, 26) << 52 << 52 << 52;
+    QTest::newRow("2010-01-01") << QDate(2010, 1, 1) << 0 << 0 << 53;
+    QTest::newRow("2008-12-29") << QDate(2008, 12, 29) << 52 << 52 << 1;
+    QTest::newRow("2012-01-01") << QDate(2012, 1, 1) << 1 << 0 << 52;
+    QTest::newRow("2004-12-31") << QDate(2004, 12, 31) << 52 << 52 << 53;
+    QTest::newRow("2005-01-02") << QDate(2005, 1, 2) << 1 << 0 << 53;
+    QTest::newRow("2009-12-31") << QDate(2009, 12, 31) << 52 << 52 << 53;
+}
+
+void Ut_MCalendar::testPosixAndIsoWeekNumbers()
+{
+    QFETCH(QDate, date);
+    QFETCH(int, sundayWeekNumber);
+    QFETCH(int, mondayWeekNumber);
+    QFETCH(int, isoWeekNumber);
+
+    MCalendar cal(MLocale::GregorianCalendar);
+    cal.setDate(date);
+    QCOMPARE(cal.weekNumberStartingFromDay(MLocale::Sunday), sundayWeekNumber);
+    QCOMPARE(cal.weekNumberStartingFromDay(MLocale::Monday), mondayWeekNumber);
+    QCOMPARE(cal.isoWeekNumber(), isoWeekNumber);
+    // must not depend on the week settings of the calendar:
+    cal.setFirstDayOfWeek(MLocale::Saturday);
+    cal.setMinimalDaysInFirstWeek(1);
+    QCOMPARE(cal.weekNumberStartingFromDay(MLocale::Sunday), sundayWeekNumber);
+    QCOMPARE(cal.isoWeekNumber(), isoWeekNumber);
+}
+
+void Ut_MCalendar::testFormatDateTimes_data()
+{
+    QTest::addColumn<QString>("localeName");
+    QTest::addColumn<MLocale::CalendarType>("calendarType");
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("fi_FI") << "fi_FI" << MLocale::GregorianCalendar << 1;
+    QTest::newRow("fi_FI threads") << "fi_FI" << MLocale::GregorianCalendar << 4;
+    QTest::newRow("ar_EG islamic") << "ar_EG" << MLocale::IslamicCalendar << 1;
+    QTest::newRow("ar_EG islamic threads") << "ar_EG" << MLocale::IslamicCalendar << 4;
+}
+
+void Ut_MCalendar::testFormatDateTimes()
+{
+    QFETCH(QString, localeName);
+    QFETCH(MLocale::CalendarType, calendarType);
+    QFETCH(int, threads);
+
+    MCalendar::setSystemTimeZone("Europe/Helsinki");
+    MLocale locale(localeName);
+
+    // enough times to really split the batch between threads,
+    // about 57 days apart, crossing DST changes
+    QVector<qint64> msecsSinceEpoch;
+    for (int i = 0; i < 2000; ++i)
+        msecsSinceEpoch << Q_INT64_C(1262304000000) + qint64(i) * Q_INT64_C(4937777777);
+
+    QVector<int> offsets;
+    QString packed = locale.formatDateTimes(msecsSinceEpoch, &offsets,
+                                            MLocale::DateMedium, MLocale::TimeShort,
+                                            calendarType, threads);
+    QCOMPARE(offsets.size(), msecsSinceEpoch.size() + 1);
+    QCOMPARE(offsets.last(), packed.size());
+    for (int i = 0; i < msecsSinceEpoch.size(); ++i)
+        QCOMPARE(packed.mid(offsets[i], offsets[i+1] - offsets[i]),
+                 locale.formatDateTime(msecsSinceEpoch[i], MLocale::DateMedium,
+                                       MLocale::TimeShort, calendarType));
+
+    QCOMPARE(locale.formatDateTimes(msecsSinceEpoch, 0, MLocale::DateNone,
+                                    MLocale::TimeNone, calendarType, threads),
+             QString());
+}
+
+void Ut_MCalendar::testIncrementalFormatting_data()
+{
+    QTest::addColumn<QString>("localeName");
+    QTest::addColumn<MLocale::CalendarType>("calendarType");
+    QTest::addColumn<QString>("timeZone");
+
+    QTest::newRow("fi_FI") << "fi_FI" << MLocale::GregorianCalendar << "Europe/Helsinki";
+    QTest::newRow("en_US") << "en_US" << MLocale::GregorianCalendar << "America/New_York";
+    QTest::newRow("ja_JP") << "ja_JP" << MLocale::GregorianCalendar << "Asia/Tokyo";
+    QTest::newRow("ar_EG islamic") << "ar_EG" << MLocale::IslamicCalendar << "Africa/Cairo";
+    QTest::newRow("he_IL") << "he_IL" << MLocale::GregorianCalendar << "Asia/Jerusalem";
+}
+
+void Ut_MCalendar::testIncrementalFormatting()
+{
+    QFETCH(QString, localeName);
+    QFETCH(MLocale::CalendarType, calendarType);
+    QFETCH(QString, timeZone);
+
+    MCalendar::setSystemTimeZone(timeZone);
+    MLocale locale(localeName);
+    MCalendar calendar(calendarType);
+
+    // the formatted dates and times come partly from the caches of
+    // the previous times, they have to be the same as if each was
+    // formatted on its own. The times are a few minutes and a few
+    // days apart, cross DST changes and go back to before 1970.
+    QVector<qint64> msecsSinceEpoch;
+    for (int i = 0; i < 400; ++i) {
+        msecsSinceEpoch << Q_INT64_C(1262304000000) + qint64(i) * Q_INT64_C(4937777777)
+                        << Q_INT64_C(1301187600000) + qint64(i) * Q_INT64_C(97000)
+                        << Q_INT64_C(-315619200000) + qint64(i) * Q_INT64_C(82800000);
+    }
+
+    for (int dateType = MLocale::DateNone; dateType <= MLocale::DateFull; ++dateType) {
+        for (int timeType = MLocale::TimeNone; timeType <= MLocale::TimeFull; ++timeType) {
+            for (int i = 0; i < msecsSinceEpoch.size(); ++i) {
+                QDateTime dateTime(QDate(1970, 1, 1), QTime(0, 0), Qt::UTC);
+                calendar.setDateTime(dateTime.addMSecs(msecsSinceEpoch[i]));
+                QCOMPARE(locale.formatDateTime(msecsSinceEpoch[i],
+                                               static_cast<MLocale::DateType>(dateType),
+                                               static_cast<MLocale::TimeType>(timeType),
+                                               calendarType),
+                         locale.formatDateTime(calendar,
+                                               static_cast<MLocale::DateType>(dateType),
+                                               static_cast<MLocale::TimeType>(timeType)));
+            }
+        }
+    }
+}
+
+void Ut_MCalendar::testDateTimeParser()
+{
+    MCalendar::setSystemTimeZone("Europe/Helsinki");
+    MLocale locale("fi_FI");
+    QDateTime dateTime(QDate(2010, 7, 13), QTime(14, 51, 0), Qt::LocalTime);
+
+    MDateTimeParser parser = locale.dateTimeParser(MLocale::GregorianCalendar);
+    QCOMPARE(parser.styleCount(), 0);
+    parser.addStyle(MLocale::DateNone, MLocale::TimeNone);
+    QCOMPARE(parser.styleCount(), 0);
+    parser.addStyle(MLocale::DateShort, MLocale::TimeShort);
+    parser.addStyle(MLocale::DateShort, MLocale::TimeNone);
+    parser.addStyle(MLocale::DateLong, MLocale::TimeNone);
+    QCOMPARE(parser.styleCount(), 3);
+
+    QStringList strings;
+    strings << locale.formatDateTime(dateTime, MLocale::DateShort, MLocale::TimeShort,
+                                     MLocale::GregorianCalendar)
+            << locale.formatDateTime(dateTime, MLocale::DateShort, MLocale::TimeNone,
+                                     MLocale::GregorianCalendar)
+            << locale.formatDateTime(dateTime, MLocale::DateLong, MLocale::TimeNone,
+                                     MLocale::GregorianCalendar)
+            << QString("no date at all");
+
+    int matchedStyle = -2;
+    QCOMPARE(parser.parse(strings.at(0), &matchedStyle), dateTime);
+    QCOMPARE(matchedStyle, 0);
+    QCOMPARE(parser.parse(strings.at(1), &matchedStyle),
+             QDateTime(dateTime.date(), QTime(0, 0), Qt::LocalTime));
+    QCOMPARE(matchedStyle, 1);
+    QCOMPARE(parser.parse(strings.at(2), &matchedStyle).date(), dateTime.date());
+    QCOMPARE(matchedStyle, 2);
+    QVERIFY(!parser.parse(strings.at(3), &matchedStyle).isValid());
+    QCOMPARE(matchedStyle, -1);
+
+    // a copy keeps working after the original is gone:
+    MDateTimeParser *original = new MDateTimeParser(parser);
+    MDateTimeParser copy(*original);
+    delete original;
+
+    QVector<QDateTime> dateTimes;
+    QVector<int> matchedStyles;
+    QCOMPARE(copy.parse(strings, &dateTimes, &matchedStyles), 3);
+    QCOMPARE(dateTimes.size(), strings.size());
+    QCOMPARE(matchedStyles.size(), strings.size());
+    for (int i = 0; i < strings.size(); ++i) {
+        QCOMPARE(dateTimes.at(i), parser.parse(strings.at(i), &matchedStyle));
+        QCOMPARE(matchedStyles.at(i), matchedStyle);
+    }
+}
+
 void Ut_MCalendar::testComparisons()
 {
     MCalendar cal1;
@@ -4965,6 +5153,7 @@ void Ut_MCalendar::testWeekdaySymbols()
 #endif
     for (int i = 1; i <= 7; ++i)
         QCOMPARE(locale.weekdayName(mcal, i), symbols.at(i-1));
+    QCOMPARE(locale.weekdayNames(mcal), symbols);
 }
 
 void Ut_MCalendar::testMonthSymbols_data()
@@ -5168,6 +5357,52 @@ void Ut_MCalendar::testMonthSymbols()
 #endif
     for (int i = 1; i <= 12; ++i)
         QCOMPARE(locale.monthName(mcal, i), symbols.at(i-1));
+    QCOMPARE(locale.monthNames(mcal).mid(0, 12), symbols.mid(0, 12));
+}
+
+void Ut_MCalendar::testProfileFollowsCategoryChanges()
+{
+    // whether month names are mixed in from lc_messages and whether
+    // date formats are embedded for another script direction is
+    // decided once per category change, check that a locale changed
+    // step by step gives the same results as a freshly created one:
+    QList<QStringList> steps;
+    steps << (QStringList() << "fi_FI" << "fi_FI")
+          << (QStringList() << "en_GB" << "fi_FI")
+          << (QStringList() << "en_GB" << "fi_FI@mix-time-and-language=no")
+          << (QStringList() << "ar_EG" << "fi_FI")
+          << (QStringList() << "ar_EG" << "ar_EG")
+          << (QStringList() << "en_GB" << "he_IL")
+          << (QStringList() << "ja_JP" << "de_DE");
+    QDateTime dateTime(QDate(2008, 7, 21), QTime(14, 31, 3), Qt::LocalTime);
+
+    MLocale locale("de_DE");
+    foreach (const QStringList &step, steps) { // krazy:exclude=foreach
+        locale.setCategoryLocale(MLocale::MLcMessages, step.at(0));
+        locale.setCategoryLocale(MLocale::MLcTime, step.at(1));
+        MLocale fresh("de_DE");
+        fresh.setCategoryLocale(MLocale::MLcMessages, step.at(0));
+        fresh.setCategoryLocale(MLocale::MLcTime, step.at(1));
+        MLocale copy(locale);
+        MLocale assigned;
+        assigned = locale;
+
+        MCalendar mcal(MLocale::GregorianCalendar);
+        QCOMPARE(locale.monthNames(mcal), fresh.monthNames(mcal));
+        QCOMPARE(locale.weekdayNames(mcal), fresh.weekdayNames(mcal));
+        QString expected = fresh.formatDateTime(dateTime, MLocale::DateFull,
+                                                MLocale::TimeFull);
+        QCOMPARE(locale.formatDateTime(dateTime, MLocale::DateFull,
+                                       MLocale::TimeFull), expected);
+        QCOMPARE(copy.formatDateTime(dateTime, MLocale::DateFull,
+                                     MLocale::TimeFull), expected);
+        QCOMPARE(assigned.formatDateTime(dateTime, MLocale::DateFull,
+                                         MLocale::TimeFull), expected);
+        QCOMPARE(locale.formatDateTime(dateTime, MLocale::DateYearAndMonth,
+                                       MLocale::TimeNone),
+                 fresh.formatDateTime(dateTime, MLocale::DateYearAndMonth,
+                                      MLocale::TimeNone));
+    }
 }
 
 void Ut_MCalendar::testDateYearAndMonth_data()
@@ -25,6 +25,7 @@
 #include <QObject>
 #include <MLocale>
 #include <MCalendar>
+#include <MDateTimeParser>
 
 #ifdef HAVE_ICU
 #include <unicode/unistr.h>
@@ -87,6 +88,13 @@ private slots:
 
     void testMCalendarAdditions();
     void testWeekNumbers();
+    void testPosixAndIsoWeekNumbers_data();
+    void testPosixAndIsoWeekNumbers();
+    void testFormatDateTimes_data();
+    void testFormatDateTimes();
+    void testIncrementalFormatting_data();
+    void testIncrementalFormatting();
+    void testDateTimeParser();
     void testComparisons();
 
     void testIslamicCalendar();
@@ -105,6 +113,7 @@ private slots:
 
     void testMonthSymbols_data();
     void testMonthSymbols();
+    void testProfileFollowsCategoryChanges();
 
     void testDateYearAndMonth_data();
     void testDateYearAndMonth();
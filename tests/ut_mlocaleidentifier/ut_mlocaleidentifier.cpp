@@ -0,0 +1,199 @@
+/***************************************************************************
+**
+** This file is part of libmlocale.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "ut_mlocaleidentifier.h"
+#include "mlocaleidentifier.h"
+
+using ML10N::MLocaleIdentifier;
+
+void Ut_MLocaleIdentifier::testParse_data()
+{
+    QTest::addColumn<QString>("localeName");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QString>("baseName");
+    QTest::addColumn<QString>("language");
+    QTest::addColumn<QString>("script");
+    QTest::addColumn<QString>("country");
+    QTest::addColumn<QString>("variant");
+    QTest::addColumn<QString>("string");
+
+    QTest::newRow("fi")
+        << "fi" << true << "fi" << "fi" << "" << "" << "" << "fi";
+    QTest::newRow("snd_Arab_AF")
+        << "snd_Arab_AF" << true << "snd_Arab_AF" << "snd" << "Arab" << "AF" << "" << "snd_Arab_AF";
+    QTest::newRow("sr_Latn_RS_REVISED")
+        << "sr_Latn_RS_REVISED" << true << "sr_Latn_RS_REVISED"
+        << "sr" << "Latn" << "RS" << "REVISED" << "sr_Latn_RS_REVISED";
+    QTest::newRow("en_US_POSIX")
+        << "en_US_POSIX" << true << "en_US_POSIX" << "en" << "" << "US" << "POSIX" << "en_US_POSIX";
+    QTest::newRow("es__TRADITIONAL")
+        << "es__TRADITIONAL" << true << "es__TRADITIONAL" << "es" << "" << "" << "TRADITIONAL"
+        << "es__TRADITIONAL";
+    QTest::newRow("es_419")
+        << "es_419" << true << "es_419" << "es" << "" << "419" << "" << "es_419";
+    // no country followed directly by letters, this is a variant:
+    QTest::newRow("de_DEU")
+        << "de_DEU" << true << "de_DEU" << "de" << "" << "" << "DEU" << "de_DEU";
+    QTest::newRow("sr_Cyrl_RS_REVISED@currency=USD;collation=phonebook;calendar=islamic-civil")
+        << "sr_Cyrl_RS_REVISED@currency=USD;collation=phonebook;calendar=islamic-civil" << true
+        << "sr_Cyrl_RS_REVISED" << "sr" << "Cyrl" << "RS" << "REVISED"
+        << "sr_Cyrl_RS_REVISED@currency=USD;collation=phonebook;calendar=islamic-civil";
+    QTest::newRow("empty")
+        << "" << false << "" << "" << "" << "" << "" << "";
+    QTest::newRow("trailing _")
+        << "en_" << false << "en_" << "" << "" << "" << "" << "en_";
+    // “_” after a country has to be followed by a variant, so this
+    // is no country but the variant “US_”:
+    QTest::newRow("trailing _ after country")
+        << "en_US_" << true << "en_US_" << "en" << "" << "" << "US_" << "en_US_";
+    QTest::newRow("language too long")
+        << "engl_US" << false << "engl_US" << "" << "" << "" << "" << "engl_US";
+    // empty keyword lists and empty keywords are dropped:
+    QTest::newRow("trailing @")
+        << "fi_FI@" << true << "fi_FI" << "fi" << "" << "FI" << "" << "fi_FI";
+    QTest::newRow("empty keywords")
+        << "fi_FI@;calendar=gregorian;;" << true << "fi_FI" << "fi" << "" << "FI" << ""
+        << "fi_FI@calendar=gregorian";
+    // the keywords of a malformed base name are kept:
+    QTest::newRow("keywords after malformed base name")
+        << "fi_@calendar=gregorian" << false << "fi_" << "" << "" << "" << ""
+        << "fi_@calendar=gregorian";
+    // case is significant and never changed, the parts have to be
+    // lower case language, title case script and upper case
+    // country and variant:
+    QTest::newRow("upper case language")
+        << "EN_US" << false << "EN_US" << "" << "" << "" << "" << "EN_US";
+    QTest::newRow("lower case country")
+        << "en_us" << false << "en_us" << "" << "" << "" << "" << "en_us";
+    QTest::newRow("lower case script")
+        << "sr_latn_RS" << false << "sr_latn_RS" << "" << "" << "" << "" << "sr_latn_RS";
+    QTest::newRow("upper case script")
+        << "sr_LATN" << true << "sr_LATN" << "sr" << "" << "" << "LATN" << "sr_LATN";
+}
+
+void Ut_MLocaleIdentifier::testParse()
+{
+    QFETCH(QString, localeName);
+    QFETCH(bool, valid);
+    QFETCH(QString, baseName);
+    QFETCH(QString, language);
+    QFETCH(QString, script);
+    QFETCH(QString, country);
+    QFETCH(QString, variant);
+    QFETCH(QString, string);
+
+    MLocaleIdentifier identifier(localeName);
+    QCOMPARE(identifier.isValid(), valid);
+    QCOMPARE(identifier.baseName(), baseName);
+    QCOMPARE(identifier.language(), language);
+    QCOMPARE(identifier.script(), script);
+    QCOMPARE(identifier.country(), country);
+    QCOMPARE(identifier.variant(), variant);
+    QCOMPARE(identifier.toString(), string);
+    // parsing the result again gives the same identifier:
+    QCOMPARE(MLocaleIdentifier(string).toString(), string);
+}
+
+void Ut_MLocaleIdentifier::testKeywords_data()
+{
+    QTest::addColumn<QString>("localeName");
+    QTest::addColumn<QString>("key");
+    QTest::addColumn<bool>("hasKeyword");
+    QTest::addColumn<QString>("value");
+
+    const QString name("fi_FI@collation=phonebook;calendar=islamic-civil;currency=EUR");
+    QTest::newRow("first") << name << "collation" << true << "phonebook";
+    QTest::newRow("middle") << name << "calendar" << true << "islamic-civil";
+    QTest::newRow("last") << name << "currency" << true << "EUR";
+    QTest::newRow("missing") << name << "numbers" << false << "";
+    QTest::newRow("prefix of a key") << name << "cal" << false << "";
+    QTest::newRow("suffix of a key") << name << "endar" << false << "";
+    QTest::newRow("value is not a key") << name << "EUR" << false << "";
+    QTest::newRow("keys are case sensitive") << name << "Calendar" << false << "";
+    QTest::newRow("no keywords") << "fi_FI" << "calendar" << false << "";
+    QTest::newRow("empty") << "" << "calendar" << false << "";
+    QTest::newRow("without value")
+        << "fi_FI@calendar;currency=EUR" << "calendar" << true << "";
+    QTest::newRow("after keyword without value")
+        << "fi_FI@calendar;currency=EUR" << "currency" << true << "EUR";
+    QTest::newRow("malformed base name")
+        << "fi_@calendar=gregorian" << "calendar" << true << "gregorian";
+}
+
+void Ut_MLocaleIdentifier::testKeywords()
+{
+    QFETCH(QString, localeName);
+    QFETCH(QString, key);
+    QFETCH(bool, hasKeyword);
+    QFETCH(QString, value);
+
+    MLocaleIdentifier identifier(localeName);
+    QCOMPARE(identifier.hasKeyword(key), hasKeyword);
+    QCOMPARE(identifier.keywordValue(key), value);
+    QCOMPARE(MLocaleIdentifier::keywordValue(localeName, key), value);
+}
+
+void Ut_MLocaleIdentifier::testSetKeywordValue()
+{
+    MLocaleIdentifier identifier("en_Latn_US_POSIX@calendar=gregorian;collation=phonebook");
+
+    // replacing keeps the position
+    identifier.setKeywordValue("calendar", "islamic");
+    QCOMPARE(identifier.toString(),
+             QString("en_Latn_US_POSIX@calendar=islamic;collation=phonebook"));
+
+    // new keywords are appended
+    identifier.setKeywordValue("currency", "EUR");
+    QCOMPARE(identifier.toString(),
+             QString("en_Latn_US_POSIX@calendar=islamic;collation=phonebook;currency=EUR"));
+    QCOMPARE(identifier.keywordValue("currency"), QString("EUR"));
+
+    // an empty value removes the keyword
+    identifier.setKeywordValue("collation", QString());
+    QCOMPARE(identifier.toString(),
+             QString("en_Latn_US_POSIX@calendar=islamic;currency=EUR"));
+    QVERIFY(!identifier.hasKeyword("collation"));
+    identifier.setKeywordValue("numbers", QString());
+    QCOMPARE(identifier.toString(),
+             QString("en_Latn_US_POSIX@calendar=islamic;currency=EUR"));
+
+    // removing the last keyword removes the “@”
+    identifier.setKeywordValue("calendar", QString());
+    identifier.setKeywordValue("currency", QString());
+    QCOMPARE(identifier.toString(), QString("en_Latn_US_POSIX"));
+
+    // the base name is unaffected
+    QVERIFY(identifier.isValid());
+    QCOMPARE(identifier.language(), QString("en"));
+    QCOMPARE(identifier.script(), QString("Latn"));
+    QCOMPARE(identifier.country(), QString("US"));
+    QCOMPARE(identifier.variant(), QString("POSIX"));
+
+    // a keyword without value gets one
+    MLocaleIdentifier withoutValue("fi_FI@calendar");
+    QCOMPARE(withoutValue.toString(), QString("fi_FI@calendar"));
+    withoutValue.setKeywordValue("calendar", "gregorian");
+    QCOMPARE(withoutValue.toString(), QString("fi_FI@calendar=gregorian"));
+}
+
+void Ut_MLocaleIdentifier::testDefaultConstructed()
+{
+    MLocaleIdentifier identifier;
+    QVERIFY(!identifier.isValid());
+    QVERIFY(identifier.baseName().isEmpty());
+    QVERIFY(identifier.toString().isEmpty());
+
+    identifier.setKeywordValue("calendar", "gregorian");
+    QCOMPARE(identifier.toString(), QString("@calendar=gregorian"));
+}
+
+QTEST_GUILESS_MAIN(Ut_MLocaleIdentifier);
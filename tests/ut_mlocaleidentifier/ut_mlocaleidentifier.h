@@ -0,0 +1,32 @@
+/***************************************************************************
+**
+** This file is part of libmlocale.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef UT_MLOCALEIDENTIFIER_H
+#define UT_MLOCALEIDENTIFIER_H
+
+#include <QtTest/QtTest>
+#include <QObject>
+
+class Ut_MLocaleIdentifier : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testParse_data();
+    void testParse();
+    void testKeywords_data();
+    void testKeywords();
+    void testSetKeywordValue();
+    void testDefaultConstructed();
+};
+
+#endif
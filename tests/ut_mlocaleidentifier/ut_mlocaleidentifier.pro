@@ -0,0 +1,13 @@
+include(../common_top.pri)
+
+TARGET = ut_mlocaleidentifier
+
+# MLocaleIdentifier is internal, compile it into the test
+TEST_SOURCES += \
+    $$MSRCDIR/mlocaleidentifier.cpp \
+
+# Input
+HEADERS += ut_mlocaleidentifier.h
+SOURCES += ut_mlocaleidentifier.cpp $$TEST_SOURCES
+
+include(../common_bot.pri)
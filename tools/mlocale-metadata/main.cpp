@@ -0,0 +1,60 @@
+/***************************************************************************
+**
+** This file is part of libmlocale.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+// Generates the locale metadata table, see MLocaleMetadataTable
+
+#include <QCoreApplication>
+#include <QStringList>
+
+#include <stdio.h>
+
+#include "mlocale.h"
+#include "mlocalemetadata.h"
+
+using ML10N::MLocale;
+using ML10N::MLocaleMetadataTable;
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    const QStringList arguments = app.arguments();
+
+    // the table is only used with the data paths it was generated
+    // with, by default these are the ones MLocale uses by default:
+    QStringList dataPaths;
+    QString fileName;
+    bool usage = false;
+    for (int i = 1; i < arguments.size(); ++i) {
+        if (arguments.at(i) == QLatin1String("--data-path") && i + 1 < arguments.size())
+            dataPaths.append(arguments.at(++i));
+        else if (fileName.isEmpty() && !arguments.at(i).startsWith(QLatin1Char('-')))
+            fileName = arguments.at(i);
+        else
+            usage = true;
+    }
+    if (usage || fileName.isEmpty()) {
+        fprintf(stderr, "usage: %s [--data-path <directory>]... <output file>\n"
+                "The data paths default to %s\n", argv[0], ML_ICUEXTRADATA_DIR);
+        return 1;
+    }
+    if (dataPaths.isEmpty())
+        dataPaths.append(QLatin1String(ML_ICUEXTRADATA_DIR));
+    MLocale::setDataPaths(dataPaths);
+
+    const QVector<MLocaleMetadataTable::Record> records = MLocaleMetadataTable::generate();
+    if (!MLocaleMetadataTable::write(fileName, records)) {
+        fprintf(stderr, "%s: cannot write %s\n", argv[0], qPrintable(fileName));
+        return 1;
+    }
+    printf("%d locales written to %s\n", records.size(), qPrintable(fileName));
+    return 0;
+}
@@ -0,0 +1,48 @@
+# for defines
+include(../../mkspecs/common.pri)
+
+MSRCDIR = $${M_SOURCE_TREE}/src
+INCLUDEPATH += \
+    . \
+    $$MSRCDIR/include \
+    $$MSRCDIR \
+
+DEPENDPATH = $$INCLUDEPATH
+QMAKE_LIBDIR += ../../lib
+
+TEMPLATE = app
+TARGET = mlocale-metadata
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += main.cpp
+
+LIBS += $$mAddLibrary(mlocale$${QT_MAJOR_VERSION})
+
+# the tool is installed to (re)generate the table where the ICU data
+# it describes is installed, e.g. when that data is updated:
+#     mlocale-metadata $$ML_ICUEXTRADATA_DIR/mlocalemetadata.bin
+target.path = $$ML_INSTALL_BIN
+INSTALLS += target
+
+# Generating the table at build time runs the tool just built with
+# the ICU library and data of the build host. That works only for
+# native builds on a host with the same ICU data as the target, so
+# it is optional, enable it with “CONFIG+=mlocale_metadata”. The rpm
+# package generates the table on the target in %post instead.
+mlocale_metadata:!cross_compile {
+    METADATA_TABLE = $$OUT_PWD/mlocalemetadata.bin
+    metadata.target = $$METADATA_TABLE
+    metadata.commands = LD_LIBRARY_PATH=$$OUT_PWD/../../lib:$$(LD_LIBRARY_PATH) \
+                        $$OUT_PWD/$$TARGET --data-path $$ML_ICUEXTRADATA_DIR $$METADATA_TABLE
+    metadata.depends = $$TARGET
+    QMAKE_EXTRA_TARGETS += metadata
+    QMAKE_CLEAN += $$METADATA_TABLE
+
+    install_metadata.path = $$ML_ICUEXTRADATA_DIR
+    install_metadata.files = $$METADATA_TABLE
+    install_metadata.depends = $$METADATA_TABLE
+    install_metadata.CONFIG += no_check_exist
+    INSTALLS += install_metadata
+}
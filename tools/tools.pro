@@ -0,0 +1,8 @@
+TEMPLATE    = subdirs
+
+include(../mkspecs/common.pri)
+
+contains(DEFINES, HAVE_ICU) {
+SUBDIRS += \
+ mlocale-metadata
+}